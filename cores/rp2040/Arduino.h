@@ -32,6 +32,8 @@
 #include <pins_arduino.h>
 #include <hardware/gpio.h> // Required for the port*Register macros
 #include "debug_internal.h"
+#include "Trace.h"
+#include "LockStats.h"
 
 // Chip sanity checking.  SDK uses interesting way of separating 2350A from 2350B, see https://github.com/raspberrypi/pico-sdk/issues/2364
 #if (!defined(PICO_RP2040) && !defined(PICO_RP2350)) || defined(PICO_RP2040) && defined(PICO_RP2350)
@@ -79,6 +81,9 @@ void *pcalloc(size_t count, size_t size);
 [[deprecated("This chip does not have PSRAM, pmalloc will always fail")]] void *pmalloc(size_t size);
 [[deprecated("This chip does not have PSRAM, pcalloc will always fail")]] void *pcalloc(size_t count, size_t size);
 #endif
+// Always allocate from internal SRAM, ignoring any PSRAM placement policy
+void *smalloc(size_t size);
+void *scalloc(size_t count, size_t size);
 
 // AVR compatibility macros...naughty and accesses the HW directly
 #define digitalPinToPort(pin)       (0)
@@ -136,6 +141,7 @@ extern const String emptyString;
 #endif
 
 #include "SerialUART.h"
+#include "HeapSelect.h"
 #include "SerialSemi.h"
 #include "RP2040Support.h"
 #include "SerialPIO.h"
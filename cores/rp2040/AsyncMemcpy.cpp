@@ -0,0 +1,284 @@
+/*
+    Asynchronous DMA memcpy/memset engine
+
+    Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "AsyncMemcpy.h"
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+#include <hardware/sync.h>
+
+AsyncMemcpy asyncMemcpy;
+AsyncMemcpy *AsyncMemcpy::_instances = nullptr;
+
+// Largest TRANS_COUNT usable on both chips (RP2350 uses the top 4 bits as a mode)
+static constexpr uint32_t __maxCount = 0x0fffffff;
+
+AsyncMemcpy::AsyncMemcpy() {
+    /* noop, channels are claimed on first use */
+}
+
+AsyncMemcpy::~AsyncMemcpy() {
+    if (_dataCh >= 0) {
+        dma_channel_set_irq1_enabled(_dataCh, false);
+        uint32_t save = save_and_disable_interrupts();
+        AsyncMemcpy **p = &_instances;
+        while (*p != this) {
+            p = &(*p)->_next;
+        }
+        *p = _next;
+        restore_interrupts(save);
+        if (!_instances) {
+            irq_remove_handler(DMA_IRQ_1, _irq);
+        }
+        dma_channel_abort(_ctrlCh);
+        dma_channel_abort(_dataCh);
+        dma_channel_unclaim(_ctrlCh);
+        dma_channel_unclaim(_dataCh);
+        spin_lock_unclaim(spin_lock_get_num(_lock));
+    }
+}
+
+bool AsyncMemcpy::_begin() {
+    if (_dataCh >= 0) {
+        return true;
+    }
+    _dataCh = dma_claim_unused_channel(false);
+    if (_dataCh < 0) {
+        return false;
+    }
+    _ctrlCh = dma_claim_unused_channel(false);
+    if (_ctrlCh < 0) {
+        dma_channel_unclaim(_dataCh);
+        _dataCh = -1;
+        return false;
+    }
+    _lock = spin_lock_instance(spin_lock_claim_unused(true));
+
+    // The control channel copies one 4-word Block into the data channel's
+    // alias 1 registers, the last write (TRANS_COUNT_TRIG) triggering it.  When
+    // the data channel finishes it chains back to the control channel for the
+    // next Block.
+    dma_channel_config c = dma_channel_get_default_config(_ctrlCh);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, 4); // Wrap the 16-byte register window
+    dma_channel_configure(_ctrlCh, &c, &dma_hw->ch[_dataCh].al1_ctrl, nullptr, 4, false);
+
+    // The terminating Block has a zero count, a null trigger which with
+    // IRQ_QUIET raises the data channel's IRQ to say the whole chain is done.
+    // One handler serves all instances, only the first one installs it.
+    uint32_t save = save_and_disable_interrupts();
+    bool first = !_instances;
+    _next = _instances;
+    _instances = this;
+    restore_interrupts(save);
+    if (first) {
+        irq_add_shared_handler(DMA_IRQ_1, _irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    }
+    irq_set_enabled(DMA_IRQ_1, true);
+    dma_channel_set_irq1_enabled(_dataCh, true);
+    return true;
+}
+
+uint32_t AsyncMemcpy::_ctrl(enum dma_channel_transfer_size size, bool incRead) {
+    dma_channel_config c = dma_channel_get_default_config(_dataCh);
+    channel_config_set_transfer_data_size(&c, size);
+    channel_config_set_read_increment(&c, incRead);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_chain_to(&c, _ctrlCh);
+    channel_config_set_irq_quiet(&c, true);
+    return channel_config_get_ctrl_value(&c);
+}
+
+// Close a chain with a zero-length Block
+void AsyncMemcpy::_terminate(Block *b) {
+    b->ctrl = _ctrl(DMA_SIZE_8, false);
+    b->read = nullptr;
+    b->write = nullptr;
+    b->count = 0;
+}
+
+// Build the Blocks for one contiguous transfer, returning how many were
+// (or with b == nullptr, would be) needed
+size_t AsyncMemcpy::_segment(Block *b, void *dest, const void *src, size_t n, bool incRead) {
+    uint32_t d = (uint32_t)dest;
+    uint32_t s = (uint32_t)src;
+    // Widest unit where both sides can become aligned at the same time
+    uint32_t unit = 4;
+    if (incRead) {
+        if ((d ^ s) & 1) {
+            unit = 1;
+        } else if ((d ^ s) & 2) {
+            unit = 2;
+        }
+    }
+    size_t head = (unit - (d & (unit - 1))) & (unit - 1);
+    if (head > n) {
+        head = n;
+    }
+    size_t units = (n - head) / unit;
+    size_t tail = n - head - units * unit;
+
+    size_t cnt = 0;
+    auto add = [&](size_t bytes, uint32_t sz, enum dma_channel_transfer_size dsz) {
+        while (bytes) {
+            size_t xfer = bytes / sz;
+            if (xfer > __maxCount) {
+                xfer = __maxCount;
+            }
+            if (b) {
+                b[cnt].ctrl = _ctrl(dsz, incRead);
+                b[cnt].read = (const volatile void *)s;
+                b[cnt].write = (volatile void *)d;
+                b[cnt].count = xfer;
+            }
+            cnt++;
+            d += xfer * sz;
+            if (incRead) {
+                s += xfer * sz;
+            }
+            bytes -= xfer * sz;
+        }
+    };
+    add(head, 1, DMA_SIZE_8);
+    add(units * unit, unit, unit == 4 ? DMA_SIZE_32 : (unit == 2 ? DMA_SIZE_16 : DMA_SIZE_8));
+    add(tail, 1, DMA_SIZE_8);
+    return cnt;
+}
+
+// Wait for a free request slot and make sure it has room for the Blocks
+AsyncMemcpy::Request *AsyncMemcpy::_reserve(size_t blocks) {
+    if (!_begin()) {
+        return nullptr;
+    }
+    while ((int)(_tail - _head) >= _slots) {
+        tight_loop_contents(); // Wait for the IRQ to retire one
+    }
+    Request *r = &_req[_tail % _slots];
+    // Only the app ever frees these, never the IRQ
+    if (r->blocks && (r->blocks != r->inlineBlocks)) {
+        free(r->blocks);
+    }
+    r->blocks = r->inlineBlocks;
+    if (blocks > sizeof(r->inlineBlocks) / sizeof(r->inlineBlocks[0])) {
+        r->blocks = (Block *)smalloc(blocks * sizeof(Block)); // DMA reads these
+    }
+    return r->blocks ? r : nullptr;
+}
+
+uint32_t AsyncMemcpy::_submit(Request *r, callback_t cb, void *param) {
+    r->cb = cb;
+    r->param = param;
+    __compiler_memory_barrier(); // Blocks must be in memory before the DMA sees them
+    uint32_t save = spin_lock_blocking(_lock);
+    r->id = ++_tail;
+    uint32_t id = r->id;
+    if (!_running) {
+        _start();
+    }
+    spin_unlock(_lock, save);
+    return id;
+}
+
+// Kick off the request at _head, _lock must be held
+void AsyncMemcpy::_start() {
+    _running = true;
+    dma_channel_set_read_addr(_ctrlCh, _req[_head % _slots].blocks, true);
+}
+
+uint32_t AsyncMemcpy::copy(void *dest, const void *src, size_t n, callback_t cb, void *param) {
+    sg_t one = { dest, src, n };
+    return copy(&one, 1, cb, param);
+}
+
+uint32_t AsyncMemcpy::copy(const sg_t *list, size_t cnt, callback_t cb, void *param) {
+    size_t blocks = 1; // Terminator
+    for (size_t i = 0; i < cnt; i++) {
+        blocks += _segment(nullptr, list[i].dest, list[i].src, list[i].len, true);
+    }
+    Request *r = _reserve(blocks);
+    if (!r) {
+        return 0;
+    }
+    Block *b = r->blocks;
+    for (size_t i = 0; i < cnt; i++) {
+        b += _segment(b, list[i].dest, list[i].src, list[i].len, true);
+    }
+    _terminate(b);
+    return _submit(r, cb, param);
+}
+
+uint32_t AsyncMemcpy::fill(void *dest, uint8_t val, size_t n, callback_t cb, void *param) {
+    Request *r = _reserve(_segment(nullptr, dest, nullptr, n, false) + 1);
+    if (!r) {
+        return 0;
+    }
+    r->fillWord = val * 0x01010101;
+    Block *b = r->blocks;
+    b += _segment(b, dest, &r->fillWord, n, false);
+    _terminate(b);
+    return _submit(r, cb, param);
+}
+
+bool AsyncMemcpy::done(uint32_t id) {
+    return (int32_t)(_completed - id) >= 0;
+}
+
+void AsyncMemcpy::wait(uint32_t id) {
+    while (!done(id)) {
+        tight_loop_contents();
+    }
+}
+
+int AsyncMemcpy::pending() {
+    return _tail - _head;
+}
+
+void __not_in_flash_func(AsyncMemcpy::_handleIRQ)() {
+    if (!dma_channel_get_irq1_status(_dataCh)) {
+        return;
+    }
+    dma_channel_acknowledge_irq1(_dataCh);
+    TRACE_EVENT(TRACE_DMA_DONE, _dataCh);
+    uint32_t save = spin_lock_blocking(_lock);
+    Request *r = &_req[_head % _slots];
+    callback_t cb = r->cb;
+    void *param = r->param;
+    _completed = r->id;
+    _head = _head + 1; // ++ on a volatile is deprecated in C++20
+    if (_head != _tail) {
+        _start();
+    } else {
+        _running = false;
+    }
+    spin_unlock(_lock, save);
+    if (cb) {
+        cb(param);
+    }
+}
+
+void __not_in_flash_func(AsyncMemcpy::_irq)() {
+    TRACE_EVENT(TRACE_IRQ_ENTER, DMA_IRQ_1);
+    // Each instance only acts if its own channel raised the IRQ
+    for (AsyncMemcpy *m = _instances; m; m = m->_next) {
+        m->_handleIRQ();
+    }
+    TRACE_EVENT(TRACE_IRQ_EXIT, DMA_IRQ_1);
+}
@@ -0,0 +1,107 @@
+/*
+    Asynchronous DMA memcpy/memset engine
+
+    Queues copy, fill, and scatter-gather requests and runs each one as a
+    chain of DMA control blocks so the CPU is free while data moves.  Any
+    alignment and length is supported, the aligned middle of a transfer
+    uses the widest DMA size both sides allow and only the ends go byte by
+    byte.
+
+    Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <hardware/dma.h>
+
+class AsyncMemcpy {
+public:
+    // Called from the DMA IRQ when a request completes
+    typedef void (*callback_t)(void *param);
+
+    // One scatter-gather element
+    typedef struct {
+        void *dest;
+        const void *src;
+        size_t len;
+    } sg_t;
+
+    AsyncMemcpy();
+    ~AsyncMemcpy();
+
+    // The global asyncMemcpy is normally all that's needed, but more instances
+    // each claim their own pair of channels and run in parallel with it.
+    // Each call returns a request ID for done()/wait(), or 0 on error.
+    // If the request queue is full the call waits for a free slot.  Requests
+    // should only be submitted from one core (and not from a callback).
+    uint32_t copy(void *dest, const void *src, size_t n, callback_t cb = nullptr, void *param = nullptr);
+    uint32_t fill(void *dest, uint8_t val, size_t n, callback_t cb = nullptr, void *param = nullptr);
+    uint32_t copy(const sg_t *list, size_t cnt, callback_t cb = nullptr, void *param = nullptr);
+
+    // Has the request (and all requests before it) finished?
+    bool done(uint32_t id);
+    // Busy-wait for a request to finish
+    void wait(uint32_t id);
+    // Requests queued or in progress
+    int pending();
+
+private:
+    // Layout matches the DMA channel alias 1 registers so the control channel
+    // can write a whole block in one 4-word burst, triggering on TRANS_COUNT_TRIG
+    typedef struct {
+        uint32_t ctrl;
+        const volatile void *read;
+        volatile void *write;
+        uint32_t count;
+    } Block;
+
+    typedef struct {
+        uint32_t id;
+        callback_t cb;
+        void *param;
+        uint32_t fillWord;  // Fill source, the pattern replicated to 32 bits
+        Block *blocks;
+        Block inlineBlocks[4]; // Enough for a single head/middle/tail + terminator
+    } Request;
+
+    bool _begin();
+    uint32_t _ctrl(enum dma_channel_transfer_size size, bool incRead);
+    void _terminate(Block *b);
+    size_t _segment(Block *b, void *dest, const void *src, size_t n, bool incRead);
+    Request *_reserve(size_t blocks);
+    uint32_t _submit(Request *r, callback_t cb, void *param);
+    void _start();
+    void _handleIRQ();
+    static void _irq();
+
+    static constexpr int _slots = 8;
+    Request _req[_slots];
+    volatile uint32_t _head = 0; // Next request to complete, advanced by the IRQ
+    uint32_t _tail = 0; // Next free request slot
+    volatile uint32_t _completed = 0;
+    bool _running = false;
+    int _dataCh = -1;
+    int _ctrlCh = -1;
+    spin_lock_t *_lock = nullptr;
+
+    // Every instance with claimed channels, the shared IRQ handler checks each one
+    static AsyncMemcpy *_instances;
+    AsyncMemcpy *_next = nullptr;
+};
+
+extern AsyncMemcpy asyncMemcpy;
@@ -23,11 +23,14 @@
 
 #include "Arduino.h"
 #include "CoreMutex.h"
+#include "LockStats.h"
 
 CoreMutex::CoreMutex(mutex_t *mutex, uint8_t option) {
     _mutex = mutex;
     _acquired = false;
     _option = option;
+    uint32_t start = lock_stats ? __lockStatsNow() : 0;
+    bool contended = false;
 #ifdef __FREERTOS
     _pxHigherPriorityTaskWoken = 0; // pdFALSE
     auto m = __get_freertos_mutex_for_ptr(mutex);
@@ -39,7 +42,11 @@ CoreMutex::CoreMutex(mutex_t *mutex, uint8_t option) {
         // At this point we have the mutex in ISR
     } else {
         // Grab the mutex normally, possibly waking other tasks to get it
-        xSemaphoreTake(m, portMAX_DELAY);
+        if (!xSemaphoreTake(m, 0)) {
+            contended = true;
+            TRACE_EVENT(TRACE_MUTEX_WAIT, mutex);
+            xSemaphoreTake(m, portMAX_DELAY);
+        }
     }
 #else
     uint32_t owner;
@@ -50,14 +57,24 @@ CoreMutex::CoreMutex(mutex_t *mutex, uint8_t option) {
             }
             return;
         }
+        contended = true;
+        TRACE_EVENT(TRACE_MUTEX_WAIT, mutex);
         mutex_enter_blocking(_mutex);
     }
 #endif
     _acquired = true;
+    TRACE_EVENT(TRACE_MUTEX_ACQUIRE, mutex);
+    if (lock_stats) {
+        __lockStatsAcquired(mutex, start, contended);
+    }
 }
 
 CoreMutex::~CoreMutex() {
     if (_acquired) {
+        TRACE_EVENT(TRACE_MUTEX_RELEASE, _mutex);
+        if (lock_stats) {
+            __lockStatsReleased(_mutex);
+        }
 #ifdef __FREERTOS
         auto m = __get_freertos_mutex_for_ptr(_mutex);
         if (portCHECK_IF_IN_ISR()) {
@@ -0,0 +1,68 @@
+/*
+    Heap tier (SRAM/PSRAM) selection and statistics
+
+    Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+// Counts of where the placement policy sent allocations
+typedef struct {
+    uint32_t psramPlaced;    // Went to PSRAM because of size threshold or HeapSelectPSRAM
+    uint32_t sramFallbacks;  // Wanted PSRAM, but it was full so went to SRAM
+    uint32_t psramFallbacks; // SRAM was full, so went to PSRAM
+    uint32_t failures;       // Neither tier could satisfy the request
+} HeapTierStats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void getHeapTierStats(HeapTierStats *stats);
+#ifdef __cplusplus
+}
+
+typedef enum {
+    HEAP_DEFAULT = 0, // Use the sketch's placement policy
+    HEAP_SRAM,        // Only internal SRAM, i.e. for DMA or speed-critical buffers
+    HEAP_PSRAM        // Prefer PSRAM, falling back to SRAM
+} HeapTier;
+
+// While in scope, all malloc/new on this core go to the selected tier.
+// Under FreeRTOS, other tasks on the same core which run while one of
+// these is in scope will also see the selection.
+class HeapSelect {
+public:
+    HeapSelect(HeapTier tier);
+    ~HeapSelect();
+
+private:
+    uint8_t _core;
+    uint8_t _prev;
+};
+
+class HeapSelectSRAM : public HeapSelect {
+public:
+    HeapSelectSRAM() : HeapSelect(HEAP_SRAM) { }
+};
+
+class HeapSelectPSRAM : public HeapSelect {
+public:
+    HeapSelectPSRAM() : HeapSelect(HEAP_PSRAM) { }
+};
+#endif
@@ -0,0 +1,205 @@
+/*
+    Lock contention and hold-time statistics
+
+    Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <Arduino.h>
+#include <pico/mutex.h>
+#include <hardware/sync.h>
+#include "LockStats.h"
+#include "_cyclecount.h"
+
+bool lock_stats __attribute__((weak)) = false;
+
+typedef struct {
+    const void *lock;
+    const char *name;
+    uint32_t acquired;
+    uint32_t contended;
+    uint32_t maxWait;
+    uint64_t totalWait;
+    uint32_t maxHold;
+    uint32_t holdStart;
+    uint32_t depth;     // Recursive acquisitions by the current owner
+} LockStat;
+
+static LockStat __lockStat[LOCKSTATS_ENTRIES];
+static uint32_t __lockStatDropped;
+
+// The newlib locks from lock.cpp
+extern recursive_mutex_t __lock___sinit_recursive_mutex;
+extern recursive_mutex_t __lock___sfp_recursive_mutex;
+extern recursive_mutex_t __lock___atexit_recursive_mutex;
+extern mutex_t __lock___at_quick_exit_mutex;
+extern recursive_mutex_t __lock___malloc_recursive_mutex;
+extern recursive_mutex_t __lock___env_recursive_mutex;
+extern mutex_t __lock___tz_mutex;
+extern mutex_t __lock___dd_hash_mutex;
+extern mutex_t __lock___arc4random_mutex;
+
+static const char *__lockStatsDefaultName(const void *lock) {
+    static const struct {
+        const void *lock;
+        const char *name;
+    } names[] = {
+        { &__lock___sinit_recursive_mutex, "newlib sinit" },
+        { &__lock___sfp_recursive_mutex, "newlib stdio" },
+        { &__lock___atexit_recursive_mutex, "newlib atexit" },
+        { &__lock___at_quick_exit_mutex, "newlib at_quick_exit" },
+        { &__lock___malloc_recursive_mutex, "malloc" },
+        { &__lock___env_recursive_mutex, "newlib env" },
+        { &__lock___tz_mutex, "newlib tz" },
+        { &__lock___dd_hash_mutex, "newlib dd_hash" },
+        { &__lock___arc4random_mutex, "newlib arc4random" },
+    };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (names[i].lock == lock) {
+            return names[i].name;
+        }
+    }
+    return nullptr;
+}
+
+// Mutexes themselves use the striped spinlocks only inside their own calls,
+// never while one of these hooks runs, so borrowing one here can't deadlock
+static inline spin_lock_t *__lockStatsSpinlock() {
+    return spin_lock_instance(PICO_SPINLOCK_ID_STRIPED_FIRST);
+}
+
+// Find or add the entry for a lock, spinlock must be held
+static LockStat *__lockStatsFind(const void *lock) {
+    uint32_t h = ((uint32_t)lock >> 2) % LOCKSTATS_ENTRIES;
+    for (int i = 0; i < LOCKSTATS_ENTRIES; i++) {
+        LockStat *s = &__lockStat[(h + i) % LOCKSTATS_ENTRIES];
+        if (s->lock == lock) {
+            return s;
+        } else if (!s->lock) {
+            s->lock = lock;
+            s->name = __lockStatsDefaultName(lock);
+            return s;
+        }
+    }
+    return nullptr;
+}
+
+extern "C" uint32_t __not_in_flash_func(__lockStatsNow)() {
+    return __cycleCount();
+}
+
+extern "C" void __not_in_flash_func(__lockStatsAcquired)(const void *lock, uint32_t start, bool contended) {
+    uint32_t now = __cycleCount();
+    uint32_t wait = now - start;
+    uint32_t save = spin_lock_blocking(__lockStatsSpinlock());
+    LockStat *s = __lockStatsFind(lock);
+    if (s) {
+        s->acquired++;
+        if (contended || (wait > LOCK_STATS_CONTENDED_CYCLES)) {
+            s->contended++;
+        }
+        s->totalWait += wait;
+        if (wait > s->maxWait) {
+            s->maxWait = wait;
+        }
+        if (!s->depth++) {
+            s->holdStart = now;
+        }
+    } else {
+        __lockStatDropped++;
+    }
+    spin_unlock(__lockStatsSpinlock(), save);
+}
+
+extern "C" void __not_in_flash_func(__lockStatsReleased)(const void *lock) {
+    uint32_t now = __cycleCount();
+    uint32_t save = spin_lock_blocking(__lockStatsSpinlock());
+    LockStat *s = __lockStatsFind(lock);
+    // A release without a tracked acquisition is ignored
+    if (s && s->depth && !--s->depth) {
+        uint32_t hold = now - s->holdStart;
+        if (hold > s->maxHold) {
+            s->maxHold = hold;
+        }
+    }
+    spin_unlock(__lockStatsSpinlock(), save);
+}
+
+extern "C" void lockStatsName(const void *lock, const char *name) {
+    uint32_t save = spin_lock_blocking(__lockStatsSpinlock());
+    LockStat *s = __lockStatsFind(lock);
+    if (s) {
+        s->name = name;
+    }
+    spin_unlock(__lockStatsSpinlock(), save);
+}
+
+extern "C" void lockStatsReset() {
+    uint32_t save = spin_lock_blocking(__lockStatsSpinlock());
+    for (int i = 0; i < LOCKSTATS_ENTRIES; i++) {
+        LockStat *s = &__lockStat[i];
+        // Keep the lock, name, and current hold state so in-progress holds still balance
+        s->acquired = 0;
+        s->contended = 0;
+        s->maxWait = 0;
+        s->totalWait = 0;
+        s->maxHold = 0;
+    }
+    __lockStatDropped = 0;
+    spin_unlock(__lockStatsSpinlock(), save);
+}
+
+void lockStatsDump(Print &p) {
+    if (!lock_stats) {
+        p.printf("Lock statistics disabled, add \"bool lock_stats = true;\" to the sketch\n");
+        return;
+    }
+    // Snapshot first, printing will itself take locks
+    LockStat snap[LOCKSTATS_ENTRIES];
+    uint32_t save = spin_lock_blocking(__lockStatsSpinlock());
+    memcpy(snap, __lockStat, sizeof(snap));
+    uint32_t dropped = __lockStatDropped;
+    spin_unlock(__lockStatsSpinlock(), save);
+
+    // Insertion sort by total wait, largest first
+    int cnt = 0;
+    for (int i = 0; i < LOCKSTATS_ENTRIES; i++) {
+        if (!snap[i].lock || !snap[i].acquired) {
+            continue;
+        }
+        LockStat t = snap[i];
+        int j = cnt++;
+        while ((j > 0) && (snap[j - 1].totalWait < t.totalWait)) {
+            snap[j] = snap[j - 1];
+            j--;
+        }
+        snap[j] = t;
+    }
+
+    p.printf("%-22s %10s %10s %10s %12s %10s\n", "Lock (cycles)", "Acquired", "Contended", "Max wait", "Total wait", "Max hold");
+    for (int i = 0; i < cnt; i++) {
+        char addr[16];
+        const char *name = snap[i].name;
+        if (!name) {
+            snprintf(addr, sizeof(addr), "%p", snap[i].lock);
+            name = addr;
+        }
+        p.printf("%-22s %10lu %10lu %10lu %12llu %10lu\n", name, snap[i].acquired, snap[i].contended, snap[i].maxWait, snap[i].totalWait, snap[i].maxHold);
+    }
+    if (dropped) {
+        p.printf("%lu acquisitions of untracked locks, increase LOCKSTATS_ENTRIES\n", dropped);
+    }
+}
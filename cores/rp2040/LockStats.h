@@ -0,0 +1,68 @@
+/*
+    Lock contention and hold-time statistics
+
+    When the sketch defines "bool lock_stats = true;" every CoreMutex, newlib
+    lock (malloc, stdio, ...), and the lwIP lock records how often it is
+    taken, how often a caller had to wait for it, and the longest and total
+    wait and longest hold times in CPU cycles.
+
+    Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Number of distinct locks tracked, later ones are counted as dropped
+#ifndef LOCKSTATS_ENTRIES
+#define LOCKSTATS_ENTRIES 32
+#endif
+
+// An acquisition that waited longer than this many cycles counts as contended,
+// even if the lock has no try call to tell us directly.  An uncontended take,
+// including the stats call overhead, is well under this.
+#ifndef LOCK_STATS_CONTENDED_CYCLES
+#define LOCK_STATS_CONTENDED_CYCLES 500
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Weak, override with "bool lock_stats = true;" in the sketch.  Must not be
+// changed at runtime.
+extern bool lock_stats;
+
+// Internal hooks for the lock implementations.  Pass contended when a try
+// failed, waits over LOCK_STATS_CONTENDED_CYCLES are counted either way.
+uint32_t __lockStatsNow();
+void __lockStatsAcquired(const void *lock, uint32_t start, bool contended);
+void __lockStatsReleased(const void *lock);
+
+// Give a lock a readable name in the report
+void lockStatsName(const void *lock, const char *name);
+// Zero all counters
+void lockStatsReset();
+
+#ifdef __cplusplus
+}
+
+class Print;
+// Print all locks, most total wait time first
+void lockStatsDump(Print &p);
+#endif
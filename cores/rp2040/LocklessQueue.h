@@ -6,6 +6,11 @@
     there is only one ctx which always writes, and another which always
     reads (like a serial port SW FIFO coming off of a HW FIFO).
 
+    Bulk read/write calls move multiple elements with a single index update,
+    and the reserve/commit and peek/consume pairs expose contiguous regions
+    of the ring so DMA or memcpy can fill or drain it in place.  When the
+    size is a power of two, index wrapping is done with a mask.
+
     Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
 
     This library is free software; you can redistribute it and/or
@@ -25,6 +30,8 @@
 
 #pragma once
 
+#include <string.h>
+
 template <typename T>
 class LocklessQueue {
 public:
@@ -33,6 +40,7 @@ public:
         _writer = 0;
         _reader = 0;
         _fifoSize = size;
+        _mask = ((size & (size - 1)) == 0) ? size - 1 : 0; // Power of 2 sizes can use a simple AND to wrap
     }
 
     ~LocklessQueue() {
@@ -42,19 +50,22 @@ public:
     // How many elements we can read
     int available() {
         // Do MOD without division
-        size_t s = _fifoSize + _writer - _reader;
-        while (s >= _fifoSize) {
-            s -= _fifoSize;
+        if (_mask) {
+            return (_writer - _reader) & _mask;
         }
-        return s;
+        auto w = _writer;
+        auto r = _reader;
+        return (w >= r) ? w - r : _fifoSize + w - r;
+    }
+
+    // How many elements we can write (one slot is always left empty)
+    int availableForWrite() {
+        return _fifoSize - 1 - available();
     }
 
     // Store an element
     bool write(T val) {
-        auto next_writer = _writer + 1;
-        if (next_writer == _fifoSize) {
-            next_writer = 0;
-        }
+        auto next_writer = _advance(_writer, 1);
         if (next_writer != _reader) {
             _queue[_writer] = val;
             asm volatile("" ::: "memory"); // Ensure the queue is written before the written count advances
@@ -64,6 +75,49 @@ public:
         return false;
     }
 
+    // Store up to len elements, returning how many were actually written
+    size_t write(const T *src, size_t len) {
+        size_t cnt = 0;
+        while (cnt < len) {
+            T *dst;
+            size_t room = reserve(&dst);
+            if (!room) {
+                break;
+            }
+            if (room > len - cnt) {
+                room = len - cnt;
+            }
+            memcpy(dst, src + cnt, room * sizeof(T));
+            commit(room);
+            cnt += room;
+        }
+        return cnt;
+    }
+
+    // Get a pointer to the largest contiguous free region, returning its length.
+    // Fill it in and then call commit() with the number of elements stored.
+    size_t reserve(T **dst) {
+        auto w = _writer;
+        auto r = _reader;
+        size_t room;
+        if (w >= r) {
+            room = _fifoSize - w;
+            if (r == 0) {
+                room--; // Can't wrap onto the reader
+            }
+        } else {
+            room = r - w - 1;
+        }
+        *dst = &_queue[w];
+        return room;
+    }
+
+    // Publish elements previously placed in the reserve()d region
+    void commit(size_t cnt) {
+        asm volatile("" ::: "memory"); // Ensure the queue is written before the written count advances
+        _writer = _advance(_writer, cnt);
+    }
+
     // Examine next element to read
     bool peek(T *val) {
         if (_writer == _reader) {
@@ -73,6 +127,22 @@ public:
         return true;
     }
 
+    // Get a pointer to the largest contiguous readable region, returning its length.
+    // Once processed, call consume() to release the elements back to the writer.
+    size_t peek(const T **src) {
+        auto w = _writer;
+        auto r = _reader;
+        asm volatile("" ::: "memory"); // Ensure the writer index is sampled before any data is read
+        *src = &_queue[r];
+        return (w >= r) ? w - r : _fifoSize - r;
+    }
+
+    // Release elements returned from peek(const T**)
+    void consume(size_t cnt) {
+        asm volatile("" ::: "memory"); // Ensure the values are read before advancing
+        _reader = _advance(_reader, cnt);
+    }
+
     // Are there no elements left?
     bool empty() {
         return _writer == _reader;
@@ -85,24 +155,52 @@ public:
         }
         auto ret = _queue[_reader];
         asm volatile("" ::: "memory"); // Ensure the value is read before advancing
-        auto next_reader = _reader + 1;
-        if (next_reader == _fifoSize) {
-            next_reader = 0;
-        }
+        auto next_reader = _advance(_reader, 1);
         asm volatile("" ::: "memory"); // Ensure the reader value is only written once, correctly
         _reader = next_reader;
         *dst = ret;
         return true;
     }
 
+    // Read up to len elements, returning how many were actually read
+    size_t read(T *dst, size_t len) {
+        size_t cnt = 0;
+        while (cnt < len) {
+            const T *src;
+            size_t avail = peek(&src);
+            if (!avail) {
+                break;
+            }
+            if (avail > len - cnt) {
+                avail = len - cnt;
+            }
+            memcpy(dst + cnt, src, avail * sizeof(T));
+            consume(avail);
+            cnt += avail;
+        }
+        return cnt;
+    }
+
     void reset() {
         _writer = 0;
         _reader = 0;
     }
 
 private:
-    uint32_t _writer;   // Must be atomic writable, so 32b
-    uint32_t _reader;   // Must be atomic writable, so 32b
+    inline uint32_t _advance(uint32_t idx, size_t cnt) {
+        if (_mask) {
+            return (idx + cnt) & _mask;
+        }
+        idx += cnt;
+        if (idx >= _fifoSize) {
+            idx -= _fifoSize;
+        }
+        return idx;
+    }
+
+    volatile uint32_t _writer;   // Must be atomic writable, so 32b
+    volatile uint32_t _reader;   // Must be atomic writable, so 32b
     size_t   _fifoSize; // # of elements
+    size_t   _mask;     // _fifoSize - 1 when _fifoSize is a power of 2, else 0
     T       *_queue;    // Actual data
 };
@@ -0,0 +1,187 @@
+/*
+    Multiple producer, multiple consumer fixed-size queue
+
+    Implements a bounded queue of arbitrary elements which can be pushed
+    and popped from any number of contexts on either core without a mutex.
+    Each slot carries a sequence number so producers and consumers only
+    contend on a single compare-and-swap of the head or tail index.  On the
+    RP2350 the CAS is a native LDREX/STREX sequence, on the RP2040 the SDK's
+    atomic support implements it with a hardware spinlock held for a few
+    cycles.  Local interrupts are masked from the CAS until the slot is
+    published so an IRQ on the same core can never see a half-finished
+    operation it would have to wait on.
+
+    Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+#include <hardware/sync.h>
+
+template <typename T, size_t N>
+class MulticoreQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "MulticoreQueue size must be a power of 2");
+
+public:
+    // When wake is set, every successful push/pop executes a SEV so that a
+    // core sleeping in a blocking push() or pop() (via WFE) wakes immediately
+    MulticoreQueue(bool wake = true) : _wake(wake) {
+        for (size_t i = 0; i < N; i++) {
+            _cell[i].seq.store(i, std::memory_order_relaxed);
+        }
+        _head.store(0, std::memory_order_relaxed);
+        _tail.store(0, std::memory_order_relaxed);
+    }
+
+    // Add an element, returning false if the queue is full.  May also
+    // return false for a moment if the other core is in the middle of
+    // popping the last free slot.
+    bool push_nb(const T &val) {
+        bool ret = false;
+        uint32_t save = save_and_disable_interrupts();
+        uint32_t pos = _tail.load(std::memory_order_relaxed);
+        while (true) {
+            Cell *c = &_cell[pos & (N - 1)];
+            int32_t diff = (int32_t)(c->seq.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c->data = val;
+                    c->seq.store(pos + 1, std::memory_order_release);
+                    ret = true;
+                    break;
+                }
+                // CAS failure reloaded pos, try again
+            } else if (diff < 0) {
+                break; // Full
+            } else {
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+        restore_interrupts(save);
+        if (ret) {
+            _signal();
+        }
+        return ret;
+    }
+
+    // Add an element, waiting for space if needed
+    void push(const T &val) {
+        while (!push_nb(val)) {
+            __wfe();
+        }
+    }
+
+    // Remove an element, returning false if the queue is empty
+    bool pop_nb(T *val) {
+        return pop_nb(val, 1) == 1;
+    }
+
+    // Remove up to max elements with a single index update, returning the count.
+    // May also return 0 for a moment if the other core is in the middle of
+    // pushing the first element.
+    size_t pop_nb(T *val, size_t max) {
+        if (!max) {
+            return 0;
+        }
+        uint32_t save = save_and_disable_interrupts();
+        uint32_t pos = _head.load(std::memory_order_relaxed);
+        size_t cnt;
+        while (true) {
+            // Count how many consecutive filled cells are ready to take
+            for (cnt = 0; cnt < max; cnt++) {
+                Cell *c = &_cell[(pos + cnt) & (N - 1)];
+                if ((int32_t)(c->seq.load(std::memory_order_acquire) - (pos + cnt + 1)) != 0) {
+                    break;
+                }
+            }
+            if (!cnt) {
+                // Either empty or another consumer took pos already
+                uint32_t now = _head.load(std::memory_order_relaxed);
+                if (now == pos) {
+                    restore_interrupts(save);
+                    return 0;
+                }
+                pos = now;
+            } else if (_head.compare_exchange_weak(pos, pos + cnt, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        // These cells are now ours alone, copy them out and hand them back to producers
+        for (size_t i = 0; i < cnt; i++) {
+            Cell *c = &_cell[(pos + i) & (N - 1)];
+            val[i] = c->data;
+            c->seq.store(pos + i + N, std::memory_order_release);
+        }
+        restore_interrupts(save);
+        _signal();
+        return cnt;
+    }
+
+    // Remove an element, waiting for one to arrive if needed
+    T pop() {
+        T ret;
+        while (!pop_nb(&ret)) {
+            __wfe();
+        }
+        return ret;
+    }
+
+    // Remove at least one and up to max elements, waiting if needed
+    size_t pop(T *val, size_t max) {
+        size_t cnt;
+        while (!(cnt = pop_nb(val, max))) {
+            __wfe();
+        }
+        return cnt;
+    }
+
+    // Approximate count of elements, may be stale by the time it returns
+    int available() {
+        uint32_t t = _tail.load(std::memory_order_relaxed);
+        uint32_t h = _head.load(std::memory_order_relaxed);
+        int32_t d = (int32_t)(t - h);
+        return d < 0 ? 0 : (d > (int32_t)N ? N : d);
+    }
+
+    bool empty() {
+        return available() == 0;
+    }
+
+    constexpr size_t size() const {
+        return N;
+    }
+
+private:
+    inline void _signal() {
+        if (_wake) {
+            __sev();
+        }
+    }
+
+    struct Cell {
+        std::atomic<uint32_t> seq;
+        T data;
+    };
+
+    Cell _cell[N];
+    std::atomic<uint32_t> _head; // Next cell to pop
+    std::atomic<uint32_t> _tail; // Next cell to push
+    bool _wake;
+};
@@ -31,9 +31,17 @@
 #define PIOCNT 2
 #endif
 
-static std::map<const pio_program_t *, int> __pioMap[PIOCNT];
+// Where a program lives in a PIO and how many SMs are using it
+typedef struct {
+    int offset;
+    int refs;
+} PIOSlot;
+
+static std::map<const pio_program_t *, PIOSlot> __pioMap[PIOCNT];
+static const pio_program_t *__pioSM[PIOCNT][NUM_PIO_STATE_MACHINES]; // Program each SM we handed out runs
 static bool __pioAllocated[PIOCNT];
 auto_init_mutex(_pioMutex);
+static constexpr int __pioInsns = PIO_INSTRUCTION_COUNT;
 
 PIOProgram::PIOProgram(const pio_program_t *pgm) {
     _pgm = pgm;
@@ -41,18 +49,93 @@ PIOProgram::PIOProgram(const pio_program_t *pgm) {
     _sm = -1;
 }
 
-// We leave the INSN loaded in INSN RAM
+// Only the most recent SM from prepare() is remembered here, objects shared
+// between multiple users need to release() each one
 PIOProgram::~PIOProgram() {
     if (_pio) {
-        pio_sm_unclaim(_pio, _sm);
+        release(_pio, _sm);
+    }
+}
+
+// Drop one user of a program, removing it from IMEM when none remain.  _pioMutex must be held.
+static void __pioUnref(int o, const pio_program_t *pgm) {
+    PIO pi[PIOCNT] = { PIOS };
+    auto p = __pioMap[o].find(pgm);
+    if ((p != __pioMap[o].end()) && (--p->second.refs == 0)) {
+        DEBUGV("PIOProgram %p: Removing from PIO %p offset %d\n", pgm, pi[o], p->second.offset);
+        pio_remove_program(pi[o], pgm, p->second.offset);
+        __pioMap[o].erase(p);
+    }
+    if (__pioMap[o].empty()) {
+        bool idle = true;
+        for (int i = 0; i < NUM_PIO_STATE_MACHINES; i++) {
+            idle = idle && !pio_sm_is_claimed(pi[o], i);
+        }
+        // Allow a fresh GPIO base to be chosen on the next allocation
+        if (idle) {
+            __pioAllocated[o] = false;
+        }
+    }
+}
+
+// Drivers which call pio_sm_unclaim() directly never release() their SM, so
+// notice those and drop their references.  _pioMutex must be held.
+static void __pioCollect() {
+    PIO pi[PIOCNT] = { PIOS };
+    for (int o = 0; o < PIOCNT; o++) {
+        for (int i = 0; i < NUM_PIO_STATE_MACHINES; i++) {
+            if (__pioSM[o][i] && !pio_sm_is_claimed(pi[o], i)) {
+                DEBUGV("PIOProgram %p: SM %d on PIO %p was unclaimed without release\n", __pioSM[o][i], i, pi[o]);
+                const pio_program_t *pgm = __pioSM[o][i];
+                __pioSM[o][i] = nullptr;
+                __pioUnref(o, pgm);
+            }
+        }
+    }
+}
+
+void PIOProgram::release(PIO pio, int sm) {
+    CoreMutex m(&_pioMutex);
+    if (!pio || (sm < 0)) {
+        return;
+    }
+    int o = pio_get_index(pio);
+    if (__pioSM[o][sm] != _pgm) {
+        DEBUGV("PIOProgram %p: Release of SM %d on PIO %p which isn't ours\n", _pgm, sm, pio);
+        return;
+    }
+    pio_sm_set_enabled(pio, sm, false);
+    pio_sm_unclaim(pio, sm);
+    __pioSM[o][sm] = nullptr;
+    __pioUnref(o, _pgm);
+    if ((pio == _pio) && (sm == _sm)) {
+        _pio = nullptr;
+        _sm = -1;
     }
 }
 
+// Record a successful prepare() and pass the results back
+static void __pioClaimed(const pio_program_t *pgm, int o, int sm, int off, PIO *pio, int *smOut, int *offset) {
+    PIO pi[PIOCNT] = { PIOS };
+    auto p = __pioMap[o].find(pgm);
+    if (p == __pioMap[o].end()) {
+        __pioMap[o].insert({pgm, { off, 1 }});
+    } else {
+        p->second.refs++;
+    }
+    __pioSM[o][sm] = pgm;
+    *pio = pi[o];
+    *smOut = sm;
+    *offset = off;
+}
+
 // Possibly load into a PIO and allocate a SM
 bool PIOProgram::prepare(PIO *pio, int *sm, int *offset, int start, int cnt) {
     CoreMutex m(&_pioMutex);
     PIO pi[PIOCNT] = { PIOS };
 
+    __pioCollect();
+
     uint gpioBaseNeeded = ((start + cnt) >= 32) ? 16 : 0;
     DEBUGV("PIOProgram %p: Searching for base=%d, pins %d-%d\n", _pgm, gpioBaseNeeded, start, start + cnt - 1);
 
@@ -65,9 +148,7 @@ bool PIOProgram::prepare(PIO *pio, int *sm, int *offset, int start, int cnt) {
                 DEBUGV("PIOProgram %p: Reusing IMEM ON PIO %p(base=%d) for pins %d-%d\n", _pgm, pi[o], pio_get_gpio_base(pio_get_instance(o)), start, start + cnt - 1);
                 _pio = pi[o];
                 _sm = idx;
-                *pio = pi[o];
-                *sm = idx;
-                *offset = p->second;
+                __pioClaimed(_pgm, o, idx, p->second.offset, pio, sm, offset);
                 return true;
             }
         }
@@ -82,12 +163,9 @@ bool PIOProgram::prepare(PIO *pio, int *sm, int *offset, int start, int cnt) {
                 if (idx >= 0) {
                     DEBUGV("PIOProgram %p: Adding IMEM ON PIO %p(base=%d) for pins %d-%d\n", _pgm, pi[o], pio_get_gpio_base(pio_get_instance(o)), start, start + cnt - 1);
                     int off = pio_add_program(pi[o], _pgm);
-                    __pioMap[o].insert({_pgm, off});
                     _pio = pi[o];
                     _sm = idx;
-                    *pio = pi[o];
-                    *sm = idx;
-                    *offset = off;
+                    __pioClaimed(_pgm, o, idx, off, pio, sm, offset);
                     return true;
                 } else {
                     DEBUGV("PIOProgram: can't claim unused SM\n");
@@ -113,15 +191,101 @@ bool PIOProgram::prepare(PIO *pio, int *sm, int *offset, int start, int cnt) {
         assert(!__pioAllocated[o]);
         __pioAllocated[o]  = true;
         DEBUGV("PIOProgram %p: Allocating new PIO %p(base=%d) for pins %d-%d\n", _pgm, pi[o], pio_get_gpio_base(pio_get_instance(o)), start, start + cnt - 1);
-        __pioMap[o].insert({_pgm, off});
         _pio = pi[o];
         _sm = idx;
-        *pio = pi[o];
-        *sm = idx;
-        *offset = off;
+        __pioClaimed(_pgm, o, idx, off, pio, sm, offset);
         return true;
     }
 
     // Nope, no room either for SMs or INSNs
     return false;
 }
+
+// A program is present at this offset if a 1-instruction program can't be placed there
+static bool __pioUsed(PIO pio, int offset) {
+    static const uint16_t nop = 0xa042; // mov y, y
+    pio_program_t one;
+    memset(&one, 0, sizeof(one));
+    one.instructions = &nop;
+    one.length = 1;
+    one.origin = -1;
+    return !pio_can_add_program_at_offset(pio, &one, offset);
+}
+
+int PIOProgram::freeInstructions(PIO pio) {
+    CoreMutex m(&_pioMutex);
+    int cnt = 0;
+    for (int i = 0; i < __pioInsns; i++) {
+        cnt += __pioUsed(pio, i) ? 0 : 1;
+    }
+    return cnt;
+}
+
+// Programs in use can't be moved because their users hold their offsets, but
+// an idle PIO can be wiped so its whole IMEM is one free block again
+bool PIOProgram::defragment() {
+    CoreMutex m(&_pioMutex);
+    PIO pi[PIOCNT] = { PIOS };
+    bool ret = false;
+    __pioCollect();
+    for (int o = 0; o < PIOCNT; o++) {
+        bool idle = true;
+        for (int i = 0; i < NUM_PIO_STATE_MACHINES; i++) {
+            idle = idle && !pio_sm_is_claimed(pi[o], i);
+        }
+        if (!idle) {
+            continue;
+        }
+        bool used = false;
+        for (int i = 0; i < __pioInsns; i++) {
+            used = used || __pioUsed(pi[o], i);
+        }
+        if (used) {
+            DEBUGV("PIOProgram: Clearing idle PIO %p\n", pi[o]);
+            pio_clear_instruction_memory(pi[o]);
+            __pioMap[o].clear();
+            __pioAllocated[o] = false;
+            ret = true;
+        }
+    }
+    return ret;
+}
+
+void PIOProgram::dump(Print &p) {
+    CoreMutex m(&_pioMutex);
+    PIO pi[PIOCNT] = { PIOS };
+    __pioCollect();
+    for (int o = 0; o < PIOCNT; o++) {
+        char imem[__pioInsns + 1];
+        int free = 0;
+        for (int i = 0; i < __pioInsns; i++) {
+            bool used = __pioUsed(pi[o], i);
+            imem[i] = used ? '?' : '.'; // '?' until we know which program it belongs to
+            free += used ? 0 : 1;
+        }
+        imem[__pioInsns] = 0;
+        char tag = 'A';
+        for (auto const &e : __pioMap[o]) {
+            for (int i = 0; (i < e.first->length) && (e.second.offset + i < __pioInsns); i++) {
+                imem[e.second.offset + i] = tag;
+            }
+            tag = (tag == 'Z') ? 'A' : tag + 1;
+        }
+        p.printf("PIO%d: GPIO base %d, %d of %d instructions free\n", o, (int)pio_get_gpio_base(pi[o]), free, __pioInsns);
+        p.printf("  IMEM: %s\n", imem);
+        tag = 'A';
+        for (auto const &e : __pioMap[o]) {
+            p.printf("  %c: program %p, offset %d, length %d, %d user(s)\n", tag, e.first, e.second.offset, e.first->length, e.second.refs);
+            tag = (tag == 'Z') ? 'A' : tag + 1;
+        }
+        for (int i = 0; i < NUM_PIO_STATE_MACHINES; i++) {
+            if (!pio_sm_is_claimed(pi[o], i)) {
+                p.printf("  SM%d: free\n", i);
+            } else if (__pioSM[o][i]) {
+                p.printf("  SM%d: program %p, PC %d, %s\n", i, __pioSM[o][i], (int)pio_sm_get_pc(pi[o], i), (pi[o]->ctrl & (1 << i)) ? "running" : "stopped");
+            } else {
+                p.printf("  SM%d: claimed outside PIOProgram\n", i);
+            }
+        }
+    }
+}
@@ -22,13 +22,28 @@
 
 #include <hardware/pio.h>
 
-// Wrapper class for PIO programs, abstracting common operations out
+class Print;
+
+// Wrapper class for PIO programs, abstracting common operations out.
+// Loaded programs are reference counted per PIO, one reference per SM
+// handed out by prepare(), and removed from instruction memory when the
+// last SM using them is released.
 class PIOProgram {
 public:
     PIOProgram(const pio_program_t *pgm);
     ~PIOProgram();
     // Possibly load into a PIO and allocate a SM
     bool prepare(PIO *pio, int *sm, int *offset, int gpio_start = 0, int gpio_cnt = 1);
+    // Stop and unclaim a SM from prepare(), unloading the program if it was the last user
+    void release(PIO pio, int sm);
+
+    // Free instruction slots in a PIO (not necessarily contiguous)
+    static int freeInstructions(PIO pio);
+    // Completely clear instruction memory of any PIO with no claimed SMs,
+    // including programs loaded outside of PIOProgram.  Returns true if any was cleared.
+    static bool defragment();
+    // Print instruction memory and SM usage for every PIO
+    static void dump(Print &p);
 
 private:
     const pio_program_t *_pgm;
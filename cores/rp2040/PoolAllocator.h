@@ -0,0 +1,175 @@
+/*
+    Fixed-block pool allocators
+
+    Provides O(1) allocation and release of fixed-size blocks from a static
+    pool, safe to call from IRQs and from either core at the same time.  The
+    free list is a MulticoreQueue of block indices, so there is no global
+    lock and interrupts are only masked for a few cycles on the calling core.
+    Because the pool is a fixed array there is no fragmentation and the
+    worst case time is always the same.
+
+    Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include "MulticoreQueue.h"
+
+// N blocks of BlockSize bytes each.  N must be a power of 2.
+template <size_t BlockSize, size_t N>
+class FixedBlockPool {
+public:
+    FixedBlockPool() : _free(false) {
+        for (size_t i = 0; i < N; i++) {
+            _free.push_nb(i);
+        }
+    }
+
+    // Get a block, or nullptr if all are in use
+    void *alloc() {
+        uint32_t idx;
+        while (!_free.pop_nb(&idx)) {
+            if (_free.empty()) {
+                return nullptr;
+            }
+            // Another core is mid-free, it will finish in a few cycles
+        }
+        return _block[idx];
+    }
+
+    // Return a block from alloc() to the pool
+    void free(void *p) {
+        if (p) {
+            uint32_t idx = ((uint8_t *)p - _block[0]) / _blockSize;
+            while (!_free.push_nb(idx)) {
+                // The queue holds all N indices so it can't really be full, another
+                // core is mid-alloc of the slot we need and will finish in a few cycles
+            }
+        }
+    }
+
+    // Is this pointer from this pool?
+    bool owns(const void *p) const {
+        return (p >= _block[0]) && (p < _block[N]);
+    }
+
+    // Number of free blocks (approximate if other cores/IRQs are allocating)
+    int available() {
+        return _free.available();
+    }
+
+    static constexpr size_t blockSize() {
+        return _blockSize;
+    }
+
+private:
+    static constexpr size_t _blockSize = (BlockSize + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+    alignas(std::max_align_t) uint8_t _block[N][_blockSize];
+    MulticoreQueue<uint32_t, N> _free;
+};
+
+// Typed pool of N objects of type T
+template <typename T, size_t N>
+class PoolAllocator : public FixedBlockPool<sizeof(T), N> {
+public:
+    // Raw, unconstructed storage for one T
+    T *allocate() {
+        return (T *)this->alloc();
+    }
+
+    void deallocate(T *p) {
+        this->free(p);
+    }
+
+    // Allocate and construct, returning nullptr if the pool is empty
+    template <typename... Args>
+    T *create(Args&&... args) {
+        void *p = this->alloc();
+        return p ? new (p) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    // Destruct and release an object from create()
+    void destroy(T *p) {
+        if (p) {
+            p->~T();
+            this->free(p);
+        }
+    }
+};
+
+// One shared pool per BlockSize/N pair, independent of the allocator's value_type
+template <size_t BlockSize, size_t N>
+struct __PoolStdAllocatorPool {
+    static inline FixedBlockPool<BlockSize, N> pool;
+};
+
+// std::allocator compatible adaptor for node based containers (std::list,
+// std::map, std::set, ...).  All containers using the same BlockSize and N
+// share one static pool, and single object allocations which fit a block come
+// from it.  Anything else, or allocations made once the pool is exhausted,
+// falls back to the normal heap.
+template <typename T, size_t BlockSize = 32, size_t N = 64>
+class PoolStdAllocator {
+public:
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind {
+        typedef PoolStdAllocator<U, BlockSize, N> other;
+    };
+
+    PoolStdAllocator() noexcept { }
+
+    template <typename U>
+    PoolStdAllocator(const PoolStdAllocator<U, BlockSize, N> &) noexcept { }
+
+    T *allocate(size_t n) {
+        if ((n == 1) && (sizeof(T) <= BlockSize) && (alignof(T) <= alignof(std::max_align_t))) {
+            void *p = pool().alloc();
+            if (p) {
+                return (T *)p;
+            }
+        }
+        return (T *)::operator new(n * sizeof(T));
+    }
+
+    void deallocate(T *p, size_t n) {
+        (void) n;
+        if (pool().owns(p)) {
+            pool().free(p);
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    template <typename U>
+    bool operator==(const PoolStdAllocator<U, BlockSize, N> &) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const PoolStdAllocator<U, BlockSize, N> &) const noexcept {
+        return false;
+    }
+
+    static FixedBlockPool<BlockSize, N> &pool() {
+        return __PoolStdAllocatorPool<BlockSize, N>::pool;
+    }
+};
@@ -78,6 +78,7 @@ static int __not_in_flash_func(_parity)(int data) {
 // the shared handler
 static SerialPIO *_pioSP[3][4];
 void __not_in_flash_func(SerialPIO::_fifoIRQ)() {
+    TRACE_EVENT(TRACE_IRQ_ENTER, __get_current_exception() - VTABLE_FIRST_IRQ);
     for (int p = 0; p < 3; p++) {
         for (int sm = 0; sm < 4; sm++) {
             SerialPIO *s = _pioSP[p][sm];
@@ -86,12 +87,16 @@ void __not_in_flash_func(SerialPIO::_fifoIRQ)() {
             }
         }
     }
+    TRACE_EVENT(TRACE_IRQ_EXIT, __get_current_exception() - VTABLE_FIRST_IRQ);
 }
 
 void __not_in_flash_func(SerialPIO::_handleIRQ)() {
     if ((_rx == NOPIN) || (_onCore != get_core_num())) {
         return;
     }
+    // Collect a batch of decoded bytes so the queue is only updated once per batch
+    uint8_t buff[8];
+    size_t cnt = 0;
     while (!pio_sm_is_rx_fifo_empty(_rxPIO, _rxSM)) {
         uint32_t decode = _rxPIO->rxf[_rxSM];
         uint32_t val = decode >> (32 - _rxBits - 1);
@@ -122,10 +127,17 @@ void __not_in_flash_func(SerialPIO::_handleIRQ)() {
             }
         }
 
-        if (!_queue->write(val & ((1 << _bits) -  1))) {
-            _overflow = true;
+        buff[cnt++] = val & ((1 << _bits) -  1);
+        if (cnt == sizeof(buff)) {
+            if (_queue->write(buff, cnt) != cnt) {
+                _overflow = true;
+            }
+            cnt = 0;
         }
     }
+    if (cnt && (_queue->write(buff, cnt) != cnt)) {
+        _overflow = true;
+    }
 }
 
 SerialPIO::SerialPIO(pin_size_t tx, pin_size_t rx, size_t fifoSize) {
@@ -273,13 +285,11 @@ void SerialPIO::end() {
         return;
     }
     if (_tx != NOPIN) {
-        pio_sm_set_enabled(_txPIO, _txSM, false);
-        pio_sm_unclaim(_txPIO, _txSM);
+        _txPgm->release(_txPIO, _txSM);
         gpio_set_outover(_tx, 0);
     }
     if (_rx != NOPIN) {
-        pio_sm_set_enabled(_rxPIO, _rxSM, false);
-        pio_sm_unclaim(_rxPIO, _rxSM);
+        _rxPgm->release(_rxPIO, _rxSM);
         _pioSP[pio_get_index(_rxPIO)][_rxSM] = nullptr;
         // If no more active, disable the IRQ
         auto pioNum = pio_get_index(_rxPIO);
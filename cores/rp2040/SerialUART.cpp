@@ -22,6 +22,8 @@
 #include "CoreMutex.h"
 #include <hardware/uart.h>
 #include <hardware/gpio.h>
+#include <hardware/dma.h>
+#include <hardware/sync.h>
 
 // SerialEvent functions are weak, so when the user doesn't define them,
 // the linker just sets their address to 0 (which is checked below).
@@ -156,6 +158,20 @@ bool SerialUART::setPollingMode(bool mode) {
         return false;
     }
     _polling = mode;
+    if (mode) {
+        _dmaMode = false;
+    }
+    return true;
+}
+
+bool SerialUART::setDMAMode(bool mode) {
+    if (_running) {
+        return false;
+    }
+    _dmaMode = mode;
+    if (mode) {
+        _polling = false;
+    }
     return true;
 }
 
@@ -283,7 +299,10 @@ void SerialUART::begin(unsigned long baud, uint16_t config) {
     uart_set_format(_uart, bits, stop, parity);
     uart_set_hw_flow(_uart, _cts != UART_PIN_NOT_DEFINED, _rts != UART_PIN_NOT_DEFINED);
 
-    if (!_polling) {
+    _dma = _dmaMode && _beginDMA();
+    if (_dma) {
+        // DMA IRQs will handle everything, no UART IRQs needed
+    } else if (!_polling) {
         if (_uart == uart0) {
             irq_set_exclusive_handler(UART0_IRQ, _uart0IRQ);
             irq_set_enabled(UART0_IRQ, true);
@@ -305,7 +324,9 @@ void SerialUART::end() {
         return;
     }
     _running = false;
-    if (!_polling) {
+    if (_dma) {
+        // DMA channels shut down below, once we own the FIFO
+    } else if (!_polling) {
         if (_uart == uart0) {
             irq_set_enabled(UART0_IRQ, false);
         } else {
@@ -316,6 +337,9 @@ void SerialUART::end() {
     // Paranoia - ensure nobody else is using anything here at the same time
     mutex_enter_blocking(&_mutex);
     mutex_enter_blocking(&_fifoMutex);
+    if (_dma) {
+        _endDMA();
+    }
     uart_deinit(_uart);
     delete _queue;
     // Reset the mutexes once all is off/cleaned up
@@ -433,6 +457,9 @@ int SerialUART::availableForWrite() {
     if (_polling) {
         _handleIRQ(false);
     }
+    if (_dma) {
+        return _txQueue->availableForWrite();
+    }
     return (uart_is_writable(_uart)) ? 1 : 0;
 }
 
@@ -444,6 +471,9 @@ void SerialUART::flush() {
     if (_polling) {
         _handleIRQ(false);
     }
+    while (_dma && (_txDMACount || !_txQueue->empty())) {
+        /* Wait for the DMA to send everything to the UART */
+    }
     uart_tx_wait_blocking(_uart);
 }
 
@@ -455,6 +485,13 @@ size_t SerialUART::write(uint8_t c) {
     if (_polling) {
         _handleIRQ(false);
     }
+    if (_dma) {
+        while (!_txQueue->write(c)) {
+            /* Wait for the DMA to drain some space */
+        }
+        _kickTXDMA();
+        return 1;
+    }
     uart_putc_raw(_uart, c);
     return 1;
 }
@@ -467,6 +504,15 @@ size_t SerialUART::write(const uint8_t *p, size_t len) {
     if (_polling) {
         _handleIRQ(false);
     }
+    if (_dma) {
+        // Only blocks when the TX ring is full, the DMA IRQ chains the rest
+        size_t cnt = 0;
+        while (cnt < len) {
+            cnt += _txQueue->write(p + cnt, len - cnt);
+            _kickTXDMA();
+        }
+        return len;
+    }
     size_t cnt = len;
     while (cnt) {
         uart_putc_raw(_uart, *p);
@@ -521,8 +567,19 @@ void __not_in_flash_func(SerialUART::_handleIRQ)(bool inIRQ) {
             return;
         }
     }
+    if (_dma) {
+        _pumpDMA();
+        if (inIRQ) {
+            mutex_exit(&_fifoMutex);
+        }
+        return;
+    }
     // ICR is write-to-clear
     uart_get_hw(_uart)->icr = UART_UARTICR_RTIC_BITS | UART_UARTICR_RXIC_BITS;
+    // Drain the HW FIFO into a local buffer and push it in one shot, so the
+    // queue bookkeeping is only done once per batch and not per byte
+    uint8_t buff[32];
+    size_t cnt = 0;
     while (uart_is_readable(_uart)) {
         uint32_t raw = uart_get_hw(_uart)->dr;
         if (raw & 0x400) {
@@ -533,16 +590,163 @@ void __not_in_flash_func(SerialUART::_handleIRQ)(bool inIRQ) {
             // Framing, Parity Error.  Ignore this bad char
             continue;
         }
-        uint8_t val = raw & 0xff;
-        if (!_queue->write(val)) {
-            _overflow = true;
+        buff[cnt++] = raw & 0xff;
+        if (cnt == sizeof(buff)) {
+            if (_queue->write(buff, cnt) != cnt) {
+                _overflow = true;
+            }
+            cnt = 0;
         }
     }
+    if (cnt && (_queue->write(buff, cnt) != cnt)) {
+        _overflow = true;
+    }
     if (inIRQ) {
         mutex_exit(&_fifoMutex);
     }
 }
 
+// DMA mode.  RX runs continuously into a power-of-2 ring with a completion
+// IRQ every half ring to move the data into _queue.  Partial bursts are
+// picked up directly from the channel write address whenever the app calls
+// available/read/peek.  TX is a chain of DMA transfers out of _txQueue, each
+// completion IRQ starting the next contiguous span.
+static SerialUART *__uartDMAChannelMap[NUM_DMA_CHANNELS] = { nullptr };
+static bool __uartDMAIRQInstalled = false;
+
+bool SerialUART::_beginDMA() {
+    _rxDMA = dma_claim_unused_channel(false);
+    if (_rxDMA == -1) {
+        return false;
+    }
+    _txDMA = dma_claim_unused_channel(false);
+    if (_txDMA == -1) {
+        dma_channel_unclaim(_rxDMA);
+        return false;
+    }
+
+    // Ring must be a power of 2 and at most 32KB.  Make sure a half-ring IRQ
+    // isn't happening more often than the UART's own FIFO IRQ would.
+    int ringBits = 8;
+    while (((1u << ringBits) < _fifoSize) && (ringBits < 15)) {
+        ringBits++;
+    }
+    _rxDMASize = 1 << ringBits;
+    _rxDMABuff = (uint8_t *)aligned_alloc(_rxDMASize, _rxDMASize);
+    if (!_rxDMABuff) {
+        dma_channel_unclaim(_rxDMA);
+        dma_channel_unclaim(_txDMA);
+        return false;
+    }
+    _rxDMAReader = 0;
+    _txQueue = new LocklessQueue<uint8_t>(_rxDMASize);
+    _txDMACount = 0;
+    _txLock = spin_lock_instance(spin_lock_claim_unused(true));
+
+    dma_channel_config c = dma_channel_get_default_config(_rxDMA);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, ringBits); // Wrap the write address
+    channel_config_set_dreq(&c, uart_get_dreq(_uart, false));
+    dma_channel_configure(_rxDMA, &c, _rxDMABuff, &uart_get_hw(_uart)->dr, _rxDMASize / 2, false);
+
+    c = dma_channel_get_default_config(_txDMA);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, uart_get_dreq(_uart, true));
+    dma_channel_configure(_txDMA, &c, &uart_get_hw(_uart)->dr, _rxDMABuff, 0, false);
+
+    if (!__uartDMAIRQInstalled) {
+        irq_add_shared_handler(DMA_IRQ_0, _dmaIRQ, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+        __uartDMAIRQInstalled = true;
+    }
+    __uartDMAChannelMap[_rxDMA] = this;
+    __uartDMAChannelMap[_txDMA] = this;
+    dma_channel_set_irq0_enabled(_rxDMA, true);
+    dma_channel_set_irq0_enabled(_txDMA, true);
+
+    uart_get_hw(_uart)->dmacr = UART_UARTDMACR_TXDMAE_BITS | UART_UARTDMACR_RXDMAE_BITS;
+    dma_channel_start(_rxDMA);
+    return true;
+}
+
+void SerialUART::_endDMA() {
+    uart_get_hw(_uart)->dmacr = 0;
+    // Disable IRQs before aborting to avoid a spurious completion
+    dma_channel_set_irq0_enabled(_rxDMA, false);
+    dma_channel_set_irq0_enabled(_txDMA, false);
+    __uartDMAChannelMap[_rxDMA] = nullptr;
+    __uartDMAChannelMap[_txDMA] = nullptr;
+    dma_channel_abort(_rxDMA);
+    dma_channel_abort(_txDMA);
+    dma_channel_cleanup(_rxDMA);
+    dma_channel_unclaim(_rxDMA);
+    dma_channel_cleanup(_txDMA);
+    dma_channel_unclaim(_txDMA);
+    _rxDMA = -1;
+    _txDMA = -1;
+    spin_lock_unclaim(spin_lock_get_num(_txLock));
+    free(_rxDMABuff);
+    _rxDMABuff = nullptr;
+    delete _txQueue;
+    _txQueue = nullptr;
+    _dma = false;
+}
+
+void __not_in_flash_func(SerialUART::_pumpDMA)() {
+    // The channel's write pointer tells us exactly how far the RX DMA has gotten
+    uint32_t w = ((uint32_t)dma_channel_hw_addr(_rxDMA)->write_addr - (uint32_t)_rxDMABuff) & (_rxDMASize - 1);
+    while (_rxDMAReader != w) {
+        size_t len = (w > _rxDMAReader) ? w - _rxDMAReader : _rxDMASize - _rxDMAReader;
+        if (_queue->write(_rxDMABuff + _rxDMAReader, len) != len) {
+            _overflow = true;
+        }
+        _rxDMAReader = (_rxDMAReader + len) & (_rxDMASize - 1);
+    }
+}
+
+void __not_in_flash_func(SerialUART::_kickTXDMA)() {
+    uint32_t save = spin_lock_blocking(_txLock);
+    if (!_txDMACount) {
+        const uint8_t *p;
+        size_t len = _txQueue->peek(&p);
+        if (len) {
+            _txDMACount = len;
+            dma_channel_transfer_from_buffer_now(_txDMA, p, len);
+        }
+    }
+    spin_unlock(_txLock, save);
+}
+
+void __not_in_flash_func(SerialUART::_handleDMAIRQ)(int channel) {
+    dma_channel_acknowledge_irq0(channel);
+    TRACE_EVENT(TRACE_DMA_DONE, channel);
+    if (channel == _rxDMA) {
+        // Restart immediately, the ring wraps the write address for us
+        dma_channel_set_trans_count(_rxDMA, _rxDMASize / 2, true);
+        _handleIRQ(true);
+    } else {
+        uint32_t save = spin_lock_blocking(_txLock);
+        _txQueue->consume(_txDMACount);
+        _txDMACount = 0;
+        spin_unlock(_txLock, save);
+        _kickTXDMA();
+    }
+}
+
+void __not_in_flash_func(SerialUART::_dmaIRQ)() {
+    TRACE_EVENT(TRACE_IRQ_ENTER, DMA_IRQ_0);
+    for (int i = 0; i < NUM_DMA_CHANNELS; i++) {
+        if (__uartDMAChannelMap[i] && dma_channel_get_irq0_status(i)) {
+            __uartDMAChannelMap[i]->_handleDMAIRQ(i);
+        }
+    }
+    TRACE_EVENT(TRACE_IRQ_EXIT, DMA_IRQ_0);
+}
+
 #if (!defined(__SERIAL1_DEVICE) && defined(__SERIAL2_DEVICE)) || (defined(__SERIAL1_DEVICE) && !defined(__SERIAL2_DEVICE))
 #error "Need to define both __SERIAL1_DEVICE and __SERIAL2_DEVICE"
 #endif
@@ -568,17 +772,21 @@ SerialUART Serial2(__SERIAL2_DEVICE, PIN_SERIAL2_TX, PIN_SERIAL2_RX);
 
 
 void __not_in_flash_func(SerialUART::_uart0IRQ)() {
+    TRACE_EVENT(TRACE_IRQ_ENTER, UART0_IRQ);
     if (__SERIAL1_DEVICE == uart0) {
         Serial1._handleIRQ();
     } else {
         Serial2._handleIRQ();
     }
+    TRACE_EVENT(TRACE_IRQ_EXIT, UART0_IRQ);
 }
 
 void __not_in_flash_func(SerialUART::_uart1IRQ)() {
+    TRACE_EVENT(TRACE_IRQ_ENTER, UART1_IRQ);
     if (__SERIAL2_DEVICE == uart1) {
         Serial2._handleIRQ();
     } else {
         Serial1._handleIRQ();
     }
+    TRACE_EVENT(TRACE_IRQ_EXIT, UART1_IRQ);
 }
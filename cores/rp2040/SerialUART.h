@@ -64,6 +64,8 @@ public:
 
     bool setFIFOSize(size_t size);
     bool setPollingMode(bool mode = true);
+    // Use DMA for RX and TX instead of per-byte IRQs.  Exclusive with polling mode
+    bool setDMAMode(bool mode = true);
 
     void begin(unsigned long baud = 115200) override {
         begin(baud, SERIAL_8N1);
@@ -99,7 +101,9 @@ public:
 private:
     static void _uart0IRQ();
     static void _uart1IRQ();
+    static void _dmaIRQ();
     void _handleIRQ(bool inIRQ = true);
+    void _handleDMAIRQ(int channel);
 
     bool _running = false;
     uart_inst_t *_uart;
@@ -118,6 +122,22 @@ private:
     size_t   _fifoSize = 32;
     mutex_t  _fifoMutex; // Only needed when non-IRQ updates _writer
     void _pumpFIFO(); // User space FIFO transfer
+
+    // DMA mode
+    bool _beginDMA();
+    void _endDMA();
+    void _pumpDMA(); // Move new data from the RX ring into _queue, _fifoMutex must be held
+    void _kickTXDMA(); // Start the next TX transfer if the channel is idle
+    bool _dmaMode = false; // User requested
+    bool _dma = false; // Actually running with DMA
+    int _rxDMA = -1;
+    int _txDMA = -1;
+    uint8_t *_rxDMABuff = nullptr; // Naturally aligned for the DMA ring
+    size_t _rxDMASize;
+    uint32_t _rxDMAReader;
+    LocklessQueue<uint8_t> *_txQueue = nullptr;
+    volatile size_t _txDMACount; // Bytes in the in-flight TX transfer
+    spin_lock_t *_txLock; // Protects starting TX DMA from app vs. IRQ
 };
 
 extern SerialUART Serial1; // HW UART 0
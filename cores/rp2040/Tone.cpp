@@ -127,8 +127,7 @@ void noTone(uint8_t pin) {
             cancel_alarm(entry->second->alarm);
             entry->second->alarm = 0;
         }
-        pio_sm_set_enabled(entry->second->pio, entry->second->sm, false);
-        pio_sm_unclaim(entry->second->pio, entry->second->sm);
+        _tone2Pgm.release(entry->second->pio, entry->second->sm);
         delete entry->second;
         _toneMap.erase(entry);
         pinMode(pin, OUTPUT);
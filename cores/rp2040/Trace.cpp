@@ -0,0 +1,95 @@
+/*
+    Lightweight event trace ring buffer
+
+    Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <Arduino.h>
+#include "Trace.h"
+
+#ifdef __TRACE
+
+#include <hardware/sync.h>
+#include "_cyclecount.h"
+
+static_assert((TRACE_RECORDS & (TRACE_RECORDS - 1)) == 0, "TRACE_RECORDS must be a power of 2");
+
+typedef struct {
+    uint32_t us;        // time_us_32(), common to both cores
+    uint32_t cycles;    // This core's cycle counter, for sub-microsecond deltas
+    uint32_t id;
+    uint32_t arg;
+} TraceRecord;
+
+static TraceRecord __traceRing[2][TRACE_RECORDS];
+static uint32_t __traceIdx[2];
+static volatile bool __traceOn = true;
+
+extern "C" void __not_in_flash_func(__trace)(uint32_t id, uint32_t arg) {
+    if (!__traceOn) {
+        return;
+    }
+    uint32_t save = save_and_disable_interrupts();
+    int core = get_core_num();
+    TraceRecord *r = &__traceRing[core][__traceIdx[core]++ & (TRACE_RECORDS - 1)];
+    r->us = time_us_32();
+    r->cycles = __cycleCount();
+    r->id = id;
+    r->arg = arg;
+    restore_interrupts(save);
+}
+
+extern "C" bool traceEnable(bool enable) {
+    bool ret = __traceOn;
+    __traceOn = enable;
+    return ret;
+}
+
+void traceDump(Print &p) {
+    bool was = traceEnable(false);
+    delayMicroseconds(10); // Let any in-progress __trace on the other core finish
+    p.printf("# TRACE v1 hz=%lu cores=2 records=%d\n", (unsigned long)rp2040.f_cpu(), TRACE_RECORDS);
+    for (int core = 0; core < 2; core++) {
+        uint32_t end = __traceIdx[core];
+        uint32_t start = (end > TRACE_RECORDS) ? end - TRACE_RECORDS : 0;
+        for (uint32_t i = start; i < end; i++) {
+            TraceRecord *r = &__traceRing[core][i & (TRACE_RECORDS - 1)];
+            p.printf("T %d %lu %lu %lu %08lx\n", core, r->us, r->cycles, r->id, r->arg);
+        }
+        __traceIdx[core] = 0;
+    }
+    p.printf("# END\n");
+    traceEnable(was);
+}
+
+#else
+
+extern "C" void __trace(uint32_t id, uint32_t arg) {
+    (void) id;
+    (void) arg;
+}
+
+extern "C" bool traceEnable(bool enable) {
+    (void) enable;
+    return false;
+}
+
+void traceDump(Print &p) {
+    p.printf("# TRACE disabled, rebuild with Tools->Profiling->Event Trace\n");
+}
+
+#endif
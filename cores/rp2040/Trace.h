@@ -0,0 +1,75 @@
+/*
+    Lightweight event trace ring buffer
+
+    When built with -D__TRACE (Tools->Profiling->Event Trace) each core keeps
+    a ring of the most recent (timestamp, event, argument) records.  Core IRQ
+    handlers, CoreMutex, lwIP calls, the USB task, and DMA completions add
+    records, as can the application.  The rings can be dumped as text to any
+    Print and converted by tools/tracedecode.py into Chrome Trace/Perfetto
+    JSON.  Without __TRACE all of this compiles to nothing.
+
+    Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Records kept per core, must be a power of 2
+#ifndef TRACE_RECORDS
+#define TRACE_RECORDS 512
+#endif
+
+// Event IDs, keep in sync with tools/tracedecode.py
+typedef enum {
+    TRACE_IRQ_ENTER = 1,    // arg = IRQ number
+    TRACE_IRQ_EXIT,         // arg = IRQ number
+    TRACE_MUTEX_WAIT,       // arg = mutex, about to block on another owner
+    TRACE_MUTEX_ACQUIRE,    // arg = mutex
+    TRACE_MUTEX_RELEASE,    // arg = mutex
+    TRACE_LWIP_ENTER,       // arg = caller address (or lwIP op under FreeRTOS)
+    TRACE_LWIP_EXIT,
+    TRACE_USB_TASK_ENTER,
+    TRACE_USB_TASK_EXIT,
+    TRACE_DMA_DONE,         // arg = DMA channel
+    TRACE_USER = 0x100      // Application events start here
+} trace_event_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Add a record to the current core's ring, safe from any context
+void __trace(uint32_t id, uint32_t arg);
+// Stop or restart recording, returning the prior state
+bool traceEnable(bool enable);
+
+#ifdef __cplusplus
+}
+
+class Print;
+// Write all records, oldest first, then empty the rings.  Recording is
+// paused while dumping.
+void traceDump(Print &p);
+#endif
+
+#ifdef __TRACE
+#define TRACE_EVENT(id, arg) __trace((uint32_t)(id), (uint32_t)(arg))
+#else
+#define TRACE_EVENT(id, arg) do { } while (0)
+#endif
@@ -420,7 +420,9 @@ void USBClass::freertosUSBTask(void *param) {
         if (ss != taskSCHEDULER_SUSPENDED) {
             auto m = __get_freertos_mutex_for_ptr(&USB.mutex);
             if (xSemaphoreTake(m, 0)) {
+                TRACE_EVENT(TRACE_USB_TASK_ENTER, 0);
                 tud_task();
+                TRACE_EVENT(TRACE_USB_TASK_EXIT, 0);
                 xSemaphoreGive(m);
             }
         }
@@ -432,10 +434,14 @@ void USBClass::usbIRQ() {
     // if the mutex is already owned, then we are in user code
     // in this file which will do a tud_task itself, so we'll just do nothing
     // until the next tick; we won't starve
+    TRACE_EVENT(TRACE_IRQ_ENTER, USB.usbTaskIRQ);
     if (mutex_try_enter(&USB.mutex, nullptr)) {
+        TRACE_EVENT(TRACE_USB_TASK_ENTER, 0);
         tud_task();
+        TRACE_EVENT(TRACE_USB_TASK_EXIT, 0);
         mutex_exit(&USB.mutex);
     }
+    TRACE_EVENT(TRACE_IRQ_EXIT, USB.usbTaskIRQ);
 }
 
 int64_t USBClass::timerTask(__unused alarm_id_t id, __unused void *user_data) {
@@ -504,6 +510,9 @@ void USBClass::begin() {
     setupUSBDescriptor();
 
     mutex_init(&mutex);
+    if (lock_stats) {
+        lockStatsName(&mutex, "USB");
+    }
 
     tusb_init();
 
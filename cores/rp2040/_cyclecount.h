@@ -0,0 +1,50 @@
+/*
+    Cycle counter safe to read from any core, task, or IRQ
+
+    Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <hardware/timer.h>
+#if defined(PICO_RP2350) && !defined(__riscv)
+#include <hardware/structs/m33.h>
+#endif
+
+// rp2040.getCycleCount() uses a PIO SM under FreeRTOS or gprof, which can't be
+// shared with IRQs.  Instead use each core's own counter (which is not
+// synchronized between cores), or on the RP2040 under FreeRTOS scale the
+// microsecond timer and accept the lower resolution.
+static inline uint32_t __cycleCount() {
+#if defined(__riscv)
+    uint32_t c;
+    asm volatile("csrci 0x320, 1"); // Make sure mcountinhibit.CY is clear
+    asm volatile("csrr %0, mcycle" : "=r"(c));
+    return c;
+#elif defined(PICO_RP2350)
+    if (!(m33_hw->dwt_ctrl & M33_DWT_CTRL_CYCCNTENA_BITS)) {
+        m33_hw->demcr |= M33_DEMCR_TRCENA_BITS;
+        m33_hw->dwt_ctrl |= M33_DWT_CTRL_CYCCNTENA_BITS;
+    }
+    return m33_hw->dwt_cyccnt;
+#elif !defined(__PROFILE) && !defined(__FREERTOS)
+    return rp2040.getCycleCount();
+#else
+    return time_us_32() * (rp2040.f_cpu() / 1000000);
+#endif
+}
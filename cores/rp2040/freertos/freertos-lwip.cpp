@@ -25,15 +25,25 @@
 #include "semphr.h"
 #include <lwip_wrap.h>
 #include "freertos-lwip.h"
+#include "_cyclecount.h"
 
 // The data structure for the LWIP work queue
 typedef struct {
     __lwip_op op;
-    void *req;
+    void *req;              // nullptr for async requests, which live in data
     TaskHandle_t wakeup;
+    uint32_t queued;        // __cycleCount() when posted, for the latency stats
+    union {
+        __pbuf_free_req pbuf_free;
+        __tcp_recved_req tcp_recved;
+        __tcp_output_req tcp_output;
+    } data;
 } LWIPWork;
 
-#define LWIP_WORK_ENTRIES 16
+// Async requests don't block the caller, so allow more of them to pile up
+#ifndef LWIP_WORK_ENTRIES
+#define LWIP_WORK_ENTRIES 32
+#endif
 
 #ifndef LWIP_TASK_PRIORITY
 #define LWIP_TASK_PRIORITY (configMAX_PRIORITIES - 2)
@@ -46,6 +56,41 @@ static void lwipThread(void *params);
 static TaskHandle_t __lwipTask;
 static QueueHandle_t __lwipQueue;
 
+// Per-op latency, only ever updated by the LWIP task itself
+typedef struct {
+    __lwip_op op;
+    uint32_t count;
+    uint32_t maxQueue;      // Posted until the LWIP task started it
+    uint64_t totalQueue;
+    uint32_t maxRun;        // Time spent inside LWIP
+    uint64_t totalRun;
+} LWIPOpStat;
+
+#define LWIPSTATS_ENTRIES 64
+static LWIPOpStat __lwipStat[LWIPSTATS_ENTRIES];
+static uint32_t __lwipStatDropped;
+
+static void __lwipStatsAdd(__lwip_op op, uint32_t queue, uint32_t run) {
+    uint32_t h = (uint32_t)op % LWIPSTATS_ENTRIES;
+    for (int i = 0; i < LWIPSTATS_ENTRIES; i++) {
+        LWIPOpStat *s = &__lwipStat[(h + i) % LWIPSTATS_ENTRIES];
+        if (!s->count || (s->op == op)) {
+            s->op = op;
+            s->count++;
+            s->totalQueue += queue;
+            if (queue > s->maxQueue) {
+                s->maxQueue = queue;
+            }
+            s->totalRun += run;
+            if (run > s->maxRun) {
+                s->maxRun = run;
+            }
+            return;
+        }
+    }
+    __lwipStatDropped++;
+}
+
 void __startLWIPThread() {
     static bool initted = false;
     if (initted) {
@@ -63,9 +108,10 @@ void __startLWIPThread() {
 
 extern "C" void __lwip(__lwip_op op, void *req, bool fromISR) {
     LWIPWork w;
+    w.op = op;
+    w.req = req;
+    w.queued = __cycleCount();
     if (fromISR) {
-        w.op = op;
-        w.req = req;
         w.wakeup = 0; // Don't try and wake up a task when done, we're not in one!
         BaseType_t xHigherPriorityTaskWoken = pdFALSE;
         if (!xQueueSendFromISR(__lwipQueue, &w, &xHigherPriorityTaskWoken)) {
@@ -73,11 +119,7 @@ extern "C" void __lwip(__lwip_op op, void *req, bool fromISR) {
         }
         portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
     } else {
-        TaskStatus_t t;
-        vTaskGetInfo(nullptr, &t, pdFALSE, eInvalid); // TODO - can we speed this up???
-        w.op = op;
-        w.req = req;
-        w.wakeup = t.xHandle;
+        w.wakeup = xTaskGetCurrentTaskHandle();
         if (!xQueueSend(__lwipQueue, &w, portMAX_DELAY)) {
             panic("LWIP task send failed");
         }
@@ -85,10 +127,491 @@ extern "C" void __lwip(__lwip_op op, void *req, bool fromISR) {
     }
 }
 
+extern "C" void __lwip_async(__lwip_op op, const void *req, size_t len) {
+    LWIPWork w;
+    if (len > sizeof(w.data)) {
+        panic("LWIP async request too large");
+    }
+    w.op = op;
+    w.req = nullptr;
+    w.wakeup = 0;
+    w.queued = __cycleCount();
+    memcpy(&w.data, req, len);
+    // The queue is FIFO, so this still completes before any later request from this task
+    if (!xQueueSend(__lwipQueue, &w, portMAX_DELAY)) {
+        panic("LWIP task send failed");
+    }
+}
+
+extern "C" void __lwip_batch(const __lwip_batch_item *items, size_t count) {
+    __batch_req req = { items, count };
+    __lwip(__batch, &req, false);
+}
+
 extern "C" bool __isLWIPThread() {
-    TaskStatus_t t;
-    vTaskGetInfo(nullptr, &t, pdFALSE, eInvalid); // TODO - can we speed this up???
-    return t.xHandle == __lwipTask;
+    return xTaskGetCurrentTaskHandle() == __lwipTask;
+}
+
+// Stats are copied and cleared from inside the LWIP task so they're never torn
+static void __lwipStatsSnapshot(void *dest) {
+    memcpy(dest, __lwipStat, sizeof(__lwipStat));
+}
+
+static void __lwipStatsClear(void *unused) {
+    (void) unused;
+    memset(__lwipStat, 0, sizeof(__lwipStat));
+    __lwipStatDropped = 0;
+}
+
+void lwipStatsReset() {
+    lwip_callback(__lwipStatsClear, nullptr);
+}
+
+void lwipStatsDump(Print &p) {
+    if (!__lwipQueue) {
+        p.printf("LWIP task not started\n");
+        return;
+    }
+    LWIPOpStat *snap = new LWIPOpStat[LWIPSTATS_ENTRIES];
+    lwip_callback(__lwipStatsSnapshot, snap);
+
+    // Insertion sort by total time, largest first
+    int cnt = 0;
+    for (int i = 0; i < LWIPSTATS_ENTRIES; i++) {
+        if (!snap[i].count) {
+            continue;
+        }
+        LWIPOpStat t = snap[i];
+        int j = cnt++;
+        while ((j > 0) && (snap[j - 1].totalQueue + snap[j - 1].totalRun < t.totalQueue + t.totalRun)) {
+            snap[j] = snap[j - 1];
+            j--;
+        }
+        snap[j] = t;
+    }
+
+    p.printf("%-6s %10s %10s %10s %10s %10s\n", "Op", "Count", "Avg queue", "Max queue", "Avg run", "Max run");
+    for (int i = 0; i < cnt; i++) {
+        p.printf("%-6d %10lu %10lu %10lu %10lu %10lu\n", (int)snap[i].op, snap[i].count, (uint32_t)(snap[i].totalQueue / snap[i].count),
+                 snap[i].maxQueue, (uint32_t)(snap[i].totalRun / snap[i].count), snap[i].maxRun);
+    }
+    if (__lwipStatDropped) {
+        p.printf("%lu requests of untracked ops\n", __lwipStatDropped);
+    }
+    delete[] snap;
+}
+
+// Execute a single request, only ever called from the LWIP task
+static void __lwipDispatch(__lwip_op op, void *req) {
+    switch (op) {
+    case __lwip_init: {
+        __real_lwip_init();
+        break;
+    }
+    case __pbuf_header: {
+        __pbuf_header_req *r = (__pbuf_header_req *)req;
+        *(r->ret) = __real_pbuf_header(r->p, r->header_size);
+        break;
+    }
+    case __pbuf_free: {
+        __pbuf_free_req *r = (__pbuf_free_req *)req;
+        u8_t ret = __real_pbuf_free(r->p);
+        if (r->ret) { // Fire-and-forget requests have no one to return to
+            *(r->ret) = ret;
+        }
+        break;
+    }
+    case __pbuf_alloc: {
+        __pbuf_alloc_req *r = (__pbuf_alloc_req *)req;
+        *(r->ret) = __real_pbuf_alloc(r->l, r->length, r->type);
+        break;
+    }
+    case __pbuf_take: {
+        __pbuf_take_req *r = (__pbuf_take_req *)req;
+        *(r->ret) = __real_pbuf_take(r->buf, r->dataptr, r->len);
+        break;
+    }
+    case __pbuf_copy_partial: {
+        __pbuf_copy_partial_req *r = (__pbuf_copy_partial_req *)req;
+        *(r->ret) = __real_pbuf_copy_partial(r->p, r->dataptr, r->len, r->offset);
+        break;
+    }
+    case __pbuf_ref: {
+        __pbuf_ref_req *r = (__pbuf_ref_req *)req;
+        __real_pbuf_ref(r->p);
+        break;
+    }
+    case __pbuf_get_at: {
+        __pbuf_get_at_req *r = (__pbuf_get_at_req *)req;
+        *(r->ret) = __real_pbuf_get_at(r->p, r->offset);
+        break;
+    }
+    case __pbuf_get_contiguous: {
+        __pbuf_get_contiguous_req *r = (__pbuf_get_contiguous_req *)req;
+        *(r->ret) = __real_pbuf_get_contiguous(r->p, r->buffer, r->bufsize, r->len, r->offset);
+        break;
+    }
+    case __pbuf_cat: {
+        __pbuf_cat_req *r = (__pbuf_cat_req *)req;
+        __real_pbuf_cat(r->head, r->tail);
+        break;
+    }
+    case __tcp_arg: {
+        __tcp_arg_req *r = (__tcp_arg_req *)req;
+        __real_tcp_arg(r->pcb, r->arg);
+        break;
+    }
+    case __tcp_new: {
+        __tcp_new_req *r = (__tcp_new_req *)req;
+        *(r->ret) = __real_tcp_new();
+        break;
+    }
+    case __tcp_new_ip_type: {
+        __tcp_new_ip_type_req *r = (__tcp_new_ip_type_req *)req;
+        *(r->ret) = __real_tcp_new_ip_type(r->type);
+        break;
+    }
+    case __tcp_bind: {
+        __tcp_bind_req *r = (__tcp_bind_req *)req;
+        *(r->ret) = __real_tcp_bind(r->pcb, r->ipaddr, r->port);
+        break;
+    }
+    case __tcp_bind_netif: {
+        __tcp_bind_netif_req *r = (__tcp_bind_netif_req *)req;
+        *(r->ret) = __real_tcp_bind_netif(r->pcb, r->netif);
+        break;
+    }
+    case __tcp_listen_with_backlog: {
+        __tcp_listen_with_backlog_req *r = (__tcp_listen_with_backlog_req *)req;
+        *(r->ret) = __real_tcp_listen_with_backlog(r->pcb, r->backlog);
+        break;
+    }
+#if 0
+    case __tcp_listen_with_backlog_and_err: {
+        __tcp_listen_with_backlog_and_err_req *r = (__tcp_listen_with_backlog_and_err_req *)req;
+        *(r->ret) = __real_tcp_listen_with_backlog_and_err(r->pcb, r->backlog, r->err);
+        break;
+    }
+#endif
+    case __tcp_accept: {
+        __tcp_accept_req *r = (__tcp_accept_req *)req;
+        __real_tcp_accept(r->pcb, r->accept);
+        break;
+    }
+    case __tcp_connect: {
+        __tcp_connect_req *r = (__tcp_connect_req *)req;
+        *(r->ret) = __real_tcp_connect(r->pcb, r->ipaddr, r->port, r->connected);
+        break;
+    }
+    case __tcp_write: {
+        __tcp_write_req *r = (__tcp_write_req *)req;
+        *(r->ret) = __real_tcp_write(r->pcb, r->dataptr, r->len, r->apiflags);
+        break;
+    }
+    case __tcp_sent: {
+        __tcp_sent_req *r = (__tcp_sent_req *)req;
+        __real_tcp_sent(r->pcb, r->sent);
+        break;
+    }
+    case __tcp_recv: {
+        __tcp_recv_req *r = (__tcp_recv_req *)req;
+        __real_tcp_recv(r->pcb, r->recv);
+        break;
+    }
+    case __tcp_recved: {
+        __tcp_recved_req *r = (__tcp_recved_req *)req;
+        __real_tcp_recved(r->pcb, r->len);
+        break;
+    }
+    case __tcp_poll: {
+        __tcp_poll_req *r = (__tcp_poll_req *)req;
+        __real_tcp_poll(r->pcb, r->poll, r->interval);
+        break;
+    }
+    case __tcp_close: {
+        __tcp_close_req *r = (__tcp_close_req *)req;
+        *(r->ret) = __real_tcp_close(r->pcb);
+        break;
+    }
+    case __tcp_abort: {
+        __tcp_abort_req *r = (__tcp_abort_req *)req;
+        __real_tcp_abort(r->pcb);
+        break;
+    }
+    case __tcp_err: {
+        __tcp_err_req *r = (__tcp_err_req *)req;
+        __real_tcp_err(r->pcb, r->err);
+        break;
+    }
+    case __tcp_output: {
+        __tcp_output_req *r = (__tcp_output_req *)req;
+        err_t ret = __real_tcp_output(r->pcb);
+        if (r->ret) {
+            *(r->ret) = ret;
+        }
+        break;
+    }
+    case __tcp_setprio: {
+        __tcp_setprio_req *r = (__tcp_setprio_req *)req;
+        __real_tcp_setprio(r->pcb, r->prio);
+        break;
+    }
+    case __tcp_shutdown: {
+        __tcp_shutdown_req *r = (__tcp_shutdown_req *)req;
+        *(r->ret) = __real_tcp_shutdown(r->pcb, r->shut_rx, r->shut_tx);
+        break;
+    }
+    case __tcp_backlog_delayed: {
+        __tcp_backlog_delayed_req *r = (__tcp_backlog_delayed_req *)req;
+        __real_tcp_backlog_delayed(r->pcb);
+        break;
+    }
+    case __tcp_backlog_accepted: {
+        __tcp_backlog_accepted_req *r = (__tcp_backlog_accepted_req *)req;
+        __real_tcp_backlog_accepted(r->pcb);
+        break;
+    }
+    case __udp_new: {
+        __udp_new_req *r = (__udp_new_req *)req;
+        *(r->ret) = __real_udp_new();
+        break;
+    }
+    case __udp_new_ip_type: {
+        __udp_new_ip_type_req *r = (__udp_new_ip_type_req *)req;
+        *(r->ret) = __real_udp_new_ip_type(r->type);
+        break;
+    }
+    case  __udp_remove: {
+        __udp_remove_req *r = (__udp_remove_req *)req;
+        __real_udp_remove(r->pcb);
+        break;
+    }
+    case __udp_bind: {
+        __udp_bind_req *r = (__udp_bind_req *)req;
+        *(r->ret) = __real_udp_bind(r->pcb, r->ipaddr, r->port);
+        break;
+    }
+    case __udp_connect: {
+        __udp_connect_req *r = (__udp_connect_req *)req;
+        *(r->ret) = __real_udp_connect(r->pcb, r->ipaddr, r->port);
+        break;
+    }
+    case __udp_disconnect: {
+        __udp_disconnect_req *r = (__udp_disconnect_req *)req;
+        *(r->ret) = __real_udp_disconnect(r->pcb);
+        break;
+    }
+    case __udp_send: {
+        __udp_send_req *r = (__udp_send_req *)req;
+        *(r->ret) = __real_udp_send(r->pcb, r->p);
+        break;
+    }
+    case __udp_recv: {
+        __udp_recv_req *r = (__udp_recv_req *)req;
+        __real_udp_recv(r->pcb, r->recv, r->recv_arg);
+        break;
+    }
+    case __udp_sendto: {
+        __udp_sendto_req *r = (__udp_sendto_req *)req;
+        *(r->ret) = __real_udp_sendto(r->pcb, r->p, r->dst_ip, r->dst_port);
+        break;
+    }
+    case __udp_sendto_if: {
+        __udp_sendto_if_req *r = (__udp_sendto_if_req *)req;
+        *(r->ret) = __real_udp_sendto_if(r->pcb, r->p, r->dst_ip, r->dst_port, r->netif);
+        break;
+    }
+    case __udp_sendto_if_src: {
+        __udp_sendto_if_src_req *r = (__udp_sendto_if_src_req *)req;
+        *(r->ret) = __real_udp_sendto_if_src(r->pcb, r->p, r->dst_ip, r->dst_port, r->netif, r->src_ip);
+        break;
+    }
+    case __sys_check_timeouts: {
+        __real_sys_check_timeouts();
+        break;
+    }
+    case __dns_gethostbyname: {
+        __dns_gethostbyname_req *r = (__dns_gethostbyname_req *)req;
+        *(r->ret) = __real_dns_gethostbyname(r->hostname, r->addr, r->found, r->callback_arg);
+        break;
+    }
+    case __dns_gethostbyname_addrtype: {
+        __dns_gethostbyname_addrtype_req *r = (__dns_gethostbyname_addrtype_req *)req;
+        *(r->ret) = __real_dns_gethostbyname_addrtype(r->hostname, r->addr, r->found, r->callback_arg, r->dns_addrtype);
+        break;
+    }
+    case __igmp_start: {
+        __igmp_start_req *r = (__igmp_start_req *)req;
+        *(r->ret) = __real_igmp_start(r->netif);
+        break;
+    }
+    case __igmp_stop: {
+        __igmp_stop_req *r = (__igmp_stop_req *)req;
+        *(r->ret) = __real_igmp_stop(r->netif);
+        break;
+    }
+    case __igmp_report_groups: {
+        __igmp_report_groups_req *r = (__igmp_report_groups_req *)req;
+        __real_igmp_report_groups(r->netif);
+        break;
+    }
+    case __igmp_lookfor_group: {
+        __igmp_lookfor_group_req *r = (__igmp_lookfor_group_req *)req;
+        *(r->ret) = __real_igmp_lookfor_group(r->ifp, r->addr);
+        break;
+    }
+    case __igmp_joingroup: {
+        __igmp_joingroup_req *r = (__igmp_joingroup_req *)req;
+        *(r->ret) = __real_igmp_joingroup(r->ifaddr, r->groupaddr);
+        break;
+    }
+    case __igmp_joingroup_netif: {
+        __igmp_joingroup_netif_req *r = (__igmp_joingroup_netif_req *)req;
+        *(r->ret) = __real_igmp_joingroup_netif(r->netif, r->groupaddr);
+        break;
+    }
+    case __igmp_leavegroup: {
+        __igmp_leavegroup_req *r = (__igmp_leavegroup_req *)req;
+        *(r->ret) = __real_igmp_leavegroup(r->ifaddr, r->groupaddr);
+        break;
+    }
+    case __igmp_leavegroup_netif: {
+        __igmp_leavegroup_netif_req *r = (__igmp_leavegroup_netif_req *)req;
+        *(r->ret) = __real_igmp_leavegroup_netif(r->netif, r->groupaddr);
+        break;
+    }
+#if LWIP_IPV6
+    case __mld6_stop: {
+        __mld6_stop_req *r = (__mld6_stop_req *)req;
+        *(r->ret) = __real_mld6_stop(r->netif);
+        break;
+    }
+    case __mld6_report_groups: {
+        __mld6_report_groups_req *r = (__mld6_report_groups_req *)req;
+        __real_mld6_report_groups(r->netif);
+        break;
+    }
+    case __mld6_lookfor_group: {
+        __mld6_lookfor_group_req *r = (__mld6_lookfor_group_req *)req;
+        *(r->ret) = __real_mld6_lookfor_group(r->ifp, r->addr);
+        break;
+    }
+    case __mld6_joingroup: {
+        __mld6_joingroup_req *r = (__mld6_joingroup_req *)req;
+        *(r->ret) = __real_mld6_joingroup(r->srcaddr, r->groupaddr);
+        break;
+    }
+    case __mld6_joingroup_netif: {
+        __mld6_joingroup_netif_req *r = (__mld6_joingroup_netif_req *)req;
+        *(r->ret) = __real_mld6_joingroup_netif(r->netif, r->groupaddr);
+        break;
+    }
+    case __mld6_leavegroup: {
+        __mld6_leavegroup_req *r = (__mld6_leavegroup_req *)req;
+        *(r->ret) = __real_mld6_leavegroup(r->srcaddr, r->groupaddr);
+        break;
+    }
+    case __mld6_leavegroup_netif: {
+        __mld6_leavegroup_netif_req *r = (__mld6_leavegroup_netif_req *)req;
+        (*r->ret) = __real_mld6_leavegroup_netif(r->netif, r->groupaddr);
+        break;
+    }
+#endif
+    case __raw_new: {
+        __raw_new_req *r = (__raw_new_req *)req;
+        *(r->ret) = __real_raw_new(r->proto);
+        break;
+    }
+    case __raw_new_ip_type: {
+        __raw_new_ip_type_req *r = (__raw_new_ip_type_req *)req;
+        *(r->ret) = __real_raw_new_ip_type(r->type, r->proto);
+        break;
+    }
+    case __raw_connect: {
+        __raw_connect_req *r = (__raw_connect_req *)req;
+        *(r->ret) = __real_raw_connect(r->pcb, r->ipaddr);
+        break;
+    }
+    case __raw_recv: {
+        __raw_recv_req *r = (__raw_recv_req *)req;
+        __real_raw_recv(r->pcb, r->recv, r->recv_arg);
+        break;
+    }
+    case __raw_bind: {
+        __raw_bind_req *r = (__raw_bind_req *)req;
+        *(r->ret) = __real_raw_bind(r->pcb, r->ipaddr);
+        break;
+    }
+    case __raw_sendto: {
+        __raw_sendto_req *r = (__raw_sendto_req *)req;
+        *(r->ret) = __real_raw_sendto(r->pcb, r->p, r->ipaddr);
+        break;
+    }
+    case __raw_send: {
+        __raw_send_req *r = (__raw_send_req *)req;
+        *(r->ret) = __real_raw_send(r->pcb, r->p);
+        break;
+    }
+    case __raw_remove: {
+        __raw_remove_req *r = (__raw_remove_req *)req;
+        __real_raw_remove(r->pcb);
+        break;
+    }
+    case __netif_add: {
+        __netif_add_req *r = (__netif_add_req *)req;
+        *(r->ret) = __real_netif_add(r->netif, r->ipaddr, r->netmask, r->gw, r->state, r->init, r->input);
+        break;
+    }
+    case __netif_remove: {
+        __netif_remove_req *r = (__netif_remove_req *)req;
+        __real_netif_remove(r->netif);
+        break;
+    }
+    case __netif_set_link_up: {
+        __netif_set_link_up_req *r = (__netif_set_link_up_req *)req;
+        __real_netif_set_link_up(r->netif);
+        break;
+    }
+    case __netif_set_up: {
+        __netif_set_up_req *r = (__netif_set_up_req *)req;
+        __real_netif_set_up(r->netif);
+        break;
+    }
+#if LWIP_IPV6
+    case __netif_create_ip6_linklocal_address: {
+        __netif_create_ip6_linklocal_address_req *r = (__netif_create_ip6_linklocal_address_req *)req;
+        __real_netif_create_ip6_linklocal_address(r->netif, r->from_mac_48bit);
+        break;
+    }
+#endif
+    case __ethernet_input: {
+        __ethernet_input_req *r = (__ethernet_input_req *)req;
+        *(r->ret) = __real_ethernet_input(r->p, r->netif);
+        break;
+    }
+#if defined(PICO_CYW43_SUPPORTED)
+    case __cyw43_wifi_join: {
+        __cyw43_wifi_join_req *r = (__cyw43_wifi_join_req *)req;
+        *(r->ret) = __real_cyw43_wifi_join(r->self, r->ssid_len, r->ssid, r->key_len, r->key, r->auth_type, r->bssid, r->channel);
+        break;
+    }
+    case __cyw43_wifi_leave: {
+        __cyw43_wifi_leave_req *r = (__cyw43_wifi_leave_req*)req;
+        *(r->ret) = __real_cyw43_wifi_leave(r->self, r->itf);
+        break;
+    }
+#endif
+    case __callback: {
+        __callback_req *r = (__callback_req *)req;
+        r->cb(r->cbData);
+        break;
+    }
+    default: {
+        // Any new unimplemented calls = ERROR!!!
+        panic("Unimplemented LWIP thread action");
+        break;
+    }
+    }
 }
 
 static void lwipThread(void *params) {
@@ -102,409 +625,22 @@ static void lwipThread(void *params) {
     while (true) {
         auto ret = xQueueReceive(__lwipQueue, &w, scd);
         if (ret) {
-            switch (w.op) {
-            case __lwip_init: {
-                __real_lwip_init();
-                break;
-            }
-            case __pbuf_header: {
-                __pbuf_header_req *r = (__pbuf_header_req *)w.req;
-                *(r->ret) = __real_pbuf_header(r->p, r->header_size);
-                break;
-            }
-            case __pbuf_free: {
-                __pbuf_free_req *r = (__pbuf_free_req *)w.req;
-                *(r->ret) = __real_pbuf_free(r->p);
-                break;
-            }
-            case __pbuf_alloc: {
-                __pbuf_alloc_req *r = (__pbuf_alloc_req *)w.req;
-                *(r->ret) = __real_pbuf_alloc(r->l, r->length, r->type);
-                break;
-            }
-            case __pbuf_take: {
-                __pbuf_take_req *r = (__pbuf_take_req *)w.req;
-                *(r->ret) = __real_pbuf_take(r->buf, r->dataptr, r->len);
-                break;
-            }
-            case __pbuf_copy_partial: {
-                __pbuf_copy_partial_req *r = (__pbuf_copy_partial_req *)w.req;
-                *(r->ret) = __real_pbuf_copy_partial(r->p, r->dataptr, r->len, r->offset);
-                break;
-            }
-            case __pbuf_ref: {
-                __pbuf_ref_req *r = (__pbuf_ref_req *)w.req;
-                __real_pbuf_ref(r->p);
-                break;
-            }
-            case __pbuf_get_at: {
-                __pbuf_get_at_req *r = (__pbuf_get_at_req *)w.req;
-                *(r->ret) = __real_pbuf_get_at(r->p, r->offset);
-                break;
-            }
-            case __pbuf_get_contiguous: {
-                __pbuf_get_contiguous_req *r = (__pbuf_get_contiguous_req *)w.req;
-                *(r->ret) = __real_pbuf_get_contiguous(r->p, r->buffer, r->bufsize, r->len, r->offset);
-                break;
-            }
-            case __pbuf_cat: {
-                __pbuf_cat_req *r = (__pbuf_cat_req *)w.req;
-                __real_pbuf_cat(r->head, r->tail);
-                break;
-            }
-            case __tcp_arg: {
-                __tcp_arg_req *r = (__tcp_arg_req *)w.req;
-                __real_tcp_arg(r->pcb, r->arg);
-                break;
-            }
-            case __tcp_new: {
-                __tcp_new_req *r = (__tcp_new_req *)w.req;
-                *(r->ret) = __real_tcp_new();
-                break;
-            }
-            case __tcp_new_ip_type: {
-                __tcp_new_ip_type_req *r = (__tcp_new_ip_type_req *)w.req;
-                *(r->ret) = __real_tcp_new_ip_type(r->type);
-                break;
-            }
-            case __tcp_bind: {
-                __tcp_bind_req *r = (__tcp_bind_req *)w.req;
-                *(r->ret) = __real_tcp_bind(r->pcb, r->ipaddr, r->port);
-                break;
-            }
-            case __tcp_bind_netif: {
-                __tcp_bind_netif_req *r = (__tcp_bind_netif_req *)w.req;
-                *(r->ret) = __real_tcp_bind_netif(r->pcb, r->netif);
-                break;
-            }
-            case __tcp_listen_with_backlog: {
-                __tcp_listen_with_backlog_req *r = (__tcp_listen_with_backlog_req *)w.req;
-                *(r->ret) = __real_tcp_listen_with_backlog(r->pcb, r->backlog);
-                break;
-            }
-#if 0
-            case __tcp_listen_with_backlog_and_err: {
-                __tcp_listen_with_backlog_and_err_req *r = (__tcp_listen_with_backlog_and_err_req *)w.req;
-                *(r->ret) = __real_tcp_listen_with_backlog_and_err(r->pcb, r->backlog, r->err);
-                break;
-            }
-#endif
-            case __tcp_accept: {
-                __tcp_accept_req *r = (__tcp_accept_req *)w.req;
-                __real_tcp_accept(r->pcb, r->accept);
-                break;
-            }
-            case __tcp_connect: {
-                __tcp_connect_req *r = (__tcp_connect_req *)w.req;
-                *(r->ret) = __real_tcp_connect(r->pcb, r->ipaddr, r->port, r->connected);
-                break;
-            }
-            case __tcp_write: {
-                __tcp_write_req *r = (__tcp_write_req *)w.req;
-                *(r->ret) = __real_tcp_write(r->pcb, r->dataptr, r->len, r->apiflags);
-                break;
-            }
-            case __tcp_sent: {
-                __tcp_sent_req *r = (__tcp_sent_req *)w.req;
-                __real_tcp_sent(r->pcb, r->sent);
-                break;
-            }
-            case __tcp_recv: {
-                __tcp_recv_req *r = (__tcp_recv_req *)w.req;
-                __real_tcp_recv(r->pcb, r->recv);
-                break;
-            }
-            case __tcp_recved: {
-                __tcp_recved_req *r = (__tcp_recved_req *)w.req;
-                __real_tcp_recved(r->pcb, r->len);
-                break;
-            }
-            case __tcp_poll: {
-                __tcp_poll_req *r = (__tcp_poll_req *)w.req;
-                __real_tcp_poll(r->pcb, r->poll, r->interval);
-                break;
-            }
-            case __tcp_close: {
-                __tcp_close_req *r = (__tcp_close_req *)w.req;
-                *(r->ret) = __real_tcp_close(r->pcb);
-                break;
-            }
-            case __tcp_abort: {
-                __tcp_abort_req *r = (__tcp_abort_req *)w.req;
-                __real_tcp_abort(r->pcb);
-                break;
-            }
-            case __tcp_err: {
-                __tcp_err_req *r = (__tcp_err_req *)w.req;
-                __real_tcp_err(r->pcb, r->err);
-                break;
-            }
-            case __tcp_output: {
-                __tcp_output_req *r = (__tcp_output_req *)w.req;
-                *(r->ret) = __real_tcp_output(r->pcb);
-                break;
-            }
-            case __tcp_setprio: {
-                __tcp_setprio_req *r = (__tcp_setprio_req *)w.req;
-                __real_tcp_setprio(r->pcb, r->prio);
-                break;
-            }
-            case __tcp_shutdown: {
-                __tcp_shutdown_req *r = (__tcp_shutdown_req *)w.req;
-                *(r->ret) = __real_tcp_shutdown(r->pcb, r->shut_rx, r->shut_tx);
-                break;
-            }
-            case __tcp_backlog_delayed: {
-                __tcp_backlog_delayed_req *r = (__tcp_backlog_delayed_req *)w.req;
-                __real_tcp_backlog_delayed(r->pcb);
-                break;
-            }
-            case __tcp_backlog_accepted: {
-                __tcp_backlog_accepted_req *r = (__tcp_backlog_accepted_req *)w.req;
-                __real_tcp_backlog_accepted(r->pcb);
-                break;
-            }
-            case __udp_new: {
-                __udp_new_req *r = (__udp_new_req *)w.req;
-                *(r->ret) = __real_udp_new();
-                break;
-            }
-            case __udp_new_ip_type: {
-                __udp_new_ip_type_req *r = (__udp_new_ip_type_req *)w.req;
-                *(r->ret) = __real_udp_new_ip_type(r->type);
-                break;
-            }
-            case  __udp_remove: {
-                __udp_remove_req *r = (__udp_remove_req *)w.req;
-                __real_udp_remove(r->pcb);
-                break;
-            }
-            case __udp_bind: {
-                __udp_bind_req *r = (__udp_bind_req *)w.req;
-                *(r->ret) = __real_udp_bind(r->pcb, r->ipaddr, r->port);
-                break;
-            }
-            case __udp_connect: {
-                __udp_connect_req *r = (__udp_connect_req *)w.req;
-                *(r->ret) = __real_udp_connect(r->pcb, r->ipaddr, r->port);
-                break;
-            }
-            case __udp_disconnect: {
-                __udp_disconnect_req *r = (__udp_disconnect_req *)w.req;
-                *(r->ret) = __real_udp_disconnect(r->pcb);
-                break;
-            }
-            case __udp_send: {
-                __udp_send_req *r = (__udp_send_req *)w.req;
-                *(r->ret) = __real_udp_send(r->pcb, r->p);
-                break;
-            }
-            case __udp_recv: {
-                __udp_recv_req *r = (__udp_recv_req *)w.req;
-                __real_udp_recv(r->pcb, r->recv, r->recv_arg);
-                break;
-            }
-            case __udp_sendto: {
-                __udp_sendto_req *r = (__udp_sendto_req *)w.req;
-                *(r->ret) = __real_udp_sendto(r->pcb, r->p, r->dst_ip, r->dst_port);
-                break;
-            }
-            case __udp_sendto_if: {
-                __udp_sendto_if_req *r = (__udp_sendto_if_req *)w.req;
-                *(r->ret) = __real_udp_sendto_if(r->pcb, r->p, r->dst_ip, r->dst_port, r->netif);
-                break;
-            }
-            case __udp_sendto_if_src: {
-                __udp_sendto_if_src_req *r = (__udp_sendto_if_src_req *)w.req;
-                *(r->ret) = __real_udp_sendto_if_src(r->pcb, r->p, r->dst_ip, r->dst_port, r->netif, r->src_ip);
-                break;
-            }
-            case __sys_check_timeouts: {
-                __real_sys_check_timeouts();
-                break;
-            }
-            case __dns_gethostbyname: {
-                __dns_gethostbyname_req *r = (__dns_gethostbyname_req *)w.req;
-                *(r->ret) = __real_dns_gethostbyname(r->hostname, r->addr, r->found, r->callback_arg);
-                break;
-            }
-            case __dns_gethostbyname_addrtype: {
-                __dns_gethostbyname_addrtype_req *r = (__dns_gethostbyname_addrtype_req *)w.req;
-                *(r->ret) = __real_dns_gethostbyname_addrtype(r->hostname, r->addr, r->found, r->callback_arg, r->dns_addrtype);
-                break;
-            }
-            case __igmp_start: {
-                __igmp_start_req *r = (__igmp_start_req *)w.req;
-                *(r->ret) = __real_igmp_start(r->netif);
-                break;
-            }
-            case __igmp_stop: {
-                __igmp_stop_req *r = (__igmp_stop_req *)w.req;
-                *(r->ret) = __real_igmp_stop(r->netif);
-                break;
-            }
-            case __igmp_report_groups: {
-                __igmp_report_groups_req *r = (__igmp_report_groups_req *)w.req;
-                __real_igmp_report_groups(r->netif);
-                break;
-            }
-            case __igmp_lookfor_group: {
-                __igmp_lookfor_group_req *r = (__igmp_lookfor_group_req *)w.req;
-                *(r->ret) = __real_igmp_lookfor_group(r->ifp, r->addr);
-                break;
-            }
-            case __igmp_joingroup: {
-                __igmp_joingroup_req *r = (__igmp_joingroup_req *)w.req;
-                *(r->ret) = __real_igmp_joingroup(r->ifaddr, r->groupaddr);
-                break;
-            }
-            case __igmp_joingroup_netif: {
-                __igmp_joingroup_netif_req *r = (__igmp_joingroup_netif_req *)w.req;
-                *(r->ret) = __real_igmp_joingroup_netif(r->netif, r->groupaddr);
-                break;
-            }
-            case __igmp_leavegroup: {
-                __igmp_leavegroup_req *r = (__igmp_leavegroup_req *)w.req;
-                *(r->ret) = __real_igmp_leavegroup(r->ifaddr, r->groupaddr);
-                break;
-            }
-            case __igmp_leavegroup_netif: {
-                __igmp_leavegroup_netif_req *r = (__igmp_leavegroup_netif_req *)w.req;
-                *(r->ret) = __real_igmp_leavegroup_netif(r->netif, r->groupaddr);
-                break;
-            }
-#if LWIP_IPV6
-            case __mld6_stop: {
-                __mld6_stop_req *r = (__mld6_stop_req *)w.req;
-                *(r->ret) = __real_mld6_stop(r->netif);
-                break;
-            }
-            case __mld6_report_groups: {
-                __mld6_report_groups_req *r = (__mld6_report_groups_req *)w.req;
-                __real_mld6_report_groups(r->netif);
-                break;
-            }
-            case __mld6_lookfor_group: {
-                __mld6_lookfor_group_req *r = (__mld6_lookfor_group_req *)w.req;
-                *(r->ret) = __real_mld6_lookfor_group(r->ifp, r->addr);
-                break;
-            }
-            case __mld6_joingroup: {
-                __mld6_joingroup_req *r = (__mld6_joingroup_req *)w.req;
-                *(r->ret) = __real_mld6_joingroup(r->srcaddr, r->groupaddr);
-                break;
-            }
-            case __mld6_joingroup_netif: {
-                __mld6_joingroup_netif_req *r = (__mld6_joingroup_netif_req *)w.req;
-                *(r->ret) = __real_mld6_joingroup_netif(r->netif, r->groupaddr);
-                break;
-            }
-            case __mld6_leavegroup: {
-                __mld6_leavegroup_req *r = (__mld6_leavegroup_req *)w.req;
-                *(r->ret) = __real_mld6_leavegroup(r->srcaddr, r->groupaddr);
-                break;
-            }
-            case __mld6_leavegroup_netif: {
-                __mld6_leavegroup_netif_req *r = (__mld6_leavegroup_netif_req *)w.req;
-                (*r->ret) = __real_mld6_leavegroup_netif(r->netif, r->groupaddr);
-                break;
-            }
-#endif
-            case __raw_new: {
-                __raw_new_req *r = (__raw_new_req *)w.req;
-                *(r->ret) = __real_raw_new(r->proto);
-                break;
-            }
-            case __raw_new_ip_type: {
-                __raw_new_ip_type_req *r = (__raw_new_ip_type_req *)w.req;
-                *(r->ret) = __real_raw_new_ip_type(r->type, r->proto);
-                break;
-            }
-            case __raw_connect: {
-                __raw_connect_req *r = (__raw_connect_req *)w.req;
-                *(r->ret) = __real_raw_connect(r->pcb, r->ipaddr);
-                break;
-            }
-            case __raw_recv: {
-                __raw_recv_req *r = (__raw_recv_req *)w.req;
-                __real_raw_recv(r->pcb, r->recv, r->recv_arg);
-                break;
-            }
-            case __raw_bind: {
-                __raw_bind_req *r = (__raw_bind_req *)w.req;
-                *(r->ret) = __real_raw_bind(r->pcb, r->ipaddr);
-                break;
-            }
-            case __raw_sendto: {
-                __raw_sendto_req *r = (__raw_sendto_req *)w.req;
-                *(r->ret) = __real_raw_sendto(r->pcb, r->p, r->ipaddr);
-                break;
-            }
-            case __raw_send: {
-                __raw_send_req *r = (__raw_send_req *)w.req;
-                *(r->ret) = __real_raw_send(r->pcb, r->p);
-                break;
-            }
-            case __raw_remove: {
-                __raw_remove_req *r = (__raw_remove_req *)w.req;
-                __real_raw_remove(r->pcb);
-                break;
-            }
-            case __netif_add: {
-                __netif_add_req *r = (__netif_add_req *)w.req;
-                *(r->ret) = __real_netif_add(r->netif, r->ipaddr, r->netmask, r->gw, r->state, r->init, r->input);
-                break;
-            }
-            case __netif_remove: {
-                __netif_remove_req *r = (__netif_remove_req *)w.req;
-                __real_netif_remove(r->netif);
-                break;
-            }
-            case __netif_set_link_up: {
-                __netif_set_link_up_req *r = (__netif_set_link_up_req *)w.req;
-                __real_netif_set_link_up(r->netif);
-                break;
-            }
-            case __netif_set_up: {
-                __netif_set_up_req *r = (__netif_set_up_req *)w.req;
-                __real_netif_set_up(r->netif);
-                break;
-            }
-#if LWIP_IPV6
-            case __netif_create_ip6_linklocal_address: {
-                __netif_create_ip6_linklocal_address_req *r = (__netif_create_ip6_linklocal_address_req *)w.req;
-                __real_netif_create_ip6_linklocal_address(r->netif, r->from_mac_48bit);
-                break;
-            }
-#endif
-            case __ethernet_input: {
-                __ethernet_input_req *r = (__ethernet_input_req *)w.req;
-                *(r->ret) = __real_ethernet_input(r->p, r->netif);
-                break;
-            }
-#if defined(PICO_CYW43_SUPPORTED)
-            case __cyw43_wifi_join: {
-                __cyw43_wifi_join_req *r = (__cyw43_wifi_join_req *)w.req;
-                *(r->ret) = __real_cyw43_wifi_join(r->self, r->ssid_len, r->ssid, r->key_len, r->key, r->auth_type, r->bssid, r->channel);
-                break;
-            }
-            case __cyw43_wifi_leave: {
-                __cyw43_wifi_leave_req *r = (__cyw43_wifi_leave_req*)w.req;
-                *(r->ret) = __real_cyw43_wifi_leave(r->self, r->itf);
-                break;
-            }
-#endif
-            case __callback: {
-                __callback_req *r = (__callback_req *)w.req;
-                r->cb(r->cbData);
-                break;
-            }
-            default: {
-                // Any new unimplemented calls = ERROR!!!
-                panic("Unimplemented LWIP thread action");
-                break;
-            }
-            }
+            // Async requests were copied into the queue entry itself
+            void *req = w.req ? w.req : &w.data;
+            uint32_t start = __cycleCount();
+            TRACE_EVENT(TRACE_LWIP_ENTER, w.op);
+            if (w.op == __batch) {
+                __batch_req *b = (__batch_req *)req;
+                for (size_t i = 0; i < b->count; i++) {
+                    uint32_t itemStart = __cycleCount();
+                    __lwipDispatch(b->items[i].op, b->items[i].req);
+                    __lwipStatsAdd(b->items[i].op, itemStart - w.queued, __cycleCount() - itemStart);
+                }
+            } else {
+                __lwipDispatch(w.op, req);
+            }
+            TRACE_EVENT(TRACE_LWIP_EXIT, w.op);
+            __lwipStatsAdd(w.op, start - w.queued, __cycleCount() - start);
             // Work done, return value set, just tickle the calling task
             if (w.wakeup) {
                 xTaskNotifyGiveIndexed(w.wakeup, TASK_NOTIFY_LWIP_WAKEUP);
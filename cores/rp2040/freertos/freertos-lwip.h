@@ -28,6 +28,13 @@ void __startLWIPThread();
 // Send an LWIP request to the task.  Will block unless fromISR==true
 extern "C" void __lwip(__lwip_op op, void *req, bool fromISR);
 
+// Post a request without waiting for it.  The request is copied, so it may be
+// on the caller's stack, but any return pointers in it must be nullptr.
+extern "C" void __lwip_async(__lwip_op op, const void *req, size_t len);
+
+// Run several requests back-to-back in the LWIP task with a single wakeup
+extern "C" void __lwip_batch(const __lwip_batch_item *items, size_t count);
+
 // Return true if __real_LWIP ops are safe (i.e. this is the LWIP thread)
 extern "C" bool __isLWIPThread();
 
@@ -26,6 +26,7 @@
 #include <sys/lock.h>
 
 #include "_freertos.h"
+#include "LockStats.h"
 
 // HACK ALERT
 // Pico-SDK defines mutex which can be at global scope, but when the auto_init_
@@ -147,29 +148,57 @@ void __retarget_lock_close_recursive(_LOCK_T lock) {
 }
 
 void __retarget_lock_acquire(_LOCK_T lock) {
+    uint32_t start = lock_stats ? __lockStatsNow() : 0;
+    bool contended = false;
 #ifdef __FREERTOS
     if (__freeRTOSinitted) {
         auto mtx = __getFreeRTOSMutex(lock);
-        xSemaphoreTake(mtx, portMAX_DELAY);
+        if (!xSemaphoreTake(mtx, 0)) {
+            contended = true;
+            xSemaphoreTake(mtx, portMAX_DELAY);
+        }
     } else {
-        mutex_enter_blocking((mutex_t*)lock);
+        if (!mutex_try_enter((mutex_t*)lock, nullptr)) {
+            contended = true;
+            mutex_enter_blocking((mutex_t*)lock);
+        }
     }
 #else
-    mutex_enter_blocking((mutex_t*)lock);
+    if (!mutex_try_enter((mutex_t*)lock, nullptr)) {
+        contended = true;
+        mutex_enter_blocking((mutex_t*)lock);
+    }
 #endif
+    if (lock_stats) {
+        __lockStatsAcquired(lock, start, contended);
+    }
 }
 
 void __retarget_lock_acquire_recursive(_LOCK_T lock) {
+    uint32_t start = lock_stats ? __lockStatsNow() : 0;
+    bool contended = false;
 #ifdef __FREERTOS
     if (__freeRTOSinitted) {
         auto mtx = __getFreeRTOSRecursiveMutex(lock);
-        xSemaphoreTakeRecursive(mtx, portMAX_DELAY);
+        if (!xSemaphoreTakeRecursive(mtx, 0)) {
+            contended = true;
+            xSemaphoreTakeRecursive(mtx, portMAX_DELAY);
+        }
     } else {
-        recursive_mutex_enter_blocking((recursive_mutex_t*)lock);
+        if (!recursive_mutex_try_enter((recursive_mutex_t*)lock, nullptr)) {
+            contended = true;
+            recursive_mutex_enter_blocking((recursive_mutex_t*)lock);
+        }
     }
 #else
-    recursive_mutex_enter_blocking((recursive_mutex_t*)lock);
+    if (!recursive_mutex_try_enter((recursive_mutex_t*)lock, nullptr)) {
+        contended = true;
+        recursive_mutex_enter_blocking((recursive_mutex_t*)lock);
+    }
 #endif
+    if (lock_stats) {
+        __lockStatsAcquired(lock, start, contended);
+    }
 }
 
 int __retarget_lock_try_acquire(_LOCK_T lock) {
@@ -184,6 +213,9 @@ int __retarget_lock_try_acquire(_LOCK_T lock) {
 #else
     ret = mutex_try_enter((mutex_t *)lock, nullptr);
 #endif
+    if (ret && lock_stats) {
+        __lockStatsAcquired(lock, __lockStatsNow(), false);
+    }
     return ret;
 }
 
@@ -199,10 +231,16 @@ int __retarget_lock_try_acquire_recursive(_LOCK_T lock) {
 #else
     ret = recursive_mutex_try_enter((recursive_mutex_t*)lock, nullptr);
 #endif
+    if (ret && lock_stats) {
+        __lockStatsAcquired(lock, __lockStatsNow(), false);
+    }
     return ret;
 }
 
 void __retarget_lock_release(_LOCK_T lock) {
+    if (lock_stats) {
+        __lockStatsReleased(lock);
+    }
 #ifdef __FREERTOS
     if (__freeRTOSinitted) {
         auto mtx = __getFreeRTOSMutex(lock);
@@ -216,6 +254,9 @@ void __retarget_lock_release(_LOCK_T lock) {
 }
 
 void __retarget_lock_release_recursive(_LOCK_T lock) {
+    if (lock_stats) {
+        __lockStatsReleased(lock);
+    }
 #ifdef __FREERTOS
     if (__freeRTOSinitted) {
         auto mtx = __getFreeRTOSRecursiveMutex(lock);
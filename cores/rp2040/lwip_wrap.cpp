@@ -60,6 +60,9 @@ extern "C" {
     void __wrap_lwip_init() {
         if (!_lwip_rng) {
             recursive_mutex_init(&__lwipMutex);
+            if (lock_stats) {
+                lockStatsName(&__lwipMutex, "lwIP");
+            }
             _lwip_rng = new XoshiroCpp::Xoshiro256PlusPlus(micros());
             {
                 LWIPMutex m;
@@ -89,10 +92,10 @@ extern "C" {
     u8_t __wrap_pbuf_free(struct pbuf *p) {
 #ifdef __FREERTOS
         if (!__isLWIPThread()) {
-            u8_t ret;
-            __pbuf_free_req req = { p, &ret };
-            __lwip(__pbuf_free, &req);
-            return ret;
+            // Nothing checks how many pbufs were released, so don't wait around to find out
+            __pbuf_free_req req = { p, nullptr };
+            __lwip_async(__pbuf_free, &req, sizeof(req));
+            return 0;
         }
 #endif
         LWIPMutex m;
@@ -368,7 +371,7 @@ extern "C" {
 #ifdef __FREERTOS
         if (!__isLWIPThread()) {
             __tcp_recved_req req = { pcb, len };
-            __lwip(__tcp_recved, &req);
+            __lwip_async(__tcp_recved, &req, sizeof(req));
             return;
         }
 #endif
@@ -433,10 +436,10 @@ extern "C" {
     err_t __wrap_tcp_output(struct tcp_pcb *pcb) {
 #ifdef __FREERTOS
         if (!__isLWIPThread()) {
-            err_t ret;
-            __tcp_output_req req = { pcb, &ret };
-            __lwip(__tcp_output, &req);
-            return ret;
+            // Any real error will show up on the next tcp_write or in the err callback
+            __tcp_output_req req = { pcb, nullptr };
+            __lwip_async(__tcp_output, &req, sizeof(req));
+            return ERR_OK;
         }
 #endif
         LWIPMutex m;
@@ -1151,6 +1154,33 @@ extern "C" {
         return;
     }
 
+    void lwip_tcp_callbacks(struct tcp_pcb *pcb, void *arg, tcp_recv_fn recv, tcp_sent_fn sent, tcp_err_fn err, tcp_poll_fn poll, u8_t interval) {
+#ifdef __FREERTOS
+        if (!__isLWIPThread()) {
+            __tcp_arg_req argReq = { pcb, arg };
+            __tcp_recv_req recvReq = { pcb, recv };
+            __tcp_sent_req sentReq = { pcb, sent };
+            __tcp_err_req errReq = { pcb, err };
+            __tcp_poll_req pollReq = { pcb, poll, interval };
+            const __lwip_batch_item items[] = {
+                { __tcp_arg, &argReq },
+                { __tcp_recv, &recvReq },
+                { __tcp_sent, &sentReq },
+                { __tcp_err, &errReq },
+                { __tcp_poll, &pollReq },
+            };
+            __lwip_batch(items, sizeof(items) / sizeof(items[0]));
+            return;
+        }
+#endif
+        LWIPMutex m;
+        __real_tcp_arg(pcb, arg);
+        __real_tcp_recv(pcb, recv);
+        __real_tcp_sent(pcb, sent);
+        __real_tcp_err(pcb, err);
+        __real_tcp_poll(pcb, poll, interval);
+    }
+
 #ifndef __FREERTOS
     extern bool __real_cyw43_driver_init(async_context_t *context);
     bool __wrap_cyw43_driver_init(async_context_t *context) {
@@ -1210,3 +1240,13 @@ extern "C" {
 #endif
 
 }; // extern "C"
+
+#ifndef __FREERTOS
+// Only the FreeRTOS build has an LWIP task to measure
+void lwipStatsDump(Print &p) {
+    p.printf("LWIP task statistics are only available under FreeRTOS\n");
+}
+
+void lwipStatsReset() {
+}
+#endif
@@ -28,6 +28,7 @@
 #include <lwip/dns.h>
 #include <lwip/raw.h>
 #include <lwip/timeouts.h>
+#include "LockStats.h"
 
 
 extern void ethernet_arch_lwip_begin() __attribute__((weak));
@@ -53,17 +54,28 @@ class LWIPMutex {
 public:
     LWIPMutex() {
 #if !defined(__FREERTOS)
+        uint32_t start = lock_stats ? __lockStatsNow() : 0;
         __inLWIP = __inLWIP + 1;
         if (ethernet_arch_lwip_begin) {
             ethernet_arch_lwip_begin();
         } else {
             recursive_mutex_enter_blocking(&__lwipMutex);
         }
+        TRACE_EVENT(TRACE_LWIP_ENTER, __builtin_return_address(0));
+        if (lock_stats) {
+            // The lock may be an async_context one with no try call, so
+            // only the LOCK_STATS_CONTENDED_CYCLES wait check applies
+            __lockStatsAcquired(&__lwipMutex, start, false);
+        }
 #endif
     }
 
     ~LWIPMutex() {
 #if !defined(__FREERTOS)
+        TRACE_EVENT(TRACE_LWIP_EXIT, 0);
+        if (lock_stats) {
+            __lockStatsReleased(&__lwipMutex);
+        }
         if (ethernet_arch_lwip_end) {
             ethernet_arch_lwip_end();
         } else {
@@ -184,6 +196,8 @@ typedef enum {
 #endif
 
     __callback = 10000,
+
+    __batch = 11000,
 } __lwip_op;
 
 // Set up a local request buffer and call this to add to lwip work queue.  Will only return once lwip operation completed
@@ -740,6 +754,27 @@ typedef struct {
 } __callback_req;
 extern void lwip_callback(void (*cb)(void *), void *cbData, __callback_req *buffer = nullptr);
 
+// A list of requests sent as one unit of work, see __lwip_batch
+typedef struct {
+    __lwip_op op;
+    void *req;
+} __lwip_batch_item;
+
+typedef struct {
+    const __lwip_batch_item *items;
+    size_t count;
+} __batch_req;
+
+// Set all the callbacks of a TCP PCB (or clear them by passing nullptrs) in
+// one trip to the LWIP task instead of five
+extern void lwip_tcp_callbacks(struct tcp_pcb *pcb, void *arg, tcp_recv_fn recv, tcp_sent_fn sent, tcp_err_fn err, tcp_poll_fn poll, u8_t interval);
+
 #ifdef __cplusplus
 };
+
+class Print;
+// Print the per-op queueing and run time of the FreeRTOS LWIP task, in CPU cycles
+void lwipStatsDump(Print &p);
+// Zero the LWIP task statistics
+void lwipStatsReset();
 #endif
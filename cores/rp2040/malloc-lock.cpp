@@ -41,20 +41,200 @@ extern "C" {
 
 extern "C" struct _reent *__getreent();
 
-extern "C" void *__wrap_malloc(size_t size) {
+// Optional per-core small object cache.  Freed blocks of 16...256 bytes are
+// kept on per-core, per-size-class free lists and handed back out on the
+// same core without touching the global malloc lock.  Only a miss (or a
+// full list on free) goes to the real heap.  The blocks are normal heap
+// chunks so realloc/free from either core still work on them.
+// Enable by defining "bool malloc_core_cache = true;" in the sketch.
+bool malloc_core_cache __attribute__((weak)) = false;
+
+typedef struct __cacheBlock {
+    struct __cacheBlock *next;
+} __cacheBlock;
+
+static constexpr int __cacheClasses = 5; // 16, 32, 64, 128, 256 bytes
+static constexpr int __cacheDepth = 16; // Max blocks held per class per core
+static __cacheBlock *__cacheList[2][__cacheClasses];
+static uint8_t __cacheCount[2][__cacheClasses];
+static size_t __cacheBytes[2];
+
+// Smallest class that can hold an allocation, or -1 if too large
+static inline int __cacheAllocClass(size_t size) {
+    if (size > (16 << (__cacheClasses - 1))) {
+        return -1;
+    } else if (size <= 16) {
+        return 0;
+    }
+    return 32 - __builtin_clz(size - 1) - 4;
+}
+
+// Class a freed block can serve, or -1 if it should go back to the heap
+static inline int __cacheFreeClass(size_t usable) {
+    if ((usable < 16) || (usable > (16 << (__cacheClasses - 1)) + 8)) {
+        return -1;
+    }
+    int c = 31 - __builtin_clz(usable) - 4;
+    // Don't hold on to blocks with too much slack past the class size
+    return (usable - (16 << c) <= 8) ? c : -1;
+}
+
+static void *__cacheAlloc(size_t size) {
+    int c = __cacheAllocClass(size);
+    if (c < 0) {
+        return nullptr;
+    }
+    // Only this core touches its lists, so just keep local IRQs/tasks out.
+    // Get the core # afterwards so a task can't migrate in between.
+    uint32_t save = save_and_disable_interrupts();
+    auto core = get_core_num();
+    __cacheBlock *b = __cacheList[core][c];
+    if (b) {
+        __cacheList[core][c] = b->next;
+        __cacheCount[core][c]--;
+        __cacheBytes[core] -= malloc_usable_size(b);
+    }
+    restore_interrupts(save);
+    if (!b) {
+        // Miss, get a full class-sized block so it can be cached when freed
+        noInterrupts();
+        b = (__cacheBlock *)__real_malloc(16 << c);
+        interrupts();
+    }
+    return b;
+}
+
+static bool __cacheFree(void *mem) {
+    size_t usable = malloc_usable_size(mem);
+    int c = __cacheFreeClass(usable);
+    if (c < 0) {
+        return false;
+    }
+    bool cached = false;
+    uint32_t save = save_and_disable_interrupts();
+    auto core = get_core_num();
+    if (__cacheCount[core][c] < __cacheDepth) {
+        __cacheBlock *b = (__cacheBlock *)mem;
+        b->next = __cacheList[core][c];
+        __cacheList[core][c] = b;
+        __cacheCount[core][c]++;
+        __cacheBytes[core] += usable;
+        cached = true;
+    }
+    restore_interrupts(save);
+    return cached;
+}
+
+extern "C" void *smalloc(size_t size) {
+    if (malloc_core_cache && (size <= (16 << (__cacheClasses - 1)))) {
+        return __cacheAlloc(size);
+    }
     noInterrupts();
     void *rc = __real_malloc(size);
     interrupts();
     return rc;
 }
 
-extern "C" void *__wrap_calloc(size_t count, size_t size) {
+extern "C" void *scalloc(size_t count, size_t size) {
+    size_t total;
+    if (malloc_core_cache && !__builtin_mul_overflow(count, size, &total) && (total <= (16 << (__cacheClasses - 1)))) {
+        void *rc = __cacheAlloc(total);
+        if (rc) {
+            memset(rc, 0, total);
+        }
+        return rc;
+    }
     noInterrupts();
     void *rc = __real_calloc(count, size);
     interrupts();
     return rc;
 }
 
+// Per-core placement override set by HeapSelect objects
+static uint8_t __heapSelect[2] = { HEAP_DEFAULT, HEAP_DEFAULT };
+static HeapTierStats __heapTierStats;
+
+HeapSelect::HeapSelect(HeapTier tier) {
+    _core = get_core_num();
+    _prev = __heapSelect[_core];
+    __heapSelect[_core] = tier;
+}
+
+HeapSelect::~HeapSelect() {
+    __heapSelect[_core] = _prev;
+}
+
+extern "C" void getHeapTierStats(HeapTierStats *stats) {
+    *stats = __heapTierStats;
+}
+
+#ifdef RP2350_PSRAM_CS
+// Optional PSRAM placement policy.  Allocations of at least this many bytes go
+// to PSRAM first and SRAM if PSRAM is full.  0 disables.
+// Set by defining "size_t malloc_psram_threshold = 4096;" in the sketch.
+size_t malloc_psram_threshold __attribute__((weak)) = 0;
+// When SRAM is exhausted retry normal allocations in PSRAM.
+// Set by defining "bool malloc_psram_fallback = true;" in the sketch.
+bool malloc_psram_fallback __attribute__((weak)) = false;
+
+static void *__tieredAlloc(size_t count, size_t size, bool clear) {
+    size_t total;
+    if (__builtin_mul_overflow(count, size, &total)) {
+        return nullptr;
+    }
+    auto sel = __heapSelect[get_core_num()];
+    bool psramFirst = (sel == HEAP_PSRAM) || ((sel == HEAP_DEFAULT) && malloc_psram_threshold && (total >= malloc_psram_threshold));
+    void *rc;
+    if (psramFirst) {
+        rc = clear ? pcalloc(count, size) : pmalloc(total);
+        if (rc) {
+            __heapTierStats.psramPlaced++;
+            return rc;
+        }
+        rc = clear ? scalloc(count, size) : smalloc(total);
+        if (rc) {
+            __heapTierStats.sramFallbacks++;
+        }
+    } else {
+        rc = clear ? scalloc(count, size) : smalloc(total);
+        if (!rc && (sel == HEAP_DEFAULT) && malloc_psram_fallback) {
+            rc = clear ? pcalloc(count, size) : pmalloc(total);
+            if (rc) {
+                __heapTierStats.psramFallbacks++;
+            }
+        }
+    }
+    if (!rc) {
+        __heapTierStats.failures++;
+    }
+    return rc;
+}
+
+extern "C" void *__wrap_malloc(size_t size) {
+    return __tieredAlloc(1, size, false);
+}
+
+extern "C" void *__wrap_calloc(size_t count, size_t size) {
+    return __tieredAlloc(count, size, true);
+}
+#else
+extern "C" void *__wrap_malloc(size_t size) {
+    void *rc = smalloc(size);
+    if (!rc) {
+        __heapTierStats.failures++;
+    }
+    return rc;
+}
+
+extern "C" void *__wrap_calloc(size_t count, size_t size) {
+    void *rc = scalloc(count, size);
+    if (!rc) {
+        __heapTierStats.failures++;
+    }
+    return rc;
+}
+#endif
+
 #ifdef RP2350_PSRAM_CS
 // Utilize the existing malloc lock infrastructure and interrupt blocking
 // to work with multicore and FreeRTOS
@@ -91,6 +271,12 @@ extern "C" void *pcalloc(size_t count, size_t size) {
 
 extern "C" void *__wrap_realloc(void *mem, size_t size) {
     void *rc;
+#ifdef RP2350_PSRAM_CS
+    if (!mem) {
+        // Plain allocation, follow the placement policy
+        return __tieredAlloc(1, size, false);
+    }
+#endif
     noInterrupts();
 #ifdef RP2350_PSRAM_CS
     if (mem && (mem < __ram_start)) {
@@ -102,10 +288,30 @@ extern "C" void *__wrap_realloc(void *mem, size_t size) {
     rc = __real_realloc(mem, size);
 #endif
     interrupts();
+#ifdef RP2350_PSRAM_CS
+    if (!rc && size && (mem >= __ram_start) && (__heapSelect[get_core_num()] == HEAP_DEFAULT) && malloc_psram_fallback) {
+        // SRAM couldn't grow the block, move it to PSRAM
+        rc = pmalloc(size);
+        if (rc) {
+            size_t old = malloc_usable_size(mem);
+            memcpy(rc, mem, old < size ? old : size);
+            free(mem);
+            __heapTierStats.psramFallbacks++;
+        }
+    }
+#endif
     return rc;
 }
 
 extern "C" void __wrap_free(void *mem) {
+#ifdef RP2350_PSRAM_CS
+    bool sram = mem && (mem >= __ram_start);
+#else
+    bool sram = mem != nullptr;
+#endif
+    if (malloc_core_cache && sram && __cacheFree(mem)) {
+        return;
+    }
     noInterrupts();
 #ifdef RP2350_PSRAM_CS
     if (mem && (mem < __ram_start)) {
@@ -125,5 +331,21 @@ extern "C" struct mallinfo __wrap_mallinfo() {
     auto ret = __real_mallinfo();
     __malloc_unlock(__getreent());
     interrupts();
+    if (malloc_core_cache) {
+        // Cached blocks are in use as far as the heap knows, but are really
+        // free.  Report them as the (otherwise unused) fastbin fields.
+        size_t bytes = 0;
+        size_t blocks = 0;
+        for (int core = 0; core < 2; core++) {
+            bytes += __cacheBytes[core];
+            for (int c = 0; c < __cacheClasses; c++) {
+                blocks += __cacheCount[core][c];
+            }
+        }
+        ret.smblks = blocks;
+        ret.fsmblks = bytes;
+        ret.uordblks -= bytes;
+        ret.fordblks += bytes;
+    }
     return ret;
 }
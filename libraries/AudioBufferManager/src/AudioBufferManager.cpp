@@ -46,6 +46,9 @@ AudioBufferManager::AudioBufferManager(size_t bufferCount, size_t bufferWords, i
     _useData = false;
     _userOff = 0;
 
+    // DMA buffers need to be in SRAM regardless of any PSRAM placement policy
+    HeapSelectSRAM sram;
+
     // Create the silence buffer, fill with appropriate value
     _silence = new AudioBuffer;
     _silence->next = nullptr;
@@ -460,10 +460,10 @@ bool I2S::end() {
         _arbOutput = nullptr;
         delete _arbInput;
         _arbInput = nullptr;
+        delete _i2s; // Unloads _pgm, so free it afterwards
+        _i2s = nullptr;
         free(_pgm);
         _pgm = nullptr;
-        delete _i2s;
-        _i2s = nullptr;
     }
     return true;
 }
@@ -167,7 +167,7 @@ void PDMClass::end() {
     dma_channel_abort(_dmaChannel);
     dma_channel_unclaim(_dmaChannel);
     irq_remove_handler(DMA_IRQ_0, dmaHandler);
-    pio_sm_unclaim(_pio, _smIdx);
+    _pdmPgm.release(_pio, _smIdx);
     pinMode(_clkPin, INPUT);
     rawBufferIndex = 0;
     _pgmOffset = -1;
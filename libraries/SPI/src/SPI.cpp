@@ -199,7 +199,7 @@ bool SPIClassRP2040::transferAsync(const void *send, void *recv, size_t bytes) {
     }
 
     if (send && (_spis.getBitOrder() != MSBFIRST)) {
-        _dmaBuffer = (uint8_t *)malloc(bytes);
+        _dmaBuffer = (uint8_t *)smalloc(bytes); // DMA source, keep out of PSRAM
         if (!_dmaBuffer) {
             dma_channel_unclaim(_channelDMA);
             dma_channel_unclaim(_channelSendDMA);
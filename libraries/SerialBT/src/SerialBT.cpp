@@ -187,7 +187,6 @@ void SerialBT_::packetHandler(uint8_t type, uint16_t channel, uint8_t *packet, u
     bd_addr_t event_addr;
     //uint8_t   rfcomm_channel_nr;
     //uint16_t  mtu;
-    int i;
 
     switch (type) {
     case HCI_EVENT_PACKET:
@@ -238,10 +237,8 @@ void SerialBT_::packetHandler(uint8_t type, uint16_t channel, uint8_t *packet, u
         break;
 
     case RFCOMM_DATA_PACKET:
-        for (i = 0; i < size; i++) {
-            if (!_queue->write(packet[i])) {
-                _overflow = true;
-            }
+        if (_queue->write(packet, size) != size) {
+            _overflow = true;
         }
         break;
 
@@ -247,8 +247,8 @@ void SoftwareSPI::end() {
     if (_initted) {
         DEBUGSPI("SoftwareSPI: deinitting currently active SPI\n");
         _initted = false;
-        pio_sm_set_enabled(_pio, _sm, false);
-        // TODO - We don't have a good PIOProgram reclamation method so this will possibly leak an SM
+        delete _spi; // Releases the SM and, if no one else uses it, the program
+        _spi = nullptr;
     }
     _spis = SPISettings(0, LSBFIRST, SPI_MODE0);
 }
@@ -0,0 +1,54 @@
+// Serves several browsers at once with keep-alive connections.
+// Measure it from a PC with "python3 tools/webload.py <IP address>"
+//
+// Released to the public domain by Earle F. Philhower, III, 2026
+
+#include <WiFi.h>
+#include <WebServer.h>
+
+#ifndef STASSID
+#define STASSID "your-ssid"
+#define STAPSK "your-password"
+#endif
+
+const char* ssid = STASSID;
+const char* password = STAPSK;
+
+WebServer server(80);
+
+uint32_t hits = 0;
+
+void handleRoot() {
+  hits++;
+  server.send(200, "text/plain", "hello from pico w!\r\n");
+}
+
+void handleStatus() {
+  hits++;
+  String json = "{\"uptime\":" + String(millis()) + ",\"hits\":" + String(hits) + ",\"heap\":" + String(rp2040.getFreeHeap()) + "}";
+  server.send(200, "application/json", json);
+}
+
+void setup() {
+  Serial.begin(115200);
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(ssid, password);
+  while (WiFi.status() != WL_CONNECTED) {
+    delay(500);
+    Serial.print(".");
+  }
+  Serial.println("");
+  Serial.print("IP address: ");
+  Serial.println(WiFi.localIP());
+
+  server.on("/", handleRoot);
+  server.on("/status", handleStatus);
+  // Each open connection uses one of lwIP's few TCP PCBs
+  server.setMaxClients(4);
+  server.begin();
+  Serial.println("HTTP server started");
+}
+
+void loop() {
+  server.handleClient();
+}
@@ -21,6 +21,8 @@
 */
 
 #include <Arduino.h>
+#include <algorithm>
+#include <new>
 #include <libb64/cencode.h>
 #include "WiFiServer.h"
 #include "WiFiClient.h"
@@ -52,15 +54,23 @@ HTTPServer::HTTPServer()
     , _currentHandler(nullptr)
     , _firstHandler(nullptr)
     , _lastHandler(nullptr)
+    , _routesDirty(false)
+    , _request(&_parser)
     , _currentArgCount(0)
-    , _currentArgs(nullptr)
     , _postArgsLen(0)
     , _postArgs(nullptr)
+    , _body(nullptr)
+    , _bodyEncoded(false)
     , _headerKeysCount(0)
     , _currentHeaders(nullptr)
     , _contentLength(0)
     , _clientContentLength(0)
-    , _chunked(false) {
+    , _chunked(false)
+    , _writer(this)
+    , _responseBufferSize(HTTP_RESPONSE_BUFLEN)
+    , _keepAliveMode(false)
+    , _clientKeepAlive(false)
+    , _keepAlive(false) {
     log_v("HTTPServer::HTTPServer()");
 }
 
@@ -68,6 +78,7 @@ HTTPServer::~HTTPServer() {
     if (_currentHeaders) {
         delete[]_currentHeaders;
     }
+    delete[] _postArgs;
     RequestHandler* handler = _firstHandler;
     while (handler) {
         RequestHandler* next = handler->next();
@@ -274,6 +285,7 @@ void HTTPServer::_addRequestHandler(RequestHandler* handler) {
         _lastHandler->next(handler);
         _lastHandler = handler;
     }
+    _routesDirty = true;
 }
 
 bool HTTPServer::_removeRequestHandler(RequestHandler *handler) {
@@ -294,6 +306,7 @@ bool HTTPServer::_removeRequestHandler(RequestHandler *handler) {
 
             // Delete 'matching' handler
             delete current;
+            _routesDirty = true;
             return true;
         }
         previous = current;
@@ -302,6 +315,58 @@ bool HTTPServer::_removeRequestHandler(RequestHandler *handler) {
     return false;
 }
 
+void HTTPServer::_buildRoutes() {
+    _routes.clear();
+    _routeHandlers.clear();
+    _unrouted.clear();
+    int id = 0;
+    for (RequestHandler *handler = _firstHandler; handler; handler = handler->next(), id++) {
+        _routeHandlers.push_back(handler);
+        bool params = false;
+        uint64_t methods = 0;
+        const char *pattern = handler->routePattern(params, methods);
+        if (!pattern || !_routes.add(pattern, params, methods, id)) {
+            _unrouted.push_back(id);
+        }
+    }
+    _routesDirty = false;
+}
+
+RequestHandler* HTTPServer::_findHandler() {
+    if (_routesDirty) {
+        _buildRoutes();
+    }
+    RouteTrie::Match matches[ROUTE_MAX_MATCHES];
+    int count = _routes.match(_currentUri.c_str(), _currentUri.length(), _currentMethod, matches, ROUTE_MAX_MATCHES);
+    if (count < 0) {
+        // Too many routes for this path to keep track of, check them all in order
+        for (RequestHandler *handler = _firstHandler; handler; handler = handler->next()) {
+            if (handler->canHandle(*this, _currentMethod, _currentUri)) {
+                return handler;
+            }
+        }
+        return nullptr;
+    }
+    // Merge the matching routes with the unindexed handlers, so the first one registered still wins
+    int m = 0;
+    size_t u = 0;
+    while ((m < count) || (u < _unrouted.size())) {
+        if ((m < count) && ((u == _unrouted.size()) || (matches[m].id < _unrouted[u]))) {
+            RequestHandler *handler = _routeHandlers[matches[m].id];
+            if (handler->routeMatched(*this, _currentUri.c_str(), matches[m].caps, matches[m].count)) {
+                return handler;
+            }
+            m++;
+        } else {
+            RequestHandler *handler = _routeHandlers[_unrouted[u++]];
+            if (handler->canHandle(*this, _currentMethod, _currentUri)) {
+                return handler;
+            }
+        }
+    }
+    return nullptr;
+}
+
 void HTTPServer::serveStatic(const char* uri, FS& fs, const char* path, const char* cache_header) {
     _addRequestHandler(new StaticRequestHandler(fs, path, uri, cache_header));
 }
@@ -371,7 +436,9 @@ void HTTPServer::_prepareHeader(String& response, int code, const char* content_
         sendHeader(String(FPSTR("Access-Control-Allow-Methods")), String("*"));
         sendHeader(String(FPSTR("Access-Control-Allow-Headers")), String("*"));
     }
-    sendHeader(String(F("Connection")), String(F("close")));
+    // Without a length or chunking the only end-of-body marker is the close
+    _keepAlive = _keepAliveMode && _clientKeepAlive && (_chunked || (_contentLength != CONTENT_LENGTH_UNKNOWN));
+    sendHeader(String(F("Connection")), _keepAlive ? String(F("keep-alive")) : String(F("close")));
 
     response += _responseHeaders;
     response += "\r\n";
@@ -439,6 +506,14 @@ void HTTPServer::sendContent(const String& content) {
 }
 
 void HTTPServer::sendContent(const char* content, size_t contentLength) {
+    if (_writer.active()) {
+        if (contentLength) {
+            _writer.write((const uint8_t *)content, contentLength);
+        } else {
+            _writer.end();
+        }
+        return;
+    }
     const char * footer = "\r\n";
     if (_chunked) {
         char chunkSize[11];
@@ -459,6 +534,14 @@ void HTTPServer::sendContent_P(PGM_P content) {
 }
 
 void HTTPServer::sendContent_P(PGM_P content, size_t size) {
+    if (_writer.active()) {
+        if (size) {
+            _writer.write((const uint8_t *)content, size);
+        } else {
+            _writer.end();
+        }
+        return;
+    }
     const char * footer = "\r\n";
     if (_chunked) {
         char chunkSize[11];
@@ -475,6 +558,135 @@ void HTTPServer::sendContent_P(PGM_P content, size_t size) {
 }
 
 
+HTTPResponseWriter& HTTPServer::beginResponse(int code, const char* content_type) {
+    if (_contentLength == CONTENT_LENGTH_NOT_SET) {
+        // Chunked for HTTP/1.1, ended by closing the connection for HTTP/1.0
+        _contentLength = CONTENT_LENGTH_UNKNOWN;
+    }
+    String header;
+    _prepareHeader(header, code, content_type, 0);
+    _writer._begin(header, _chunked, _responseBufferSize);
+    _chunked = false; // The writer does its own framing
+    return _writer;
+}
+
+void HTTPServer::setResponseBufferSize(size_t size) {
+    _responseBufferSize = size;
+}
+
+// Room for the largest chunk size line, "ffffff\r\n", in front of the data
+#define CHUNK_HEAD 8
+// The "\r\n" ending a chunk and the "0\r\n\r\n" ending the body
+#define CHUNK_TAIL 7
+
+void HTTPResponseWriter::_begin(String &header, bool chunked, size_t size) {
+    size = std::min(size, (size_t)0xffffff);
+    if (!_buf || (_size != size)) {
+        // Kept for the next response
+        _buf.reset(size ? new (std::nothrow) char[CHUNK_HEAD + size + CHUNK_TAIL] : nullptr);
+        _size = _buf ? size : 0;
+    }
+    _len = 0;
+    _header = header;
+    _chunked = chunked;
+    _active = true;
+}
+
+size_t HTTPResponseWriter::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t HTTPResponseWriter::write(const uint8_t *data, size_t len) {
+    // An empty chunk would be the chunked encoding's end marker
+    if (!_active || !len) {
+        return 0;
+    }
+    if (len >= _size) {
+        // Too big to be worth copying, send what's buffered and then this as its own chunk
+        _flush(false);
+        if (_chunked) {
+            char head[12];
+            _out(head, snprintf(head, sizeof(head), "%x\r\n", (unsigned)len));
+        }
+        _out((const char *)data, len);
+        if (_chunked) {
+            _out("\r\n", 2);
+        }
+        return len;
+    }
+    for (size_t done = 0; done < len;) {
+        size_t n = std::min(len - done, _size - _len);
+        memcpy(_buf.get() + CHUNK_HEAD + _len, data + done, n);
+        _len += n;
+        done += n;
+        if (_len == _size) {
+            _flush(false);
+        }
+    }
+    return len;
+}
+
+int HTTPResponseWriter::availableForWrite() {
+    return _active ? _size - _len : 0;
+}
+
+void HTTPResponseWriter::flush() {
+    if (_active) {
+        _flush(false);
+    }
+}
+
+void HTTPResponseWriter::end() {
+    if (_active) {
+        _flush(true);
+        _active = false;
+    }
+}
+
+// Frames the buffered data in place so it leaves in a single write
+void HTTPResponseWriter::_flush(bool last) {
+    if (!_len && !last && !_header.length()) {
+        return;
+    }
+    if (!_buf) {
+        _out("0\r\n\r\n", (last && _chunked) ? 5 : 0);
+        return;
+    }
+    char *start = _buf.get() + CHUNK_HEAD;
+    char *end = start + _len;
+    if (_chunked) {
+        if (_len) {
+            char head[CHUNK_HEAD + 1];
+            int h = snprintf(head, sizeof(head), "%x\r\n", (unsigned)_len);
+            start -= h;
+            memcpy(start, head, h);
+            memcpy(end, "\r\n", 2);
+            end += 2;
+        }
+        if (last) {
+            memcpy(end, "0\r\n\r\n", 5);
+            end += 5;
+        }
+    }
+    _out(start, end - start);
+    _len = 0;
+}
+
+void HTTPResponseWriter::_out(const char *data, size_t len) {
+    if (_header.length()) {
+        // The headers go out with the first piece of the body
+        if (len <= _size + CHUNK_HEAD + CHUNK_TAIL) {
+            _header.concat(data, len);
+            len = 0;
+        }
+        _server->_currentClientWrite(_header.c_str(), _header.length());
+        _header = String();
+    }
+    if (len) {
+        _server->_currentClientWrite(data, len);
+    }
+}
+
 void HTTPServer::_streamFileCore(const size_t fileSize, const String & fileName, const String & contentType, const int code) {
     using namespace mime;
     setContentLength(fileSize);
@@ -493,35 +705,78 @@ String HTTPServer::pathArg(unsigned int i) {
     return "";
 }
 
+// Arguments are only decoded when asked for.  Multipart form fields come
+// first, then the query and url-encoded body, and finally a "plain" body.
+bool HTTPServer::_findArg(const String* name, int index, RequestParser::Arg& arg) {
+    const char *lists[2] = { _request->str(_request->query()), _bodyEncoded ? _body : nullptr };
+    for (const char *cursor : lists) {
+        while (RequestParser::nextArg(cursor, arg)) {
+            if (name ? RequestParser::urlDecodedEquals(arg.key, arg.keyLen, name->c_str(), name->length()) : !index--) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static String urlDecoded(const char *src, size_t len) {
+    String ret;
+    ret.reserve(RequestParser::urlDecode(src, len, nullptr));
+    for (size_t i = 0; i < len;) {
+        ret += RequestParser::urlDecodeChar(src, len, i);
+    }
+    return ret;
+}
+
 String HTTPServer::arg(String name) {
     for (int j = 0; j < _postArgsLen; ++j) {
         if (_postArgs[j].key == name) {
             return _postArgs[j].value;
         }
     }
-    for (int i = 0; i < _currentArgCount; ++i) {
-        if (_currentArgs[i].key == name) {
-            return _currentArgs[i].value;
-        }
+    RequestParser::Arg a;
+    if (_findArg(&name, 0, a)) {
+        return urlDecoded(a.value, a.valueLen);
+    }
+    if (_body && !_bodyEncoded && (name == "plain")) {
+        return String(_body);
     }
     return "";
 }
 
 String HTTPServer::arg(int i) {
-    if (i < _currentArgCount) {
-        return _currentArgs[i].value;
+    RequestParser::Arg a;
+    if ((i < 0) || (i >= args())) {
+        return "";
+    } else if (i < _postArgsLen) {
+        return _postArgs[i].value;
+    } else if (_findArg(nullptr, i - _postArgsLen, a)) {
+        return urlDecoded(a.value, a.valueLen);
     }
-    return "";
+    return String(_body);
 }
 
 String HTTPServer::argName(int i) {
-    if (i < _currentArgCount) {
-        return _currentArgs[i].key;
+    RequestParser::Arg a;
+    if ((i < 0) || (i >= args())) {
+        return "";
+    } else if (i < _postArgsLen) {
+        return _postArgs[i].key;
+    } else if (_findArg(nullptr, i - _postArgsLen, a)) {
+        return urlDecoded(a.key, a.keyLen);
     }
-    return "";
+    return F("plain");
 }
 
 int HTTPServer::args() {
+    if (_currentArgCount < 0) {
+        RequestParser::Arg a;
+        int cnt = 0;
+        while (_findArg(nullptr, cnt, a)) {
+            cnt++;
+        }
+        _currentArgCount = _postArgsLen + cnt + ((_body && !_bodyEncoded) ? 1 : 0);
+    }
     return _currentArgCount;
 }
 
@@ -531,19 +786,15 @@ bool HTTPServer::hasArg(String  name) {
             return true;
         }
     }
-    for (int i = 0; i < _currentArgCount; ++i) {
-        if (_currentArgs[i].key == name) {
-            return true;
-        }
-    }
-    return false;
+    RequestParser::Arg a;
+    return _findArg(&name, 0, a) || (_body && !_bodyEncoded && (name == "plain"));
 }
 
 
 String HTTPServer::header(String name) {
     for (int i = 0; i < _headerKeysCount; ++i) {
         if (_currentHeaders[i].key.equalsIgnoreCase(name)) {
-            return _currentHeaders[i].value;
+            return header(i);
         }
     }
     return "";
@@ -561,9 +812,13 @@ void HTTPServer::collectHeaders(const char* headerKeys[], const size_t headerKey
     }
 }
 
+// Every request header is kept in the parser, but only the collected ones are reported
 String HTTPServer::header(int i) {
-    if (i < _headerKeysCount) {
-        return _currentHeaders[i].value;
+    if ((i >= 0) && (i < _headerKeysCount)) {
+        const char *value = _request->header(_currentHeaders[i].key.c_str());
+        if (value) {
+            return value;
+        }
     }
     return "";
 }
@@ -581,15 +836,21 @@ int HTTPServer::headers() {
 
 bool HTTPServer::hasHeader(String name) {
     for (int i = 0; i < _headerKeysCount; ++i) {
-        if ((_currentHeaders[i].key.equalsIgnoreCase(name)) && (_currentHeaders[i].value.length() > 0)) {
-            return true;
+        if (_currentHeaders[i].key.equalsIgnoreCase(name)) {
+            const char *value = _request->header(_currentHeaders[i].key.c_str());
+            return value && *value;
         }
     }
     return false;
 }
 
 String HTTPServer::hostHeader() {
-    return _hostHeader;
+    const char *host = _request->header("Host");
+    return host ? host : "";
+}
+
+const char* HTTPServer::requestHeader(const char* name) {
+    return _request->header(name);
 }
 
 void HTTPServer::onFileUpload(THandlerFunction fn) {
@@ -627,7 +888,9 @@ void HTTPServer::_handleRequest() {
 
 
 void HTTPServer::_finalizeResponse() {
-    if (_chunked) {
+    if (_writer.active()) {
+        _writer.end();
+    } else if (_chunked) {
         sendContent("");
     }
 }
@@ -668,6 +931,7 @@ String HTTPServer::_responseCodeToString(int code) {
     case 415: return F("Unsupported Media Type");
     case 416: return F("Requested range not satisfiable");
     case 417: return F("Expectation Failed");
+    case 431: return F("Request Header Fields Too Large");
     case 500: return F("Internal Server Error");
     case 501: return F("Not Implemented");
     case 502: return F("Bad Gateway");
@@ -27,6 +27,9 @@
 #include <WiFi.h>
 #include "HTTP_Method.h"
 #include "Uri.h"
+#include "detail/RequestBody.h"
+#include "detail/RequestParser.h"
+#include "detail/RouteTrie.h"
 
 enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END,
                         UPLOAD_FILE_ABORTED
@@ -45,11 +48,28 @@ enum HTTPAuthMethod { BASIC_AUTH, DIGEST_AUTH };
 #define HTTP_RAW_BUFLEN 1436
 #endif
 
+#ifndef HTTP_MAX_BODY_SIZE
+#define HTTP_MAX_BODY_SIZE 65536 // Largest body held in memory (any body in multi-client mode), bigger ones get a 413
+#endif
+
 #define HTTP_MAX_DATA_WAIT 5000 //ms to wait for the client to send the request
 #define HTTP_MAX_DATA_AVAILABLE_WAIT 30 //ms to wait for the client to send the request when there is another client with data available
 #define HTTP_MAX_POST_WAIT 5000 //ms to wait for POST data to arrive
 #define HTTP_MAX_SEND_WAIT 5000 //ms to wait for data chunk to be ACKed
 #define HTTP_MAX_CLOSE_WAIT 5000 //ms to wait for the client to close the connection
+#define HTTP_MAX_KEEPALIVE_WAIT 5000 //ms to keep an idle keep-alive connection open (multi-client mode)
+
+#ifndef HTTP_RESPONSE_BUFLEN
+#define HTTP_RESPONSE_BUFLEN 1436 // Default beginResponse() buffer, one TCP segment
+#endif
+
+#ifndef HTTP_STATIC_CACHE_SIZE
+#define HTTP_STATIC_CACHE_SIZE 8 // Files per serveStatic() whose size and ETag are remembered
+#endif
+
+#ifndef HTTP_STATIC_CACHE_MS
+#define HTTP_STATIC_CACHE_MS 2000 // ms before a remembered file is checked again
+#endif
 
 #define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
 #define CONTENT_LENGTH_NOT_SET ((size_t) -2)
@@ -84,6 +104,41 @@ namespace fs {
 class FS;
 }
 
+// Body of a response started with HTTPServer::beginResponse().  Writes are
+// collected and sent in pieces of up to the buffer size, as HTTP chunks when
+// the length isn't known in advance.
+class HTTPResponseWriter : public Print {
+public:
+    HTTPResponseWriter(HTTPServer *server) : _server(server) { }
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buf, size_t size) override;
+    int availableForWrite() override;
+    // Sends everything buffered so far, and the headers if they haven't gone out yet
+    void flush() override;
+    // Sends the rest and ends the response, called automatically after the handler returns
+    void end();
+    bool active() const {
+        return _active;
+    }
+
+    using Print::write;
+
+private:
+    friend class HTTPServer;
+    void _begin(String &header, bool chunked, size_t size);
+    void _flush(bool last);
+    void _out(const char *data, size_t len);
+
+    HTTPServer *_server;
+    std::unique_ptr<char[]> _buf;   // Room for the chunk framing around _size bytes of data
+    size_t _size = 0;
+    size_t _len = 0;
+    String _header;                 // Status and headers, sent with the first data
+    bool _chunked = false;
+    bool _active = false;
+};
+
 class HTTPServer {
 public:
     HTTPServer();
@@ -155,6 +210,7 @@ public:
     }
 
     String hostHeader();            // get request host header if available or empty String if not
+    const char* requestHeader(const char* name); // any request header, collected or not, nullptr if not sent
 
     // send response to the client
     // code - HTTP response code, can be 200 or 404
@@ -184,6 +240,10 @@ public:
     void sendContent_P(PGM_P content);
     void sendContent_P(PGM_P content, size_t size);
 
+    // Sends the status and headers (with the first data) and returns a Print for the body
+    HTTPResponseWriter& beginResponse(int code, const char* content_type = nullptr);
+    void setResponseBufferSize(size_t size);
+
     bool chunkedResponseModeStart_P(int code, PGM_P content_type) {
         if (_currentVersion == 0)
             // no chunk mode in HTTP/1.0
@@ -232,25 +292,40 @@ public:
     }
 
 protected:
+    friend class HTTPResponseWriter;
     virtual size_t _currentClientWrite(const char* b, size_t l) {
         return _currentClient->write(b, l);
     }
     virtual size_t _currentClientWrite_P(PGM_P b, size_t l) {
+        // The program image never changes, so lwIP can send straight out of flash
+        extern uint8_t __flash_binary_start, __flash_binary_end;
+        if (((const uint8_t *)b >= &__flash_binary_start) && ((const uint8_t *)b + l <= &__flash_binary_end)) {
+            return _currentClient->writeStatic((const uint8_t *)b, l);
+        }
         return _currentClient->write(b, l);
     }
     void _addRequestHandler(RequestHandler* handler);
     bool _removeRequestHandler(RequestHandler *handler);
+    void _buildRoutes();
+    RequestHandler* _findHandler();
     void _handleRequest();
     void _finalizeResponse();
     ClientFuture _parseRequest(WiFiClient* client);
-    void _parseArguments(String data);
+    bool _collectRequest(WiFiClient* client, RequestParser& req, RequestBody& body, ClientFuture& future);
+    ClientFuture _dispatchRequest(RequestParser& req, RequestBody& body);
+    void _startRequest();
+    ClientFuture _callHook(WiFiClient* client);
+    ClientFuture _parseBody(Client* client, uint64_t length, char* buffered);
+    bool _readRequest(WiFiClient* client, bool headers);
+    void _rejectRequest(WiFiClient* client, int code);
+    bool _findArg(const String* name, int index, RequestParser::Arg& arg);
+    void _resetArgs();
     static String _responseCodeToString(int code);
-    bool _parseForm(WiFiClient* client, String boundary, uint32_t len);
+    bool _parseForm(Client* client, String boundary, uint32_t len);
     bool _parseFormUploadAborted();
     void _uploadWriteByte(uint8_t b);
-    int _uploadReadByte(WiFiClient* client);
+    int _uploadReadByte(Client* client);
     void _prepareHeader(String& response, int code, const char* content_type, size_t contentLength);
-    bool _collectHeader(const char* headerName, const char* headerValue);
 
     void _streamFileCore(const size_t fileSize, const String & fileName, const String & contentType, const int code = 200);
 
@@ -279,10 +354,19 @@ protected:
     THandlerFunction _notFoundHandler;
     THandlerFunction _fileUploadHandler;
 
-    int              _currentArgCount;
-    RequestArgument* _currentArgs;
+    RouteTrie        _routes;           // Path index of the handlers, rebuilt after they change
+    std::vector<RequestHandler*> _routeHandlers; // In registration order
+    std::vector<int> _unrouted;         // Handlers only canHandle() can match
+    bool             _routesDirty;
+
+    RequestParser    _parser;           // Request line and headers, reused for every request
+    RequestParser*   _request;          // _parser, or the multi-client connection being served
+    int              _currentArgCount;  // -1 until args() counts them
     int              _postArgsLen;
-    RequestArgument* _postArgs;
+    RequestArgument* _postArgs;         // Multipart form fields
+    const char*      _body;             // Request body for "plain" or url-encoded args
+    bool             _bodyEncoded;
+    std::unique_ptr<char[]> _bodyBuf;   // For bodies too large for the arena
 
     std::unique_ptr<HTTPUpload> _currentUpload;
     std::unique_ptr<HTTPRaw>    _currentRaw;
@@ -293,12 +377,17 @@ protected:
     int              _clientContentLength;	// "Content-Length" from header of incoming POST or GET request
     String           _responseHeaders;
 
-    String           _hostHeader;
     bool             _chunked;
+    HTTPResponseWriter _writer;
+    size_t           _responseBufferSize;
 
     String           _snonce;  // Store noance and opaque for future comparison
     String           _sopaque;
     String           _srealm;  // Store the Auth realm between Calls
 
     HookFunction     _hook;
+
+    bool             _keepAliveMode;    // Multi-client server, connections may persist
+    bool             _clientKeepAlive;  // Current request allows keep-alive
+    bool             _keepAlive;        // Current response was sent with keep-alive
 };
@@ -20,6 +20,9 @@
 */
 
 #include <Arduino.h>
+#include <algorithm>
+#include <climits>
+#include <new>
 #include "WiFiServer.h"
 #include "WiFiClient.h"
 #include "HTTPServer.h"
@@ -46,10 +49,10 @@ static const char * _http_method_str[] = {
 static const char Content_Type[] PROGMEM = "Content-Type";
 static const char filename[] PROGMEM = "filename";
 
-static char* readBytesWithTimeout(WiFiClient* client, size_t maxLength, size_t& dataLength, int timeout_ms) {
-    char *buf = nullptr;
-    dataLength = 0;
-    while (dataLength < maxLength) {
+// Reads exactly len bytes unless the client stalls for timeout_ms
+static size_t readBytesWithTimeout(Client* client, char* buf, size_t len, int timeout_ms) {
+    size_t dataLength = 0;
+    while (dataLength < len) {
         int tries = timeout_ms;
         size_t newLength;
         while (!(newLength = client->available()) && tries--) {
@@ -58,133 +61,205 @@ static char* readBytesWithTimeout(WiFiClient* client, size_t maxLength, size_t&
         if (!newLength) {
             break;
         }
-        if (!buf) {
-            buf = (char *) malloc(newLength + 1);
-            if (!buf) {
-                return nullptr;
-            }
-        } else {
-            char* newBuf = (char *) realloc(buf, dataLength + newLength + 1);
-            if (!newBuf) {
-                free(buf);
-                return nullptr;
-            }
-            buf = newBuf;
-        }
+        // Never read past the body, a pipelined request may follow it
+        newLength = std::min(newLength, len - dataLength);
         client->readBytes(buf + dataLength, newLength);
         dataLength += newLength;
-        buf[dataLength] = '\0';
     }
-    return buf;
+    return dataLength;
+}
+
+// RequestParser::BodySink collecting a multi-client request body
+static bool appendBody(void *param, const char *data, size_t len) {
+    return ((RequestBody *)param)->append(data, len, HTTP_MAX_BODY_SIZE);
+}
+
+void HTTPServer::_resetArgs() {
+    _currentArgCount = -1;
+    delete[] _postArgs;
+    _postArgs = nullptr;
+    _postArgsLen = 0;
+    _body = nullptr;
+    _bodyEncoded = false;
+    _bodyBuf.reset();
+}
+
+// Feeds the request line, or the rest of the headers, through the parser.
+// Only the bytes the parser used are taken from the client.
+bool HTTPServer::_readRequest(WiFiClient* client, bool headers) {
+    char chunk[128];
+    unsigned long start = millis();
+    while ((_request->state() == RequestParser::NEED_MORE) && (headers || !_request->requestLine())) {
+        int avail = client->available();
+        if (avail <= 0) {
+            if (!client->connected() || (millis() - start > client->getTimeout())) {
+                return false;
+            }
+            delay(1);
+            continue;
+        }
+        size_t len = client->peekBytes(chunk, std::min((size_t)avail, sizeof(chunk)));
+        client->read((uint8_t *)chunk, _request->feed(chunk, len));
+        start = millis();
+    }
+    return _request->state() != RequestParser::BAD && _request->state() != RequestParser::TOO_LARGE;
+}
+
+// Answers a request we won't handle before the connection is dropped, so the client
+// sees why instead of a reset
+void HTTPServer::_rejectRequest(WiFiClient* client, int code) {
+    client->print(String("HTTP/1.1 ") + code + ' ' + _responseCodeToString(code) + "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
 }
 
 HTTPServer::ClientFuture HTTPServer::_parseRequest(WiFiClient* client) {
-    // Read the first line of HTTP request
-    String req = client->readStringUntil('\r');
-    client->readStringUntil('\n');
-    //reset header value
-    for (int i = 0; i < _headerKeysCount; ++i) {
-        _currentHeaders[i].value = String();
+    _keepAlive = false; // Until a response header says otherwise
+    _writer._active = false;
+    _resetArgs();
+    _request = &_parser;
+    if (!_request->begin()) {
+        log_e("No memory for request");
+        return CLIENT_MUST_STOP;
     }
 
     // First line of HTTP request looks like "GET /path HTTP/1.1"
-    // Retrieve the "/path" part by finding the spaces
-    int addr_start = req.indexOf(' ');
-    int addr_end = req.indexOf(' ', addr_start + 1);
-    if (addr_start == -1 || addr_end == -1) {
-        log_e("Invalid request: %s", req.c_str());
+    if (!_readRequest(client, false)) {
+        log_e("Invalid request");
+        if (_request->state() == RequestParser::TOO_LARGE) {
+            _rejectRequest(client, 414);
+        }
         return CLIENT_MUST_STOP;
     }
+    _startRequest();
 
-    String methodStr = req.substring(0, addr_start);
-    String url = req.substring(addr_start + 1, addr_end);
-    String versionEnd = req.substring(addr_end + 8);
-    _currentVersion = atoi(versionEnd.c_str());
-    String searchStr = "";
-    int hasSearch = url.indexOf('?');
-    if (hasSearch != -1) {
-        searchStr = url.substring(hasSearch + 1);
-        url = url.substring(0, hasSearch);
+    // Hooks see the client before the headers have been read, as they always have
+    auto whatNow = _callHook(client);
+    if (whatNow != CLIENT_REQUEST_CAN_CONTINUE) {
+        return whatNow;
     }
-    _currentUri = url;
-    _chunked = false;
-    _clientContentLength = 0;  // not known yet, or invalid
 
-    if (_hook) {
-        auto whatNow = _hook(methodStr, url, client, mime::getContentType);
-        if (whatNow != CLIENT_REQUEST_CAN_CONTINUE) {
-            return whatNow;
+    if (!_readRequest(client, true)) {
+        log_e("Invalid request headers%s", (_request->state() == RequestParser::TOO_LARGE) ? ", increase HTTP_ARENA_SIZE" : "");
+        if (_request->state() == RequestParser::TOO_LARGE) {
+            _rejectRequest(client, 431);
         }
+        return CLIENT_MUST_STOP;
     }
+    return _parseBody(client, _request->contentLength(), nullptr);
+}
 
-    HTTPMethod method = HTTP_ANY;
-    size_t num_methods = sizeof(_http_method_str) / sizeof(const char *);
-    for (size_t i = 0; i < num_methods; i++) {
-        if (methodStr == _http_method_str[i]) {
-            method = (HTTPMethod)i;
+// Multi-client mode.  Feeds whatever the client has sent so far through req, running
+// the hook after the request line and collecting any body into body, and never waits
+// for more.  Returns true once future says what to do with the connection, where
+// CLIENT_REQUEST_CAN_CONTINUE means the whole request is in and can be dispatched.
+bool HTTPServer::_collectRequest(WiFiClient* client, RequestParser& req, RequestBody& body, ClientFuture& future) {
+    char chunk[128];
+    int avail;
+    while ((avail = client->available()) > 0) {
+        size_t len = client->peekBytes(chunk, std::min((size_t)avail, sizeof(chunk)));
+        bool inBody = req.state() == RequestParser::DONE;
+        bool hadLine = req.requestLine();
+        // Only the bytes the parser used are taken, a pipelined request stays in the client
+        size_t used = inBody ? req.feedBody(chunk, len, appendBody, &body) : req.feed(chunk, len);
+        client->read((uint8_t *)chunk, used);
+
+        if ((req.state() == RequestParser::BAD) || (req.state() == RequestParser::TOO_LARGE)) {
+            log_e("Invalid request");
+            if (req.state() == RequestParser::TOO_LARGE) {
+                _rejectRequest(client, !req.requestLine() ? 414 : inBody ? 413 : 431);
+            }
+            future = CLIENT_MUST_STOP;
+            return true;
+        }
+        if (!hadLine && req.requestLine() && _hook) {
+            _request = &req;
+            _startRequest();
+            future = _callHook(client);
+            _request = &_parser;
+            if (future != CLIENT_REQUEST_CAN_CONTINUE) {
+                return true;
+            }
+        }
+        if (!inBody && (req.state() == RequestParser::DONE) && (req.contentLength() > HTTP_MAX_BODY_SIZE)) {
+            // No need to wait for a body we will never hold
+            log_e("%llu byte body exceeds HTTP_MAX_BODY_SIZE", (unsigned long long)req.contentLength());
+            _rejectRequest(client, 413);
+            future = CLIENT_MUST_STOP;
+            return true;
+        }
+        if (req.complete()) {
+            future = CLIENT_REQUEST_CAN_CONTINUE;
+            return true;
+        }
+        if (!used) {
             break;
         }
     }
-    if (method == HTTP_ANY) {
-        log_e("Unknown HTTP Method: %s", methodStr.c_str());
-        return CLIENT_MUST_STOP;
+    return false;
+}
+
+// Multi-client mode.  Sets up a request _collectRequest has completely received,
+// whose headers and body stay valid until the handler returns.
+HTTPServer::ClientFuture HTTPServer::_dispatchRequest(RequestParser& req, RequestBody& body) {
+    _keepAlive = false; // Until a response header says otherwise
+    _writer._active = false;
+    _resetArgs();
+    _request = &req;
+    _startRequest();
+    return _parseBody(&body, body.size(), body.data());
+}
+
+// The request line of *_request has been parsed
+void HTTPServer::_startRequest() {
+    _currentVersion = _request->versionMinor();
+    _currentUri = _request->str(_request->path()); // Reuses the String's buffer when it fits
+    _chunked = false;
+    _clientContentLength = 0;  // not known yet, or invalid
+}
+
+HTTPServer::ClientFuture HTTPServer::_callHook(WiFiClient* client) {
+    if (!_hook) {
+        return CLIENT_REQUEST_CAN_CONTINUE;
     }
+    return _hook(String(_http_method_str[_request->method()]), _currentUri, client, mime::getContentType);
+}
+
+// The headers of *_request are complete.  Reads the body of length bytes from client
+// unless the caller already holds it in buffered.
+HTTPServer::ClientFuture HTTPServer::_parseBody(Client* client, uint64_t length, char* buffered) {
+    HTTPMethod method = _request->method();
+    const char *searchStr = _request->str(_request->query());
     _currentMethod = method;
+    _clientKeepAlive = _request->keepAlive();
+    if (length > (uint64_t)INT_MAX) {
+        log_e("Content-Length too large");
+        _rejectRequest(_currentClient, 413);
+        return CLIENT_MUST_STOP;
+    }
+    _clientContentLength = (int)length;
 
-    log_v("method: %s url: %s search: %s", methodStr.c_str(), url.c_str(), searchStr.c_str());
+    log_v("method: %s url: %s search: %s", _http_method_str[method], _currentUri.c_str(), searchStr);
 
     //attach handler
-    RequestHandler* handler;
-    for (handler = _firstHandler; handler; handler = handler->next()) {
-        if (handler->canHandle(*this, _currentMethod, _currentUri)) {
-            break;
-        }
-    }
-    _currentHandler = handler;
+    _currentHandler = _findHandler();
 
-    String formData;
     // below is needed only when POST type request
     if (method == HTTP_POST || method == HTTP_PUT || method == HTTP_PATCH || method == HTTP_DELETE) {
         String boundaryStr;
-        String headerName;
-        String headerValue;
         bool isForm = false;
         bool isEncoded = false;
-        //parse headers
-        while (1) {
-            req = client->readStringUntil('\r');
-            client->readStringUntil('\n');
-            if (req == "") {
-                break;    //no moar headers
-            }
-            int headerDiv = req.indexOf(':');
-            if (headerDiv == -1) {
-                break;
-            }
-            headerName = req.substring(0, headerDiv);
-            headerValue = req.substring(headerDiv + 1);
-            headerValue.trim();
-            _collectHeader(headerName.c_str(), headerValue.c_str());
-
-            log_v("headerName: %s", headerName.c_str());
-            log_v("headerValue: %s", headerValue.c_str());
-
-            if (headerName.equalsIgnoreCase(FPSTR(Content_Type))) {
-                using namespace mime;
-                if (headerValue.startsWith(FPSTR(mimeTable[txt].mimeType))) {
-                    isForm = false;
-                } else if (headerValue.startsWith(F("application/x-www-form-urlencoded"))) {
-                    isForm = false;
-                    isEncoded = true;
-                } else if (headerValue.startsWith(F("multipart/"))) {
-                    boundaryStr = headerValue.substring(headerValue.indexOf('=') + 1);
-                    boundaryStr.replace("\"", "");
-                    isForm = true;
-                }
-            } else if (headerName.equalsIgnoreCase(F("Content-Length"))) {
-                _clientContentLength = headerValue.toInt();
-            } else if (headerName.equalsIgnoreCase(F("Host"))) {
-                _hostHeader = headerValue;
+        const char *contentType = _request->header(Content_Type);
+        if (contentType) {
+            using namespace mime;
+            if (!strncmp(contentType, mimeTable[txt].mimeType, strlen(mimeTable[txt].mimeType))) {
+                isForm = false;
+            } else if (!strncmp(contentType, "application/x-www-form-urlencoded", 33)) {
+                isForm = false;
+                isEncoded = true;
+            } else if (!strncmp(contentType, "multipart/", 10)) {
+                const char *eq = strchr(contentType, '=');
+                boundaryStr = eq ? eq + 1 : contentType;
+                boundaryStr.replace("\"", "");
+                isForm = true;
             }
         }
 
@@ -212,139 +287,51 @@ HTTPServer::ClientFuture HTTPServer::_parseRequest(WiFiClient* client) {
             _currentHandler->raw(*this, _currentUri, *_currentRaw);
             log_v("Finish Raw");
         } else if (!isForm) {
-            size_t plainLength;
-            char* plainBuf = readBytesWithTimeout(client, _clientContentLength, plainLength, HTTP_MAX_POST_WAIT);
-            if ((int)plainLength < (int)_clientContentLength) {
-                free(plainBuf);
-                return CLIENT_MUST_STOP;
-            }
-            if (_clientContentLength > 0) {
-                if (isEncoded) {
-                    //url encoded form
-                    if (searchStr != "") {
-                        searchStr += '&';
+            if (buffered) {
+                _body = buffered;
+                _bodyEncoded = isEncoded;
+                log_v("Plain: %s", buffered);
+            } else if (_clientContentLength > 0) {
+                // Small bodies go after the headers in the arena, only large ones need the heap
+                char *body = _request->reserve(_clientContentLength);
+                if (!body) {
+                    // Don't let a client's claimed length take the heap the sketch needs
+                    if ((size_t)_clientContentLength > HTTP_MAX_BODY_SIZE) {
+                        log_e("%d byte body exceeds HTTP_MAX_BODY_SIZE", _clientContentLength);
+                        _rejectRequest(_currentClient, 413);
+                        return CLIENT_MUST_STOP;
                     }
-                    searchStr += plainBuf;
+                    _bodyBuf.reset(new (std::nothrow) char[_clientContentLength + 1]);
+                    body = _bodyBuf.get();
+                    if (!body) {
+                        log_e("No memory for %d byte body", _clientContentLength);
+                        return CLIENT_MUST_STOP;
+                    }
+                    body[_clientContentLength] = 0;
                 }
-                _parseArguments(searchStr);
-                if (!isEncoded) {
-                    //plain post json or other data
-                    RequestArgument& arg = _currentArgs[_currentArgCount++];
-                    arg.key = F("plain");
-                    arg.value = String(plainBuf);
+                if (readBytesWithTimeout(client, body, _clientContentLength, HTTP_MAX_POST_WAIT) < (size_t)_clientContentLength) {
+                    return CLIENT_MUST_STOP;
                 }
-
-                log_v("Plain: %s", plainBuf);
-                free(plainBuf);
-            } else {
-                // No content - but we can still have arguments in the URL.
-                _parseArguments(searchStr);
+                //url encoded form args, or plain post json or other data
+                _body = body;
+                _bodyEncoded = isEncoded;
+                log_v("Plain: %s", body);
             }
         } else {
             // it IS a form
-            _parseArguments(searchStr);
             if (!_parseForm(client, boundaryStr, _clientContentLength)) {
                 return CLIENT_MUST_STOP;
             }
         }
-    } else {
-        String headerName;
-        String headerValue;
-        //parse headers
-        while (1) {
-            req = client->readStringUntil('\r');
-            client->readStringUntil('\n');
-            if (req == "") {
-                break;    //no moar headers
-            }
-            int headerDiv = req.indexOf(':');
-            if (headerDiv == -1) {
-                break;
-            }
-            headerName = req.substring(0, headerDiv);
-            headerValue = req.substring(headerDiv + 2);
-            _collectHeader(headerName.c_str(), headerValue.c_str());
-
-            log_v("headerName: %s", headerName.c_str());
-            log_v("headerValue: %s", headerValue.c_str());
-
-            if (headerName.equalsIgnoreCase("Host")) {
-                _hostHeader = headerValue;
-            }
-        }
-        _parseArguments(searchStr);
     }
     client->flush();
 
-    log_v("Request: %s", url.c_str());
-    log_v(" Arguments: %s", searchStr.c_str());
+    log_v("Request: %s", _currentUri.c_str());
+    log_v(" Arguments: %s", searchStr);
 
     return CLIENT_REQUEST_CAN_CONTINUE;
 }
 
-bool HTTPServer::_collectHeader(const char* headerName, const char* headerValue) {
-    for (int i = 0; i < _headerKeysCount; i++) {
-        if (_currentHeaders[i].key.equalsIgnoreCase(headerName)) {
-            _currentHeaders[i].value = headerValue;
-            return true;
-        }
-    }
-    return false;
-}
-
-void HTTPServer::_parseArguments(String data) {
-    log_v("args: %s", data.c_str());
-    if (_currentArgs) {
-        delete[] _currentArgs;
-    }
-    _currentArgs = 0;
-    if (data.length() == 0) {
-        _currentArgCount = 0;
-        _currentArgs = new RequestArgument[1];
-        return;
-    }
-    _currentArgCount = 1;
-
-    for (int i = 0; i < (int)data.length();) {
-        i = data.indexOf('&', i);
-        if (i == -1) {
-            break;
-        }
-        ++i;
-        ++_currentArgCount;
-    }
-    log_v("args count: %d", _currentArgCount);
-
-    _currentArgs = new RequestArgument[_currentArgCount + 1];
-    int pos = 0;
-    int iarg;
-    for (iarg = 0; iarg < _currentArgCount;) {
-        int equal_sign_index = data.indexOf('=', pos);
-        int next_arg_index = data.indexOf('&', pos);
-        log_v("pos %d =@%d &@%d", pos, equal_sign_index, next_arg_index);
-        if ((equal_sign_index == -1) || ((equal_sign_index > next_arg_index) && (next_arg_index != -1))) {
-            log_e("arg missing value: %d", iarg);
-            if (next_arg_index == -1) {
-                break;
-            }
-            pos = next_arg_index + 1;
-            continue;
-        }
-        RequestArgument& arg = _currentArgs[iarg];
-        arg.key = urlDecode(data.substring(pos, equal_sign_index));
-        arg.value = urlDecode(data.substring(equal_sign_index + 1, next_arg_index));
-        log_v("arg %d key: %s value: %s", iarg, arg.key.c_str(), arg.value.c_str());
-        ++iarg;
-        if (next_arg_index == -1) {
-            break;
-        }
-        pos = next_arg_index + 1;
-    }
-    _currentArgCount = iarg;
-    log_v("args count: %d", _currentArgCount);
-
-}
-
 void HTTPServer::_uploadWriteByte(uint8_t b) {
     if (_currentUpload->currentSize == HTTP_UPLOAD_BUFLEN) {
         if (_currentHandler && _currentHandler->canUpload(*this, _currentUri)) {
@@ -356,7 +343,7 @@ void HTTPServer::_uploadWriteByte(uint8_t b) {
     _currentUpload->buf[_currentUpload->currentSize++] = b;
 }
 
-int HTTPServer::_uploadReadByte(WiFiClient * client) {
+int HTTPServer::_uploadReadByte(Client * client) {
     int res = client->read();
 
     if (res < 0) {
@@ -399,7 +386,7 @@ int HTTPServer::_uploadReadByte(WiFiClient * client) {
     return res;
 }
 
-bool HTTPServer::_parseForm(WiFiClient * client, String boundary, uint32_t len) {
+bool HTTPServer::_parseForm(Client * client, String boundary, uint32_t len) {
     (void)len;
     log_v("Parse Form: Boundary: %s Length: %d", boundary.c_str(), len);
     String line;
@@ -412,9 +399,7 @@ bool HTTPServer::_parseForm(WiFiClient * client, String boundary, uint32_t len)
     client->readStringUntil('\n');
     //start reading the form
     if (line == ("--" + boundary)) {
-        if (_postArgs) {
-            delete[] _postArgs;
-        }
+        delete[] _postArgs;
         _postArgs = new RequestArgument[WEBSERVER_MAX_POST_ARGS];
         _postArgsLen = 0;
         while (1) {
@@ -554,28 +539,7 @@ bool HTTPServer::_parseForm(WiFiClient * client, String boundary, uint32_t len)
             }
         }
 
-        int iarg;
-        int totalArgs = ((WEBSERVER_MAX_POST_ARGS - _postArgsLen) < _currentArgCount) ? (WEBSERVER_MAX_POST_ARGS - _postArgsLen) : _currentArgCount;
-        for (iarg = 0; iarg < totalArgs; iarg++) {
-            RequestArgument &arg = _postArgs[_postArgsLen++];
-            arg.key = _currentArgs[iarg].key;
-            arg.value = _currentArgs[iarg].value;
-        }
-        if (_currentArgs) {
-            delete[] _currentArgs;
-        }
-        _currentArgs = new RequestArgument[_postArgsLen];
-        for (iarg = 0; iarg < _postArgsLen; iarg++) {
-            RequestArgument &arg = _currentArgs[iarg];
-            arg.key = _postArgs[iarg].key;
-            arg.value = _postArgs[iarg].value;
-        }
-        _currentArgCount = iarg;
-        if (_postArgs) {
-            delete[] _postArgs;
-            _postArgs = nullptr;
-            _postArgsLen = 0;
-        }
+        // The query args follow these, see _findArg
         return true;
     }
     log_e("Error: line: %s", line.c_str());
@@ -7,6 +7,7 @@ class Uri {
 
 protected:
     const String _uri;
+    bool _literal = false; // Only set on plain Uris, so subclasses aren't indexed as literals
 
 public:
     Uri(const char *uri) : _uri(uri) {}
@@ -15,7 +16,9 @@ public:
     virtual ~Uri() {}
 
     virtual Uri* clone() const {
-        return new Uri(_uri);
+        Uri *u = new Uri(_uri);
+        u->_literal = true;
+        return u;
     };
 
     virtual void initPathArgs(__attribute__((unused)) std::vector<String> &pathArgs) {}
@@ -23,4 +26,11 @@ public:
     virtual bool canHandle(const String &requestUri, __attribute__((unused)) std::vector<String> &pathArgs) {
         return _uri == requestUri;
     }
+
+    // Pattern for the WebServer routing index, with whole "{}" path segments as parameters
+    // when params is set.  nullptr if only canHandle() can tell what matches.
+    virtual const char *routePattern(bool &params) const {
+        params = false;
+        return _literal ? _uri.c_str() : nullptr;
+    }
 };
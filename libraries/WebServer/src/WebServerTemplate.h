@@ -42,6 +42,10 @@ public:
     virtual void close();
     virtual void stop();
 
+    // Serve up to maxClients connections at once, with HTTP/1.1 keep-alive.
+    // The default of 1 handles one connection at a time, start to finish.
+    void setMaxClients(int maxClients);
+
     ServerType &getServer() {
         return _server;
     }
@@ -52,7 +56,23 @@ public:
     }
 
 private:
+    void _handleClients();
+    void _closeClients();
+
+    typedef struct {
+        ClientType *client;
+        HTTPClientStatus status;
+        unsigned long statusChange;
+        RequestParser parser;   // Request being received
+        RequestBody body;       // Its body so far
+        bool started;   // parser.begin() called for the current request
+        bool served;    // At least one request answered on this connection
+    } Connection;
+
     ServerType _server;
+    Connection *_conns = nullptr;
+    int _maxClients = 1;
+    int _nextConn = 0;
 };
 
 template <typename ServerType, int DefaultPort>
@@ -66,6 +86,8 @@ WebServerTemplate<ServerType, DefaultPort>::WebServerTemplate(int port) : HTTPSe
 template <typename ServerType, int DefaultPort>
 WebServerTemplate<ServerType, DefaultPort>::~WebServerTemplate() {
     _server.close();
+    _closeClients();
+    delete[] _conns;
 }
 
 template <typename ServerType, int DefaultPort>
@@ -82,8 +104,30 @@ void WebServerTemplate<ServerType, DefaultPort>::begin(uint16_t port) {
     _server.setNoDelay(true);
 }
 
+template <typename ServerType, int DefaultPort>
+void WebServerTemplate<ServerType, DefaultPort>::setMaxClients(int maxClients) {
+    if (maxClients < 1) {
+        maxClients = 1;
+    }
+    _closeClients();
+    delete[] _conns;
+    _conns = nullptr;
+    _maxClients = maxClients;
+    _keepAliveMode = maxClients > 1;
+    if (_keepAliveMode) {
+        _conns = new Connection[maxClients];
+        for (int i = 0; i < maxClients; i++) {
+            _conns[i].client = nullptr;
+        }
+    }
+}
+
 template <typename ServerType, int DefaultPort>
 void WebServerTemplate<ServerType, DefaultPort>::handleClient() {
+    if (_conns) {
+        _handleClients();
+        return;
+    }
     if (_currentStatus == HC_NONE) {
         if (_currentClient) {
             delete _currentClient;
@@ -179,9 +223,125 @@ void WebServerTemplate<ServerType, DefaultPort>::handleClient() {
 
 }
 
+// Multi-client mode.  lwIP buffers incoming data for every connection in the
+// background, and each connection's parser takes whatever has arrived on every
+// pass, so a slow client never holds up the others.  A request is dispatched
+// once its parser has seen all of it.  Handlers still run here, one at a time,
+// in the caller's context.
+template <typename ServerType, int DefaultPort>
+void WebServerTemplate<ServerType, DefaultPort>::_handleClients() {
+    for (int i = 0; (i < _maxClients) && _server.hasClient(); i++) {
+        Connection &c = _conns[i];
+        if (!c.client) {
+            c.client = new ClientType(_server.accept());
+            c.status = HC_WAIT_READ;
+            c.statusChange = millis();
+            c.body.reset();
+            c.started = false;
+            c.served = false;
+        }
+    }
+
+    bool idle = true;
+    // Round-robin so an always-busy connection can't starve later ones
+    for (int n = 0; n < _maxClients; n++) {
+        int i = (_nextConn + n) % _maxClients;
+        Connection &c = _conns[i];
+        if (!c.client) {
+            continue;
+        }
+        bool keep = false;
+        if (c.client->connected() || c.client->available()) {
+            if (c.status == HC_WAIT_READ) {
+                bool arrived = c.client->available() > 0;
+                bool ready = false;
+                ClientFuture future = CLIENT_MUST_STOP;
+                if (arrived && !c.started) {
+                    c.started = c.parser.begin();
+                    ready = !c.started; // No memory for the arena, give up
+                }
+                if (arrived && c.started) {
+                    _currentClient = c.client;
+                    _currentClient->setTimeout(HTTP_MAX_SEND_WAIT);
+                    ready = _collectRequest(_currentClient, c.parser, c.body, future);
+                }
+                if (ready) {
+                    idle = false;
+                    _nextConn = (i + 1) % _maxClients;
+                    _currentClient = c.client;
+                    if (future == CLIENT_REQUEST_CAN_CONTINUE) {
+                        future = _dispatchRequest(c.parser, c.body);
+                    }
+                    switch (future) {
+                    case CLIENT_REQUEST_CAN_CONTINUE:
+                        _contentLength = CONTENT_LENGTH_NOT_SET;
+                        _handleRequest();
+                    /* fallthrough */
+                    case CLIENT_REQUEST_IS_HANDLED:
+                        keep = c.client->connected() || c.client->available();
+                        c.status = _keepAlive ? HC_WAIT_READ : HC_WAIT_CLOSE;
+                        c.statusChange = millis();
+                        c.served = true;
+                        break;
+                    case CLIENT_MUST_STOP:
+                        c.client->stop();
+                        break;
+                    case CLIENT_IS_GIVEN:
+                        // The handler kept its own copy, dropping ours doesn't close the connection
+                        delete c.client;
+                        c.client = nullptr;
+                        break;
+                    }
+                    _request = &_parser;
+                    _resetArgs(); // May point into c.body
+                    c.body.reset();
+                    c.started = false;
+                    _currentClient = nullptr;
+                    _currentUpload.reset();
+                    _currentRaw.reset();
+                } else {
+                    if (arrived) {
+                        c.statusChange = millis(); // Still making progress
+                    }
+                    // A partial request gets the usual data timeout, an idle keep-alive connection its own
+                    unsigned long limit = (c.served && !c.started) ? HTTP_MAX_KEEPALIVE_WAIT : HTTP_MAX_DATA_WAIT;
+                    keep = millis() - c.statusChange <= limit;
+                    _currentClient = nullptr;
+                }
+            } else {
+                // HC_WAIT_CLOSE, wait for the client to close the connection
+                keep = millis() - c.statusChange <= HTTP_MAX_CLOSE_WAIT;
+            }
+        }
+        if (!keep && c.client) {
+            delete c.client;
+            c.client = nullptr;
+            c.body.reset();
+        }
+    }
+
+    if (idle) {
+        if (_nullDelay) {
+            delay(1);
+        } else {
+            yield();
+        }
+    }
+}
+
+template <typename ServerType, int DefaultPort>
+void WebServerTemplate<ServerType, DefaultPort>::_closeClients() {
+    for (int i = 0; _conns && (i < _maxClients); i++) {
+        delete _conns[i].client;
+        _conns[i].client = nullptr;
+        _conns[i].body.reset();
+    }
+}
+
 template <typename ServerType, int DefaultPort>
 void WebServerTemplate<ServerType, DefaultPort>::close() {
     _server.close();
+    _closeClients();
     httpClose();
 }
 
@@ -0,0 +1,136 @@
+/*
+    RequestBody - A received request body read back through the Client interface
+
+    Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+// The multi-client mode collects a whole request body before running its handler,
+// then hands it to the same form, raw, and plain body code that otherwise reads
+// straight from the connection.  Reads past the end fail at once, like a closed
+// connection, instead of waiting for more data.
+class RequestBody : public Client {
+public:
+    RequestBody() {
+        setTimeout(0);
+    }
+    ~RequestBody() {
+        free(_buf);
+    }
+    RequestBody(const RequestBody&) = delete;
+    RequestBody& operator=(const RequestBody&) = delete;
+
+    // Adds decoded body data, false once the body would exceed max bytes or memory runs out
+    bool append(const char *data, size_t len, size_t max) {
+        if (len > max - _len) {
+            return false;
+        }
+        if (_len + len + 1 > _cap) {
+            size_t cap = std::max(_cap * 2, (size_t)256);
+            cap = std::min(std::max(cap, _len + len + 1), max + 1);
+            char *buf = (char *)realloc(_buf, cap);
+            if (!buf) {
+                return false;
+            }
+            _buf = buf;
+            _cap = cap;
+        }
+        memcpy(_buf + _len, data, len);
+        _len += len;
+        _buf[_len] = 0;
+        return true;
+    }
+
+    // Drops the body and its memory, ready for the next request
+    void reset() {
+        free(_buf);
+        _buf = nullptr;
+        _cap = 0;
+        _len = 0;
+        _pos = 0;
+    }
+
+    size_t size() const {
+        return _len;
+    }
+    // NUL-terminated, nullptr while empty
+    char *data() {
+        return _buf;
+    }
+
+    virtual int available() override {
+        return _len - _pos;
+    }
+    virtual int read() override {
+        return (_pos < _len) ? (uint8_t)_buf[_pos++] : -1;
+    }
+    virtual int read(uint8_t *buf, size_t size) override {
+        size = std::min(size, _len - _pos);
+        memcpy(buf, _buf + _pos, size);
+        _pos += size;
+        return size;
+    }
+    virtual int peek() override {
+        return (_pos < _len) ? (uint8_t)_buf[_pos] : -1;
+    }
+    // "Connected" while there is still body left to read
+    virtual uint8_t connected() override {
+        return _pos < _len;
+    }
+    virtual operator bool() override {
+        return true;
+    }
+
+    // Nothing to connect or write to
+    virtual int connect(IPAddress ip, uint16_t port) override {
+        (void) ip;
+        (void) port;
+        return 0;
+    }
+    virtual int connect(const char *host, uint16_t port) override {
+        (void) host;
+        (void) port;
+        return 0;
+    }
+    virtual size_t write(uint8_t b) override {
+        (void) b;
+        return 0;
+    }
+    virtual size_t write(const uint8_t *buf, size_t size) override {
+        (void) buf;
+        (void) size;
+        return 0;
+    }
+    virtual void flush() override {
+    }
+    virtual void stop() override {
+        _pos = _len;
+    }
+
+private:
+    char *_buf = nullptr;
+    size_t _cap = 0;
+    size_t _len = 0;
+    size_t _pos = 0;
+};
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <assert.h>
+#include "RouteTrie.h"
 
 class RequestHandler {
 public:
@@ -74,6 +75,26 @@ public:
         return *this;
     }
 
+    /*
+        note: routing index support.  Handlers that return a route pattern are
+        found by walking a tree of path segments instead of calling canHandle()
+        on every request.  routeMatched() then sees only the requests whose path
+        and method match, with the parameters' positions in the uri.
+    */
+
+    virtual const char *routePattern(bool &params, uint64_t &methods) {
+        (void)params;
+        (void)methods;
+        return nullptr;
+    }
+    virtual bool routeMatched(HTTPServer &server, const char *uri, const RouteCapture *caps, int count) {
+        (void)server;
+        (void)uri;
+        (void)caps;
+        (void)count;
+        return false;
+    }
+
 private:
     RequestHandler* _next = nullptr;
 
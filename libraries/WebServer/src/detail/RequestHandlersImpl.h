@@ -3,6 +3,9 @@
 #include "RequestHandler.h"
 #include "mimetable.h"
 #include <api/String.h>
+#include <algorithm>
+#include <ctype.h>
+#include <string.h>
 #include "Uri.h"
 
 #ifndef log_e
@@ -98,6 +101,19 @@ public:
         }
     }
 
+    const char *routePattern(bool &params, uint64_t &methods) override {
+        methods = (_method == HTTP_ANY) ? ~0ULL : (1ULL << _method);
+        return _uri->routePattern(params);
+    }
+
+    bool routeMatched(HTTPServer &server, const char *uri, const RouteCapture *caps, int count) override {
+        for (int i = 0; (i < count) && (i < (int)pathArgs.size()); i++) {
+            pathArgs[i] = "";
+            pathArgs[i].concat(uri + caps[i].off, caps[i].len);
+        }
+        return _filter != NULL ? _filter(server) : true;
+    }
+
     FunctionRequestHandler& setFilter(HTTPServer::FilterFunction filter) {
         _filter = filter;
         return *this;
@@ -177,23 +193,72 @@ public:
 
         String contentType = getContentType(path);
 
-        // look for gz file, only if the original specified path is not a gz.  So part only works to send gzip via content encoding when a non compressed is asked for
-        // if you point the the path to gzip you will serve the gzip as content type "application/x-gzip", not text or javascript etc...
-        if (!path.endsWith(FPSTR(mimeTable[gz].endsWith)) && !_fs.exists(path))  {
-            String pathWithGz = path + FPSTR(mimeTable[gz].endsWith);
-            if (_fs.exists(pathWithGz)) {
-                path += FPSTR(mimeTable[gz].endsWith);
-            }
+        // A .gz sibling is sent to clients that accept gzip, or to everyone when the uncompressed file is missing.
+        // If you point the path to a gzip you will serve the gzip as content type "application/x-gzip", not text or javascript etc...
+        const char *acceptEncoding = server.requestHeader("Accept-Encoding");
+        File f;
+        FileInfo *info = _lookup(path, acceptEncoding && strstr(acceptEncoding, "gzip"), f);
+        if (!info) {
+            return false;
         }
 
-        File f = _fs.open(path, "r");
-        if (!f || !f.available()) {
-            return false;
+        char etag[32];
+        snprintf(etag, sizeof(etag), "\"%x-%x%s\"", (unsigned)info->size, info->mtime ? (unsigned)info->mtime : (unsigned)info->hash, info->gzip ? "-gz" : "");
+        const char *ifNoneMatch = server.requestHeader("If-None-Match");
+        bool notModified = ifNoneMatch && _etagMatches(ifNoneMatch, etag);
+        if (!notModified && !f) {
+            f = _fs.open(info->gzip ? path + FPSTR(mimeTable[gz].endsWith) : path, "r");
+            if (!f) {
+                return false;
+            }
         }
 
+        server.sendHeader("ETag", etag);
         if (_cache_header.length() != 0) {
             server.sendHeader("Cache-Control", _cache_header);
         }
+        if (info->hasGzip) {
+            server.sendHeader("Vary", "Accept-Encoding");
+        }
+
+        if (notModified) {
+            // The length the body would have had, but no body
+            server.setContentLength(info->size);
+            server.send(304, contentType, "");
+            return true;
+        }
+
+        server.sendHeader("Accept-Ranges", "bytes");
+        const char *range = server.requestHeader("Range");
+        const char *ifRange = server.requestHeader("If-Range");
+        size_t first, last;
+        bool satisfiable;
+        if (range && (!ifRange || _etagStrongMatch(ifRange, etag)) && _parseRange(range, info->size, first, last, satisfiable)) {
+            char contentRange[48];
+            if (!satisfiable) {
+                snprintf(contentRange, sizeof(contentRange), "bytes */%u", (unsigned)info->size);
+                server.sendHeader("Content-Range", contentRange);
+                server.send(416, "text/plain", "");
+                return true;
+            }
+            snprintf(contentRange, sizeof(contentRange), "bytes %u-%u/%u", (unsigned)first, (unsigned)last, (unsigned)info->size);
+            server.sendHeader("Content-Range", contentRange);
+            if (info->gzip && (contentType != String(FPSTR(mimeTable[gz].mimeType))) && (contentType != String(FPSTR(mimeTable[none].mimeType)))) {
+                server.sendHeader("Content-Encoding", "gzip");
+            }
+            server.setContentLength(last - first + 1);
+            server.send(206, contentType, "");
+            f.seek(first);
+            uint8_t buf[512];
+            for (size_t left = last - first + 1; left;) {
+                size_t n = f.read(buf, std::min(left, sizeof(buf)));
+                if (!n || (server.client().write(buf, n) != n)) {
+                    break;
+                }
+                left -= n;
+            }
+            return true;
+        }
 
         server.streamFile(f, contentType);
         return true;
@@ -229,4 +294,158 @@ protected:
     String _cache_header;
     bool _isFile;
     size_t _baseUriLength;
+
+    typedef struct {
+        String path;            // Requested file, without any .gz added
+        bool acceptGzip;
+        bool hasGzip;           // A .gz sibling exists, so responses vary by Accept-Encoding
+        bool gzip;              // Serving the .gz sibling
+        size_t size;
+        time_t mtime;
+        uint32_t hash;          // Of the contents, only for file systems without timestamps
+        unsigned long checked;
+        uint32_t used;
+    } FileInfo;
+    std::vector<FileInfo> _files; // Small LRU, so most requests don't touch the file system
+    uint32_t _useCount = 0;
+
+    // Returns the remembered information for path, refreshing it if it's stale.  If that
+    // meant opening the file, f is left open.  nullptr if there's nothing to send.
+    FileInfo *_lookup(const String &path, bool acceptGzip, File &f) {
+        FileInfo *info = nullptr;
+        for (auto &i : _files) {
+            if ((i.acceptGzip == acceptGzip) && (i.path == path)) {
+                info = &i;
+                break;
+            }
+        }
+        if (info && (millis() - info->checked < HTTP_STATIC_CACHE_MS)) {
+            info->used = ++_useCount;
+            return info;
+        }
+        if (!info) {
+            if (_files.size() < HTTP_STATIC_CACHE_SIZE) {
+                _files.push_back(FileInfo());
+                info = &_files.back();
+            } else {
+                info = &_files[0];
+                for (auto &i : _files) {
+                    if (i.used < info->used) {
+                        info = &i;
+                    }
+                }
+            }
+            info->path = path;
+            info->acceptGzip = acceptGzip;
+            info->size = (size_t) -1;
+            info->mtime = 0;
+            info->hash = 0;
+        }
+
+        String gzPath = path + FPSTR(mimeTable[gz].endsWith);
+        info->hasGzip = !path.endsWith(FPSTR(mimeTable[gz].endsWith)) && _fs.exists(gzPath);
+        info->gzip = info->hasGzip && (acceptGzip || !_fs.exists(path));
+        f = _fs.open(info->gzip ? gzPath : path, "r");
+        if (!f || f.isDirectory() || !f.size()) {
+            // Not remembered, the file may show up later
+            f = File();
+            info->path = "";
+            info->used = 0;
+            return nullptr;
+        }
+        size_t size = f.size();
+        time_t mtime = f.getLastWrite();
+        if (!mtime) {
+            // Without timestamps only the contents tell versions apart, and a rewrite
+            // can keep the size, so hash every time the file is checked again
+            uint32_t hash = 2166136261UL; // FNV-1a
+            uint8_t buf[256];
+            size_t n;
+            while ((n = f.read(buf, sizeof(buf))) > 0) {
+                for (size_t i = 0; i < n; i++) {
+                    hash = (hash ^ buf[i]) * 16777619UL;
+                }
+            }
+            f.seek(0);
+            info->hash = hash;
+        }
+        info->size = size;
+        info->mtime = mtime;
+        info->checked = millis();
+        info->used = ++_useCount;
+        return info;
+    }
+
+    // If-Range needs the strong comparison, a weak W/ tag never matches
+    static bool _etagStrongMatch(const char *ifRange, const char *etag) {
+        while (*ifRange == ' ') {
+            ifRange++;
+        }
+        size_t len = strlen(etag);
+        return !strncmp(ifRange, etag, len) && (!ifRange[len] || (ifRange[len] == ' '));
+    }
+
+    // If-None-Match lists, weak tags compare equal to strong ones
+    static bool _etagMatches(const char *list, const char *etag) {
+        size_t len = strlen(etag);
+        for (const char *p = list; p; p = strchr(p, ',')) {
+            while ((*p == ',') || (*p == ' ')) {
+                p++;
+            }
+            if (*p == '*') {
+                return true;
+            }
+            if (!strncmp(p, "W/", 2)) {
+                p += 2;
+            }
+            if (!strncmp(p, etag, len) && (!p[len] || (p[len] == ',') || (p[len] == ' '))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Only a single "bytes=" range is supported, otherwise the whole file is sent
+    static bool _parseRange(const char *range, size_t size, size_t &first, size_t &last, bool &satisfiable) {
+        if (strncmp(range, "bytes=", 6) || strchr(range, ',')) {
+            return false;
+        }
+        const char *p = range + 6;
+        char *end;
+        if (*p == '-') {
+            if (!isdigit(p[1])) {
+                return false;
+            }
+            unsigned long long n = strtoull(p + 1, &end, 10);
+            if (*end) {
+                return false;
+            }
+            satisfiable = n > 0;
+            first = (n >= size) ? 0 : size - n;
+            last = size - 1;
+            return true;
+        }
+        if (!isdigit(*p)) {
+            return false;
+        }
+        unsigned long long a = strtoull(p, &end, 10);
+        if (*end != '-') {
+            return false;
+        }
+        p = end + 1;
+        unsigned long long b = size - 1;
+        if (*p) {
+            if (!isdigit(*p)) {
+                return false;
+            }
+            b = strtoull(p, &end, 10);
+            if (*end || (b < a)) {
+                return false;
+            }
+        }
+        satisfiable = a < size;
+        first = a;
+        last = std::min(b, (unsigned long long)size - 1);
+        return true;
+    }
 };
@@ -0,0 +1,324 @@
+/*
+    RequestParser - Allocation-free HTTP request header parser for WebServer
+
+    Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include <new>
+#include "RequestParser.h"
+
+RequestParser::RequestParser(size_t arenaSize) {
+    // Views are 16 bits
+    _size = (arenaSize > 65535) ? 65535 : arenaSize;
+    _arena = nullptr;
+    _used = 0;
+    _path = { 0, 0 };
+    _query = { 0, 0 };
+    _headerCount = 0;
+    _lineDone = false;
+    http_parser_settings_init(&_settings);
+    _settings.on_url = _onUrl;
+    _settings.on_header_field = _onHeaderField;
+    _settings.on_header_value = _onHeaderValue;
+    _settings.on_headers_complete = _onHeadersComplete;
+    _settings.on_body = _onBody;
+    _settings.on_message_complete = _onMessageComplete;
+    _complete = false;
+    _sink = nullptr;
+    _sinkParam = nullptr;
+    _state = BAD;
+}
+
+RequestParser::~RequestParser() {
+    delete[] _arena;
+}
+
+bool RequestParser::begin() {
+    if (!_arena) {
+        // Allocated once and reused for every request
+        _arena = new (std::nothrow) char[_size];
+        if (!_arena) {
+            return false;
+        }
+    }
+    http_parser_init(&_parser, HTTP_REQUEST);
+    _parser.data = this;
+    // Offset 0 is always "", the default for every view
+    _arena[0] = 0;
+    _used = 1;
+    _piece = NONE;
+    _open = { 0, 0 };
+    _newlines = 1; // At the start of a line
+    _overflow = false;
+    _lineDone = false;
+    _headersDone = false;
+    _complete = false;
+    _sink = nullptr;
+    _state = NEED_MORE;
+    _path = { 0, 0 };
+    _query = { 0, 0 };
+    _headerCount = 0;
+    _skipHeader = false;
+    _method = HTTP_GET;
+    _major = 0;
+    _minor = 0;
+    _keepAlive = false;
+    _chunked = false;
+    _hasLength = false;
+    _contentLength = 0;
+    return true;
+}
+
+size_t RequestParser::feed(const char *data, size_t len) {
+    size_t used = 0;
+    while ((_state == NEED_MORE) && (used < len)) {
+        // Hand the parser one possible header block end at a time so it never sees body bytes
+        size_t end = used;
+        bool blank = false;
+        bool line = false;
+        while ((end < len) && !blank && !line) {
+            char c = data[end++];
+            if (c == '\n') {
+                blank = ++_newlines >= 2;
+                line = !_lineDone && !blank;
+            } else if (c != '\r') {
+                _newlines = 0;
+            }
+        }
+        size_t n = http_parser_execute(&_parser, &_settings, data + used, end - used);
+        // A request without a body completes, and pauses the parser, with the headers
+        bool ok = (HTTP_PARSER_ERRNO(&_parser) == HPE_OK) || _complete;
+        if (!ok || (n != end - used)) {
+            _state = _overflow ? TOO_LARGE : BAD;
+            return used + n;
+        }
+        used = end;
+        if (_headersDone) {
+            _state = DONE;
+        } else if (line) {
+            _close(); // The URL, there can't be more of it
+            _lineDone = true;
+            _method = (enum http_method)_parser.method;
+            _major = _parser.http_major;
+            _minor = _parser.http_minor;
+            break;
+        } else if (blank) {
+            _newlines = 1; // Only empty lines before the request line
+        }
+    }
+    return used;
+}
+
+size_t RequestParser::feedBody(const char *data, size_t len, BodySink sink, void *param) {
+    if ((_state != DONE) || _complete || !len) {
+        return 0;
+    }
+    _sink = sink;
+    _sinkParam = param;
+    size_t n = http_parser_execute(&_parser, &_settings, data, len);
+    _sink = nullptr;
+    if (!_complete && (HTTP_PARSER_ERRNO(&_parser) != HPE_OK)) {
+        _state = _overflow ? TOO_LARGE : BAD;
+    }
+    return n;
+}
+
+const char *RequestParser::header(const char *name) const {
+    for (int i = _headerCount - 1; i >= 0; i--) {
+        if (!strcasecmp(str(_headers[i].name), name)) {
+            return str(_headers[i].value);
+        }
+    }
+    return nullptr;
+}
+
+char *RequestParser::reserve(size_t len) {
+    if (!_arena || (len + 1 > _size - _used)) {
+        return nullptr;
+    }
+    char *p = _arena + _used;
+    _used += len + 1;
+    p[len] = 0;
+    return p;
+}
+
+bool RequestParser::_append(Piece piece, const char *at, size_t len) {
+    if (piece != _piece) {
+        _close();
+        _piece = piece;
+        if (piece == FIELD) {
+            _skipHeader = _headerCount >= HTTP_MAX_HEADERS;
+        }
+        _open = { (uint16_t)_used, 0 };
+    }
+    if ((piece != URL) && _skipHeader) {
+        return true;
+    }
+    // Always leave room for the closing NUL
+    if (len + 1 > _size - _used) {
+        _overflow = true;
+        return false;
+    }
+    memcpy(_arena + _used, at, len);
+    _used += len;
+    _open.len += len;
+    return true;
+}
+
+void RequestParser::_close() {
+    Piece piece = _piece;
+    _piece = NONE;
+    if ((piece == NONE) || ((piece != URL) && _skipHeader) || (_used >= _size)) {
+        return;
+    }
+    _arena[_used++] = 0;
+    if (piece == URL) {
+        char *q = (char *)memchr(_arena + _open.off, '?', _open.len);
+        if (q) {
+            *q = 0;
+            uint16_t qoff = q - _arena;
+            _path = { _open.off, (uint16_t)(qoff - _open.off) };
+            _query = { (uint16_t)(qoff + 1), (uint16_t)(_open.len - (qoff - _open.off) - 1) };
+        } else {
+            _path = _open;
+            _query = { (uint16_t)(_open.off + _open.len), 0 };
+        }
+    } else if (piece == FIELD) {
+        // Point the value at the name's NUL in case the header is empty
+        _headers[_headerCount].name = _open;
+        _headers[_headerCount].value = { (uint16_t)(_open.off + _open.len), 0 };
+        _headerCount++;
+    } else {
+        while (_open.len && ((_arena[_open.off + _open.len - 1] == ' ') || (_arena[_open.off + _open.len - 1] == '\t'))) {
+            _arena[_open.off + --_open.len] = 0;
+        }
+        _headers[_headerCount - 1].value = _open;
+    }
+}
+
+int RequestParser::_onUrl(http_parser *p, const char *at, size_t len) {
+    return ((RequestParser *)p->data)->_append(URL, at, len) ? 0 : 1;
+}
+
+int RequestParser::_onHeaderField(http_parser *p, const char *at, size_t len) {
+    return ((RequestParser *)p->data)->_append(FIELD, at, len) ? 0 : 1;
+}
+
+int RequestParser::_onHeaderValue(http_parser *p, const char *at, size_t len) {
+    return ((RequestParser *)p->data)->_append(VALUE, at, len) ? 0 : 1;
+}
+
+int RequestParser::_onHeadersComplete(http_parser *p) {
+    RequestParser *r = (RequestParser *)p->data;
+    r->_close();
+    if (r->_overflow) {
+        return -1;
+    }
+    r->_headersDone = true;
+    r->_method = (enum http_method)p->method;
+    r->_major = p->http_major;
+    r->_minor = p->http_minor;
+    r->_keepAlive = http_should_keep_alive(p);
+    r->_chunked = p->flags & F_CHUNKED;
+    r->_hasLength = p->content_length != ULLONG_MAX;
+    r->_contentLength = p->content_length;
+    return 0;
+}
+
+int RequestParser::_onBody(http_parser *p, const char *at, size_t len) {
+    RequestParser *r = (RequestParser *)p->data;
+    if (r->_sink && !r->_sink(r->_sinkParam, at, len)) {
+        r->_overflow = true;
+        return 1;
+    }
+    return 0;
+}
+
+int RequestParser::_onMessageComplete(http_parser *p) {
+    // Stop here, anything after this belongs to the next request
+    ((RequestParser *)p->data)->_complete = true;
+    http_parser_pause(p, 1);
+    return 0;
+}
+
+bool RequestParser::nextArg(const char *&cursor, Arg &arg) {
+    while (cursor && *cursor) {
+        const char *start = cursor;
+        const char *amp = strchr(start, '&');
+        const char *end = amp ? amp : start + strlen(start);
+        cursor = amp ? amp + 1 : end;
+        const char *eq = (const char *)memchr(start, '=', end - start);
+        if (eq) {
+            arg.key = start;
+            arg.keyLen = eq - start;
+            arg.value = eq + 1;
+            arg.valueLen = end - eq - 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+static int hexDigit(char c) {
+    if ((c >= '0') && (c <= '9')) {
+        return c - '0';
+    } else if ((c >= 'a') && (c <= 'f')) {
+        return c - 'a' + 10;
+    } else if ((c >= 'A') && (c <= 'F')) {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Same results as the strtol() based HTTPServer::urlDecode, including for bad escapes
+char RequestParser::urlDecodeChar(const char *src, size_t len, size_t &i) {
+    char c = src[i++];
+    if ((c == '%') && (i + 1 < len)) {
+        int hi = hexDigit(src[i++]);
+        int lo = hexDigit(src[i++]);
+        if (hi < 0) {
+            return 0;
+        }
+        return (lo < 0) ? hi : ((hi << 4) | lo);
+    }
+    return (c == '+') ? ' ' : c;
+}
+
+size_t RequestParser::urlDecode(const char *src, size_t len, char *dst) {
+    size_t out = 0;
+    for (size_t i = 0; i < len;) {
+        char c = urlDecodeChar(src, len, i);
+        if (dst) {
+            dst[out] = c;
+        }
+        out++;
+    }
+    return out;
+}
+
+bool RequestParser::urlDecodedEquals(const char *src, size_t len, const char *match, size_t matchLen) {
+    size_t out = 0;
+    for (size_t i = 0; i < len; out++) {
+        if ((out >= matchLen) || (urlDecodeChar(src, len, i) != match[out])) {
+            return false;
+        }
+    }
+    return out == matchLen;
+}
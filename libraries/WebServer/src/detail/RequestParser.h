@@ -0,0 +1,189 @@
+/*
+    RequestParser - Allocation-free HTTP request header parser for WebServer
+
+    Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+// No Arduino dependencies so tools/webparsebench.cpp can run it on a PC
+#include <stddef.h>
+#include <stdint.h>
+#include "http_parser.h"
+
+#ifndef HTTP_ARENA_SIZE
+#define HTTP_ARENA_SIZE 4096 // Request line, all headers, and small bodies
+#endif
+
+#ifndef HTTP_MAX_HEADERS
+#define HTTP_MAX_HEADERS 32 // Later headers are parsed but not kept
+#endif
+
+// Streams a request through http_parser and stores the URL and headers as
+// NUL-terminated pieces of one fixed arena, referenced by offset and length.
+// Feeding pauses once after the request line, so a hook can still read the
+// headers itself, and stops at the blank line ending the headers, so any body
+// is left for the caller to read or to pass through feedBody().
+class RequestParser {
+public:
+    typedef struct {
+        uint16_t off;
+        uint16_t len;
+    } View;
+
+    typedef struct {
+        const char *key;
+        size_t keyLen;
+        const char *value;
+        size_t valueLen;
+    } Arg;
+
+    // Receives decoded body data, returns false to abandon the request
+    typedef bool (*BodySink)(void *param, const char *data, size_t len);
+
+    enum State { NEED_MORE, DONE, TOO_LARGE, BAD };
+
+    RequestParser(size_t arenaSize = HTTP_ARENA_SIZE);
+    ~RequestParser();
+
+    // Start a new request, keeping the arena
+    bool begin();
+    // Returns the bytes used, which stops right after the request line or the header block
+    size_t feed(const char *data, size_t len);
+    State state() const {
+        return _state;
+    }
+    // Method, version, path, and query are valid
+    bool requestLine() const {
+        return _lineDone;
+    }
+    // After DONE, decodes the Content-Length or chunked body into sink.  Returns the
+    // bytes used, which stops at the end of the request so a pipelined one is left.
+    // State becomes TOO_LARGE if the sink refuses data, or BAD on a framing error.
+    size_t feedBody(const char *data, size_t len, BodySink sink, void *param);
+    // The whole request, including any body, has been seen
+    bool complete() const {
+        return _complete;
+    }
+
+    enum http_method method() const {
+        return _method;
+    }
+    int versionMajor() const {
+        return _major;
+    }
+    int versionMinor() const {
+        return _minor;
+    }
+    bool keepAlive() const {
+        return _keepAlive;
+    }
+    bool chunked() const {
+        return _chunked;
+    }
+    bool hasContentLength() const {
+        return _hasLength;
+    }
+    uint64_t contentLength() const {
+        return _hasLength ? _contentLength : 0;
+    }
+
+    const char *str(View v) const {
+        return _arena ? _arena + v.off : "";
+    }
+    // Path without the query, and the query without the '?'
+    View path() const {
+        return _path;
+    }
+    View query() const {
+        return _query;
+    }
+    int headers() const {
+        return _headerCount;
+    }
+    View headerName(int i) const {
+        return _headers[i].name;
+    }
+    View headerValue(int i) const {
+        return _headers[i].value;
+    }
+    // Case-insensitive, the last one wins.  nullptr if not present.
+    const char *header(const char *name) const;
+
+    // Space for a body of len bytes (plus a NUL) after the headers, nullptr if it won't fit
+    char *reserve(size_t len);
+    size_t used() const {
+        return _used;
+    }
+
+    // Walks an "a=1&b=%20" list.  Entries without an '=' are skipped.
+    static bool nextArg(const char *&cursor, Arg &arg);
+    // Decodes %xx and '+', dst may be nullptr to just get the decoded length
+    static size_t urlDecode(const char *src, size_t len, char *dst);
+    // Decodes one character starting at src[i], advancing i
+    static char urlDecodeChar(const char *src, size_t len, size_t &i);
+    static bool urlDecodedEquals(const char *src, size_t len, const char *match, size_t matchLen);
+
+private:
+    enum Piece { NONE, URL, FIELD, VALUE };
+
+    typedef struct {
+        View name;
+        View value;
+    } Header;
+
+    bool _append(Piece piece, const char *at, size_t len);
+    void _close();
+
+    static int _onUrl(http_parser *p, const char *at, size_t len);
+    static int _onHeaderField(http_parser *p, const char *at, size_t len);
+    static int _onHeaderValue(http_parser *p, const char *at, size_t len);
+    static int _onHeadersComplete(http_parser *p);
+    static int _onBody(http_parser *p, const char *at, size_t len);
+    static int _onMessageComplete(http_parser *p);
+
+    http_parser _parser;
+    http_parser_settings _settings;
+
+    char *_arena;
+    size_t _size;
+    size_t _used;
+    Piece _piece;
+    View _open;         // Piece currently being appended to
+    int _newlines;      // Consecutive line ends seen by feed()
+    bool _overflow;
+    bool _lineDone;
+    bool _headersDone;
+    bool _complete;
+    State _state;
+    BodySink _sink;
+    void *_sinkParam;
+
+    View _path;
+    View _query;
+    Header _headers[HTTP_MAX_HEADERS];
+    int _headerCount;
+    bool _skipHeader;   // Past HTTP_MAX_HEADERS
+
+    enum http_method _method;
+    int _major;
+    int _minor;
+    bool _keepAlive;
+    bool _chunked;
+    bool _hasLength;
+    uint64_t _contentLength;
+};
@@ -0,0 +1,172 @@
+/*
+    RouteTrie - Path segment index for WebServer request handlers
+
+    Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <string.h>
+#include <algorithm>
+#include "RouteTrie.h"
+
+RouteTrie::RouteTrie() {
+    _root = nullptr;
+}
+
+RouteTrie::~RouteTrie() {
+    clear();
+}
+
+void RouteTrie::clear() {
+    _free(_root);
+    _root = nullptr;
+}
+
+void RouteTrie::_free(Node *n) {
+    if (!n) {
+        return;
+    }
+    for (auto &c : n->literal) {
+        _free(c.second);
+    }
+    _free(n->param);
+    delete n;
+}
+
+static const char *_segmentEnd(const char *seg) {
+    while (*seg && (*seg != '/')) {
+        seg++;
+    }
+    return seg;
+}
+
+bool RouteTrie::add(const char *pattern, bool params, uint64_t methods, int id) {
+    // Check the whole pattern before changing anything
+    int paramCount = 0;
+    for (const char *seg = pattern; ;) {
+        const char *end = _segmentEnd(seg);
+        if (params && memchr(seg, '{', end - seg)) {
+            if ((end - seg != 2) || (seg[1] != '}') || (++paramCount > ROUTE_MAX_PARAMS)) {
+                return false;
+            }
+        }
+        if (!*end) {
+            break;
+        }
+        seg = end + 1;
+    }
+
+    if (!_root) {
+        _root = new Node;
+    }
+    Node *n = _root;
+    for (const char *seg = pattern; ;) {
+        const char *end = _segmentEnd(seg);
+        if (params && (end - seg == 2) && (seg[0] == '{')) {
+            if (!n->param) {
+                n->param = new Node;
+            }
+            n = n->param;
+        } else {
+            std::string s(seg, end - seg);
+            auto it = std::lower_bound(n->literal.begin(), n->literal.end(), s, [](const std::pair<std::string, Node *> &a, const std::string & b) {
+                return a.first < b;
+            });
+            if ((it == n->literal.end()) || (it->first != s)) {
+                it = n->literal.insert(it, std::make_pair(s, new Node));
+            }
+            n = it->second;
+        }
+        if (!*end) {
+            break;
+        }
+        seg = end + 1;
+    }
+    n->routes.push_back({ id, methods });
+    return true;
+}
+
+RouteTrie::Node *RouteTrie::_literalChild(const Node *n, const char *seg, size_t len) const {
+    size_t lo = 0;
+    size_t hi = n->literal.size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int c = n->literal[mid].first.compare(0, std::string::npos, seg, len);
+        if (!c) {
+            return n->literal[mid].second;
+        } else if (c < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return nullptr;
+}
+
+int RouteTrie::match(const char *path, size_t len, int method, Match *matches, int maxMatches) const {
+    if ((method < 0) || (method >= 64) || (len > 65535)) {
+        return -1;
+    }
+    if (!_root) {
+        return 0;
+    }
+    RouteCapture caps[ROUTE_MAX_PARAMS];
+    int count = 0;
+    if (!_match(_root, path, 0, len, 1ULL << method, caps, 0, matches, maxMatches, count)) {
+        return -1;
+    }
+    return count;
+}
+
+// Consumes the path segment starting at pos, trying the literal child and then the parameter
+bool RouteTrie::_match(const Node *n, const char *path, size_t pos, size_t len, uint64_t bit, RouteCapture *caps, int depth, Match *matches, int maxMatches, int &count) const {
+    const char *slash = (const char *)memchr(path + pos, '/', len - pos);
+    size_t end = slash ? slash - path : len;
+    const Node *next[2] = { _literalChild(n, path + pos, end - pos), n->param };
+    for (int i = 0; i < 2; i++) {
+        if (!next[i]) {
+            continue;
+        }
+        int d = depth;
+        if (i) {
+            caps[d++] = { (uint16_t)pos, (uint16_t)(end - pos) };
+        }
+        if (end < len) {
+            if (!_match(next[i], path, end + 1, len, bit, caps, d, matches, maxMatches, count)) {
+                return false;
+            }
+            continue;
+        }
+        for (auto &r : next[i]->routes) {
+            if (!(r.methods & bit)) {
+                continue;
+            }
+            if (count == maxMatches) {
+                return false;
+            }
+            // Keep registration order, the first handler that accepts the request wins
+            int j = count++;
+            while (j && (matches[j - 1].id > r.id)) {
+                matches[j] = matches[j - 1];
+                j--;
+            }
+            matches[j].id = r.id;
+            matches[j].count = d;
+            memcpy(matches[j].caps, caps, d * sizeof(caps[0]));
+        }
+    }
+    return true;
+}
@@ -0,0 +1,81 @@
+/*
+    RouteTrie - Path segment index for WebServer request handlers
+
+    Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+// No Arduino dependencies so tools/webroutebench.cpp can run it on a PC
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#ifndef ROUTE_MAX_PARAMS
+#define ROUTE_MAX_PARAMS 8  // Routes with more "{}" segments aren't indexed
+#endif
+
+#ifndef ROUTE_MAX_MATCHES
+#define ROUTE_MAX_MATCHES 8 // Routes matching one path before match() gives up
+#endif
+
+// A parameter's position in the matched path
+typedef struct {
+    uint16_t off;
+    uint16_t len;
+} RouteCapture;
+
+// Splits route patterns at '/' into a tree of literal segments, with "{}"
+// segments as parameters matching any one segment.  Built once, then each
+// lookup costs one binary search per path segment instead of a pattern
+// match per route.
+class RouteTrie {
+public:
+    typedef struct {
+        int id;
+        int count;
+        RouteCapture caps[ROUTE_MAX_PARAMS];
+    } Match;
+
+    RouteTrie();
+    ~RouteTrie();
+
+    void clear();
+    // methods is a bitmask of 1 << HTTPMethod.  Returns false if the pattern can't be indexed.
+    bool add(const char *pattern, bool params, uint64_t methods, int id);
+    // Fills matches in increasing id order.  Returns the count, or -1 if there were too many.
+    int match(const char *path, size_t len, int method, Match *matches, int maxMatches) const;
+
+private:
+    struct Node;
+    typedef struct {
+        int id;
+        uint64_t methods;
+    } Route;
+    struct Node {
+        std::vector<std::pair<std::string, Node *>> literal; // Sorted
+        Node *param = nullptr;
+        std::vector<Route> routes;
+    };
+
+    static void _free(Node *n);
+    Node *_literalChild(const Node *n, const char *seg, size_t len) const;
+    bool _match(const Node *n, const char *path, size_t pos, size_t len, uint64_t bit, RouteCapture *caps, int depth, Match *matches, int maxMatches, int &count) const;
+
+    Node *_root;
+};
@@ -62,4 +62,9 @@ public:
 
         return requestUriIndex >= requestUri.length();
     }
+
+    const char *routePattern(bool &params) const override final {
+        params = true;
+        return _uri.c_str();
+    }
 };
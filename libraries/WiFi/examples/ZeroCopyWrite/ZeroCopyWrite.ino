@@ -0,0 +1,74 @@
+// Compares write(), which copies every byte into lwIP, against writeRef(),
+// which lets lwIP send straight out of flash and reports when it's ACKed.  Run a sink on a PC first, i.e.
+// "nc -l -k 5000 > /dev/null", and set host to its address.
+// Released to the public domain by Earle F. Philhower, III, 2026
+
+#include <WiFi.h>
+
+#ifndef STASSID
+#define STASSID "your-ssid"
+#define STAPSK "your-password"
+#endif
+
+const char *ssid = STASSID;
+const char *password = STAPSK;
+
+const char *host = "192.168.1.100";
+const uint16_t port = 5000;
+
+// Stands in for a web UI bundle, lives in flash
+const uint8_t payload[128 * 1024] = { 'R', 'P', '2' };
+const int rounds = 8;
+
+volatile bool acked;
+volatile bool ackOK;
+
+void run(const char *name, bool zeroCopy) {
+  WiFiClient client;
+  if (!client.connect(host, port)) {
+    Serial.printf("%s: unable to connect\n", name);
+    return;
+  }
+  uint64_t busy = 0;
+  uint32_t start = millis();
+  for (int i = 0; i < rounds; i++) {
+    uint64_t c = rp2040.getCycleCount64();
+    if (zeroCopy) {
+      acked = false;
+      client.writeRef(payload, sizeof(payload), [](bool ok) {
+        ackOK = ok;
+        acked = true;
+      });
+      busy += rp2040.getCycleCount64() - c;
+      while (!acked) {
+        delay(1);
+      }
+      if (!ackOK) {
+        Serial.printf("%s: connection lost\n", name);
+        return;
+      }
+    } else {
+      client.write(payload, sizeof(payload));
+      busy += rp2040.getCycleCount64() - c;
+      client.flush();
+    }
+  }
+  uint32_t ms = millis() - start;
+  client.stop();
+  Serial.printf("%-12s %7lu ms  %7lu KB/s  %10llu cycles in the write call\n", name, ms, (unsigned long)(rounds * sizeof(payload) / ms), busy);
+}
+
+void setup() {
+  Serial.begin(115200);
+  WiFi.begin(ssid, password);
+  while (WiFi.status() != WL_CONNECTED) {
+    delay(500);
+  }
+  Serial.printf("Connected, sending %d x %d bytes\n", rounds, sizeof(payload));
+}
+
+void loop() {
+  run("write()", false);
+  run("writeRef()", true);
+  delay(5000);
+}
@@ -27,6 +27,8 @@
 #include <pgmspace.h>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+#include <new>
 #include <Arduino.h>
 #include "StackThunk.h"
 
@@ -879,10 +881,28 @@ bool X509List::append(const uint8_t *derCert, size_t derLen) {
 
 ServerSessions::~ServerSessions() {
     if (_isDynamic && _store != nullptr) {
-        delete _store;
+        free(_store);
     }
 }
 
+ServerSession *ServerSessions::_alloc(uint32_t size, bool psram) {
+    if (!size) {
+        return nullptr;
+    }
+    void *store = nullptr;
+#ifdef RP2350_PSRAM_CS
+    if (psram) {
+        store = pmalloc(size * sizeof(ServerSession));
+    }
+#else
+    (void) psram;
+#endif
+    if (!store) {
+        store = malloc(size * sizeof(ServerSession));
+    }
+    return (ServerSession *)store;
+}
+
 ServerSessions::ServerSessions(ServerSession *sessions, uint32_t size, bool isDynamic) :
     _size(sessions != nullptr ? size : 0),
     _store(sessions), _isDynamic(isDynamic) {
@@ -895,6 +915,220 @@ const br_ssl_session_cache_class **ServerSessions::getCache() {
     return _size > 0 ? &_cache.vtable : nullptr;
 }
 
+// The LRU's state and the used part of its store, followed by their SHA256
+typedef struct {
+    uint32_t magic;
+    uint32_t entrySize;
+    uint32_t storePtr;
+    uint32_t head, tail, root;
+    int32_t initDone;
+    uint8_t indexKey[32];
+} SessionCacheHeader;
+
+#define SESSION_CACHE_MAGIC 0x43535342 // "BSSC"
+
+static void sessionCacheHash(const SessionCacheHeader *h, const void *store, uint8_t *out) {
+    br_sha256_context ctx;
+    br_sha256_init(&ctx);
+    br_sha256_update(&ctx, h, sizeof(*h));
+    br_sha256_update(&ctx, store, h->storePtr);
+    br_sha256_out(&ctx, out);
+}
+
+bool ServerSessions::save(fs::FS &fs, const char *path) {
+    if (!_size) {
+        return false;
+    }
+    SessionCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = SESSION_CACHE_MAGIC;
+    h.entrySize = sizeof(ServerSession);
+    h.storePtr = _cache.store_ptr;
+    h.head = _cache.head;
+    h.tail = _cache.tail;
+    h.root = _cache.root;
+    h.initDone = _cache.init_done;
+    memcpy(h.indexKey, _cache.index_key, sizeof(h.indexKey));
+    uint8_t hash[32];
+    sessionCacheHash(&h, _store, hash);
+
+    File f = fs.open(path, "w");
+    if (!f) {
+        return false;
+    }
+    bool ok = (f.write((const uint8_t *)&h, sizeof(h)) == sizeof(h)) &&
+              (f.write((const uint8_t *)_store, h.storePtr) == h.storePtr) &&
+              (f.write(hash, sizeof(hash)) == sizeof(hash));
+    f.close();
+    if (!ok) {
+        fs.remove(path);
+    }
+    return ok;
+}
+
+bool ServerSessions::load(fs::FS &fs, const char *path) {
+    if (!_size) {
+        return false;
+    }
+    // Start from an empty cache, a partial load is useless
+    br_ssl_session_cache_lru_init(&_cache, (uint8_t*)_store, _size * sizeof(ServerSession));
+    File f = fs.open(path, "r");
+    if (!f) {
+        return false;
+    }
+    SessionCacheHeader h;
+    uint8_t hash[32], check[32];
+    if ((f.read((uint8_t *)&h, sizeof(h)) != sizeof(h)) || (h.magic != SESSION_CACHE_MAGIC) ||
+            (h.entrySize != sizeof(ServerSession)) || (h.storePtr > _size * sizeof(ServerSession)) ||
+            (f.read((uint8_t *)_store, h.storePtr) != h.storePtr) || (f.read(hash, sizeof(hash)) != sizeof(hash))) {
+        return false;
+    }
+    // The LRU follows the offsets stored in the entries, don't let a damaged file send it anywhere
+    sessionCacheHash(&h, _store, check);
+    if (memcmp(hash, check, sizeof(hash))) {
+        return false;
+    }
+    _cache.store_ptr = h.storePtr;
+    _cache.head = h.head;
+    _cache.tail = h.tail;
+    _cache.root = h.root;
+    memcpy(_cache.index_key, h.indexKey, sizeof(h.indexKey));
+    // The key was made by the engine's HMAC_DRBG, which always uses SHA-256
+    _cache.hash = h.initDone ? &br_sha256_vtable : nullptr;
+    _cache.init_done = h.initDone;
+    return true;
+}
+
+std::vector<TLSBufferPool::Buffer> TLSBufferPool::_idle;
+size_t TLSBufferPool::_maxIdle = 0;
+bool TLSBufferPool::_holdStack = false;
+auto_init_mutex(_tlsPoolMutex);
+
+// Pooled buffers only come in the record sizes MFLN can negotiate, so buffers left
+// by one connection fit the next one even when its sizes differ slightly
+size_t TLSBufferPool::_roundUp(size_t sz) {
+    static const size_t sizes[] = { 512, 1024, 2048, 4096, 16384 };
+    for (auto s : sizes) {
+        if (sz <= s + MAX_IN_OVERHEAD) {
+            return s + MAX_IN_OVERHEAD;
+        }
+    }
+    return sz;
+}
+
+unsigned char *TLSBufferPool::_new(size_t sz) {
+    // Allocate buffer with preference to SRAM, these are touched on every record
+    unsigned char *buf;
+    {
+        HeapSelectSRAM primary;
+        buf = new (std::nothrow) unsigned char[sz];
+    }
+    if (!buf) {
+        // Out of SRAM, follow the normal placement policy (i.e. PSRAM fallback)
+        buf = new (std::nothrow) unsigned char[sz];
+    }
+    return buf;
+}
+
+void TLSBufferPool::_free(unsigned char *buf, size_t sz) {
+    {
+        CoreMutex m(&_tlsPoolMutex);
+        if (_idle.size() < _maxIdle) {
+            _idle.push_back({ buf, sz });
+            return;
+        }
+    }
+    delete[] buf;
+}
+
+std::shared_ptr<unsigned char> TLSBufferPool::alloc(size_t sz) {
+    unsigned char *buf = nullptr;
+    {
+        CoreMutex m(&_tlsPoolMutex);
+        if (_maxIdle) {
+            sz = _roundUp(sz);
+            for (auto it = _idle.begin(); it != _idle.end(); it++) {
+                if (it->size == sz) {
+                    buf = it->buf;
+                    _idle.erase(it);
+                    break;
+                }
+            }
+        }
+    }
+    if (!buf) {
+        buf = _new(sz);
+        if (!buf) {
+            return nullptr;
+        }
+    }
+    return std::shared_ptr<unsigned char>(buf, [sz](unsigned char *p) {
+        _free(p, sz);
+    });
+}
+
+bool TLSBufferPool::reserve(int connections, int recv, int xmit) {
+    if (connections <= 0) {
+        return false;
+    }
+    // Same clamping as WiFiClientSecure::setBufferSizes()
+    size_t in = _roundUp(std::max(512, std::min(16384, recv)) + MAX_IN_OVERHEAD);
+    size_t out = _roundUp(std::max(512, std::min(16384, xmit)) + MAX_OUT_OVERHEAD);
+    if (!_holdStack) {
+        // The BearSSL stack is only freed when its last user goes away, so just be a user
+        stack_thunk_add_ref();
+        _holdStack = true;
+    }
+    CoreMutex m(&_tlsPoolMutex);
+    _maxIdle = std::max(_maxIdle, _idle.size() + 2 * connections);
+    _idle.reserve(_maxIdle);
+    for (int i = 0; i < connections; i++) {
+        unsigned char *a = _new(in);
+        unsigned char *b = a ? _new(out) : nullptr;
+        if (!b) {
+            delete[] a;
+            return false;
+        }
+        _idle.push_back({ a, in });
+        _idle.push_back({ b, out });
+    }
+    return true;
+}
+
+void TLSBufferPool::setMaxIdle(size_t count) {
+    std::vector<Buffer> drop;
+    {
+        CoreMutex m(&_tlsPoolMutex);
+        _maxIdle = count;
+        // Returning a buffer to the pool must not allocate
+        _idle.reserve(_maxIdle);
+        while (_idle.size() > _maxIdle) {
+            drop.push_back(_idle.back());
+            _idle.pop_back();
+        }
+    }
+    for (auto &b : drop) {
+        delete[] b.buf;
+    }
+}
+
+void TLSBufferPool::release() {
+    setMaxIdle(0);
+    {
+        CoreMutex m(&_tlsPoolMutex);
+        std::vector<Buffer>().swap(_idle);
+    }
+    if (_holdStack) {
+        _holdStack = false;
+        stack_thunk_del_ref();
+    }
+}
+
+size_t TLSBufferPool::idle() {
+    CoreMutex m(&_tlsPoolMutex);
+    return _idle.size();
+}
+
 // SHA256 hash for updater
 void HashSHA256::begin() {
     br_sha256_init(&_cc);
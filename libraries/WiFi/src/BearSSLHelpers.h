@@ -26,6 +26,9 @@
 #include <bearssl/bearssl.h>
 #include <Updater.h>
 #include <StackThunk.h>
+#include <FS.h>
+#include <memory>
+#include <vector>
 
 // Internal opaque structures, not needed by user applications
 namespace brssl {
@@ -168,9 +171,10 @@ public:
     ServerSessions(ServerSession *sessions, uint32_t size) : ServerSessions(sessions, size, false) {}
 
     // Dynamically allocates a cache for the given number of sessions and initializes it.
+    // With psram set, the cache is placed in PSRAM on boards that have it.
     // If the allocation of the buffer wasn't successful, the value
     // returned by size() will be 0.
-    ServerSessions(uint32_t size) : ServerSessions(size > 0 ? new ServerSession[size] : nullptr, size, true) {}
+    ServerSessions(uint32_t size, bool psram = false) : ServerSessions(_alloc(size, psram), size, true) {}
 
     ~ServerSessions();
 
@@ -179,12 +183,20 @@ public:
         return _size;
     }
 
-private:
-    ServerSessions(ServerSession *sessions, uint32_t size, bool isDynamic);
+    // Writes the cached sessions to a file so clients can still resume them after a reboot.
+    // The file holds the sessions' master secrets, so anyone who can read it can decrypt
+    // recorded traffic of those sessions.
+    bool save(fs::FS &fs, const char *path);
+    // Replaces the cached sessions with ones written by save().  On failure the cache is emptied.
+    bool load(fs::FS &fs, const char *path);
 
-    // Returns the cache's vtable or null if the cache has no capacity.
+    // Returns the cache's vtable for br_ssl_server_set_cache() or null if the cache has no capacity.
     const br_ssl_session_cache_class **getCache();
 
+private:
+    ServerSessions(ServerSession *sessions, uint32_t size, bool isDynamic);
+    static ServerSession *_alloc(uint32_t size, bool psram);
+
     // Size of the store in sessions.
     uint32_t _size;
     // Store where the information for the sessions are stored.
@@ -198,6 +210,47 @@ private:
 };
 
 
+// Keeps the record buffers of closed TLS connections (up to 16.7KB each) for the
+// next connection instead of returning them to the heap, where opening and closing
+// connections over and over leaves it fragmented.  Buffers are rounded up to the
+// MFLN record sizes (512, 1024, 2048, 4096 or 16384 bytes plus overhead) so any
+// connection can reuse them.  Nothing is kept until reserve() or setMaxIdle().
+class TLSBufferPool {
+public:
+    // BearSSL's per-record overhead, from bearssl/src/ssl/ssl_engine.c (not exported)
+    static const int MAX_IN_OVERHEAD = 325;
+    static const int MAX_OUT_OVERHEAD = 85;
+
+    // Preallocates the buffers for the given number of connections with the given
+    // setBufferSizes() sizes, keeps at least that many around from then on, and keeps
+    // the BearSSL stack allocated.  Call at the start of setup() to avoid fragmentation.
+    static bool reserve(int connections, int recv = 16384, int xmit = 512);
+    // Sets the number of idle buffers to keep, 0 frees each one when its connection closes
+    static void setMaxIdle(size_t count);
+    // Frees all idle buffers and stops keeping them or the BearSSL stack
+    static void release();
+    // Number of idle buffers waiting for a connection
+    static size_t idle();
+
+    // Returns a buffer of at least sz bytes, in SRAM if possible
+    static std::shared_ptr<unsigned char> alloc(size_t sz);
+
+private:
+    typedef struct {
+        unsigned char *buf;
+        size_t size;
+    } Buffer;
+
+    static size_t _roundUp(size_t sz);
+    static unsigned char *_new(size_t sz);
+    static void _free(unsigned char *buf, size_t sz);
+
+    static std::vector<Buffer> _idle;
+    static size_t _maxIdle;
+    static bool _holdStack;
+};
+
+
 // Updater SHA256 hash and signature verification
 class HashSHA256 : public UpdaterHashClass {
 public:
@@ -238,6 +238,76 @@ int WiFiClient::read(char* buf, size_t size) {
     return (int)_client->read(buf, size);
 }
 
+size_t WiFiClient::writeRef(const uint8_t *buf, size_t size, std::function<void(bool)> cb) {
+    if (!_client || !size) {
+        if (cb) {
+            cb(!size);
+        }
+        return 0;
+    }
+    _client->setTimeout(_timeout);
+    return _client->writeRef((const char*)buf, size, cb);
+}
+
+WiFiRxView WiFiClient::receiveView() {
+    WiFiRxView v;
+    if (_client) {
+        _client->takeReceived(v);
+    }
+    return v;
+}
+
+WiFiRxView::WiFiRxView(WiFiRxView &&other) : _ctx(other._ctx), _chain(other._chain), _offset(other._offset), _size(other._size) {
+    other._ctx = nullptr;
+    other._chain = nullptr;
+    other._size = 0;
+}
+
+WiFiRxView &WiFiRxView::operator=(WiFiRxView &&other) {
+    if (this != &other) {
+        release();
+        _ctx = other._ctx;
+        _chain = other._chain;
+        _offset = other._offset;
+        _size = other._size;
+        other._ctx = nullptr;
+        other._chain = nullptr;
+        other._size = 0;
+    }
+    return *this;
+}
+
+size_t WiFiRxView::segments() const {
+    size_t cnt = 0;
+    for (pbuf *p = (pbuf *)_chain; p; p = p->next) {
+        cnt++;
+    }
+    return cnt;
+}
+
+const uint8_t *WiFiRxView::segment(size_t idx, size_t *len) const {
+    size_t offset = _offset;
+    for (pbuf *p = (pbuf *)_chain; p; p = p->next) {
+        if (!idx--) {
+            *len = p->len - offset;
+            return (const uint8_t *)p->payload + offset;
+        }
+        offset = 0; // Only the first pbuf may be partially consumed
+    }
+    *len = 0;
+    return nullptr;
+}
+
+void WiFiRxView::release() {
+    if (_ctx) {
+        _ctx->releaseReceived((pbuf *)_chain, _size);
+    }
+    _ctx = nullptr;
+    _chain = nullptr;
+    _offset = 0;
+    _size = 0;
+}
+
 int WiFiClient::peek() {
     if (!available()) {
         return -1;
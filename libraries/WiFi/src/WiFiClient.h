@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include "Print.h"
 #include "Client.h"
@@ -42,6 +43,46 @@
 class ClientContext;
 class WiFiServer;
 
+// Zero-copy view of received TCP data, from WiFiClient::receiveView().  It holds
+// the lwIP receive buffers themselves, so the TCP window is only reopened once
+// the view is released or destroyed.
+class WiFiRxView {
+public:
+    WiFiRxView() : _ctx(nullptr), _chain(nullptr), _offset(0), _size(0) { }
+    WiFiRxView(WiFiRxView &&other);
+    WiFiRxView &operator=(WiFiRxView &&other);
+    WiFiRxView(const WiFiRxView &) = delete;
+    WiFiRxView &operator=(const WiFiRxView &) = delete;
+    ~WiFiRxView() {
+        release();
+    }
+
+    // Total bytes in the view
+    size_t size() const {
+        return _size;
+    }
+
+    operator bool() const {
+        return _size != 0;
+    }
+
+    // Number of contiguous segments making up the view
+    size_t segments() const;
+
+    // Address of segment idx, with its length in len
+    const uint8_t *segment(size_t idx, size_t *len) const;
+
+    // Return the buffers to lwIP and let the peer send more
+    void release();
+
+private:
+    friend class ClientContext;
+    ClientContext *_ctx;
+    void *_chain;       // struct pbuf *
+    size_t _offset;     // Bytes already consumed from the first pbuf
+    size_t _size;
+};
+
 class WiFiClient : public Client, public SList<WiFiClient> {
 protected:
     WiFiClient(ClientContext* client);
@@ -72,11 +113,24 @@ public:
     virtual size_t write(const uint8_t *buf, size_t size) override;
     size_t write(Stream& stream);
 
+    // Send without copying into lwIP.  buf must stay valid and unchanged until
+    // cb runs with true once the peer has ACKed all of it, or false if the
+    // connection was lost.  cb may be called from the network context.
+    virtual size_t writeRef(const uint8_t *buf, size_t size, std::function<void(bool)> cb);
+    // For data that never changes or goes away, like const arrays in flash
+    size_t writeStatic(const uint8_t *buf, size_t size) {
+        return writeRef(buf, size, nullptr);
+    }
+
     virtual int available() override;
     virtual int read() override;
     virtual int read(uint8_t* buf, size_t size) override;
     int read(char* buf, size_t size);
 
+    // Take everything received so far without copying it.  Plain TCP only,
+    // secure clients return an empty view.
+    virtual WiFiRxView receiveView();
+
     virtual int peek() override;
     virtual size_t peekBytes(uint8_t *buffer, size_t length);
     size_t peekBytes(char *buffer, size_t length) {
@@ -76,6 +76,7 @@ void WiFiClientSecureCtx::_clear() {
     _now = 0; // You can override or ensure time() is correct w/configTime
     _ta = nullptr;
     setBufferSizes(16384, 512); // Minimum safe
+    _auto_mfln = 0;
     _handshake_done = false;
     _recvapp_buf = nullptr;
     _recvapp_len = 0;
@@ -197,19 +198,25 @@ void WiFiClientSecureCtx::setClientECCert(const X509List *chain,
 }
 
 void WiFiClientSecureCtx::setBufferSizes(int recv, int xmit) {
-    // Following constants taken from bearssl/src/ssl/ssl_engine.c (not exported unfortunately)
-    const int MAX_OUT_OVERHEAD = 85;
-    const int MAX_IN_OVERHEAD = 325;
-
     // The data buffers must be between 512B and 16KB
-    recv = std::max(512, std::min(16384, recv));
-    xmit = std::max(512, std::min(16384, xmit));
+    _recv_size = std::max(512, std::min(16384, recv));
+    _xmit_size = std::max(512, std::min(16384, xmit));
+    _setIOBufSizes(_recv_size, _xmit_size);
+}
 
+void WiFiClientSecureCtx::_setIOBufSizes(int recv, int xmit) {
     // Add in overhead for SSL protocol
-    recv += MAX_IN_OVERHEAD;
-    xmit += MAX_OUT_OVERHEAD;
-    _iobuf_in_size = recv;
-    _iobuf_out_size = xmit;
+    _iobuf_in_size = recv + TLSBufferPool::MAX_IN_OVERHEAD;
+    _iobuf_out_size = xmit + TLSBufferPool::MAX_OUT_OVERHEAD;
+}
+
+// Smaller buffers make BearSSL ask for MFLN, which only works if the server agrees
+void WiFiClientSecureCtx::_sizeBuffersFor(IPAddress ip, uint16_t port) {
+    if (_auto_mfln && (_auto_mfln < _recv_size) && WiFiClientSecure::probeMaxFragmentLength(ip, port, _auto_mfln)) {
+        _setIOBufSizes(_auto_mfln, std::min(_xmit_size, (int)_auto_mfln));
+    } else {
+        _setIOBufSizes(_recv_size, _xmit_size);
+    }
 }
 
 bool WiFiClientSecureCtx::stop(unsigned int maxWaitMs) {
@@ -230,6 +237,7 @@ bool WiFiClientSecureCtx::flush(unsigned int maxWaitMs) {
 }
 
 int WiFiClientSecureCtx::connect(IPAddress ip, uint16_t port) {
+    _sizeBuffersFor(ip, port);
     if (!WiFiClient::connect(ip, port)) {
         return 0;
     }
@@ -242,6 +250,7 @@ int WiFiClientSecureCtx::connect(const char* name, uint16_t port) {
         DEBUG_BSSL("connect: Name lookup failure\n");
         return 0;
     }
+    _sizeBuffersFor(remote_addr, port);
     if (!WiFiClient::connect(remote_addr, port)) {
         DEBUG_BSSL("connect: Unable to connect TCP socket\n");
         return 0;
@@ -1110,14 +1119,8 @@ bool WiFiClientSecureCtx::_installClientX509Validator() {
 }
 
 std::shared_ptr<unsigned char> WiFiClientSecureCtx::_alloc_iobuf(size_t sz) {
-    // Allocate buffer with preference to IRAM
-    //  HeapSelectIram primary;
-    auto sptr = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[sz], std::default_delete<unsigned char[]>());
-    if (!sptr) {
-        //    HeapSelectDram alternate;
-        sptr = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[sz], std::default_delete<unsigned char[]>());
-    }
-    return sptr;
+    // Reuses a closed connection's buffer when TLSBufferPool is enabled
+    return TLSBufferPool::alloc(sz);
 }
 
 // Called by connect() to do the actual SSL setup and handshake.
@@ -1497,7 +1500,7 @@ static bool _SendAbort(WiFiClient& probe, bool supportsLen) {
 // TODO - Check the type of returned extensions and that the MFL is the exact
 //      same one we sent.  Not critical as only horribly broken servers would
 //      return changed or add their own extensions.
-bool WiFiClientSecure::probeMaxFragmentLength(IPAddress ip, uint16_t port, uint16_t len) {
+static bool _probeMaxFragmentLength(IPAddress ip, uint16_t port, uint16_t len, bool &answered) {
     // Hardcoded TLS 1.2 packets used throughout
     static const uint8_t clientHelloHead_P[] PROGMEM = {
         0x16, 0x03, 0x03, 0x00, 0, // TLS header, change last 2 bytes to len
@@ -1574,6 +1577,8 @@ bool WiFiClientSecure::probeMaxFragmentLength(IPAddress ip, uint16_t port, uint1
         DEBUG_BSSL("probeMaxFragmentLength: Protocol error\n");
         return false;
     }
+    // Whatever the server does now is its answer
+    answered = true;
 
     bool supportsLen = false;
     uint8_t fragResp[5];
@@ -1691,4 +1696,51 @@ bool WiFiClientSecure::probeMaxFragmentLength(IPAddress ip, uint16_t port, uint1
     return _SendAbort(probe, supportsLen);
 }
 
+// Probing costs a TCP connection and part of a handshake, so remember the answers
+typedef struct {
+    IPAddress ip;
+    uint16_t port;
+    uint16_t len;
+    bool supported;
+} MFLNProbe;
+static std::list<MFLNProbe> _mflnCache; // Most recent first
+auto_init_mutex(_mflnMutex); // Connects from other cores or tasks share the cache
+
+#ifndef MFLN_CACHE_SIZE
+#define MFLN_CACHE_SIZE 8
+#endif
+
+bool WiFiClientSecure::probeMaxFragmentLength(IPAddress ip, uint16_t port, uint16_t len) {
+    {
+        CoreMutex m(&_mflnMutex);
+        for (auto it = _mflnCache.begin(); it != _mflnCache.end(); it++) {
+            if ((it->ip == ip) && (it->port == port) && (it->len == len)) {
+                _mflnCache.splice(_mflnCache.begin(), _mflnCache, it);
+                return it->supported;
+            }
+        }
+    }
+    // Not holding the lock over the network round trip
+    bool answered = false;
+    bool supported = _probeMaxFragmentLength(ip, port, len, answered);
+    // Don't remember network failures, only what the server said
+    if (answered) {
+        CoreMutex m(&_mflnMutex);
+        // Someone else may have probed the same server meanwhile
+        _mflnCache.remove_if([&](const MFLNProbe & p) {
+            return (p.ip == ip) && (p.port == port) && (p.len == len);
+        });
+        if (_mflnCache.size() >= MFLN_CACHE_SIZE) {
+            _mflnCache.pop_back();
+        }
+        _mflnCache.push_front({ ip, port, len, supported });
+    }
+    return supported;
+}
+
+void WiFiClientSecure::clearMFLNCache() {
+    CoreMutex m(&_mflnMutex);
+    _mflnCache.clear();
+}
+
 };
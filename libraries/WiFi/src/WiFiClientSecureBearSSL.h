@@ -63,6 +63,18 @@ public:
     int read() override;
     int peek() override;
     size_t peekBytes(uint8_t *buffer, size_t length) override;
+    // The TCP stream is ciphertext, so there is nothing to hand out without a copy
+    WiFiRxView receiveView() override {
+        return WiFiRxView();
+    }
+    // Data is always encrypted into our own buffer, so buf is free as soon as write() returns
+    size_t writeRef(const uint8_t *buf, size_t size, std::function<void(bool)> cb) override {
+        size_t ret = write(buf, size);
+        if (cb) {
+            cb(ret == size);
+        }
+        return ret;
+    }
     bool flush(unsigned int maxWaitMs);
     bool stop(unsigned int maxWaitMs);
     void flush() override {
@@ -119,6 +131,11 @@ public:
 
     // Sets the requested buffer size for transmit and receive
     void setBufferSizes(int recv, int xmit);
+    // On connect, use len (512, 1024, 2048 or 4096) byte buffers if the server supports
+    // MFLN at that size, else the setBufferSizes() ones.  Probes are cached per server.  0 disables.
+    void setAutoMFLN(uint16_t len) {
+        _auto_mfln = len;
+    }
 
     // Returns whether MFLN negotiation for the above buffer sizes succeeded (after connection)
     int getMFLNStatus() {
@@ -278,6 +295,9 @@ private:
     CertStoreBase *_certStore;
     int _iobuf_in_size;
     int _iobuf_out_size;
+    int _recv_size; // As given to setBufferSizes()
+    int _xmit_size;
+    uint16_t _auto_mfln;
     bool _handshake_done;
     bool _oom_err;
 
@@ -305,6 +325,8 @@ private:
 
     bool _clientConnected(); // Is the underlying socket alive?
     std::shared_ptr<unsigned char> _alloc_iobuf(size_t sz);
+    void _setIOBufSizes(int recv, int xmit);
+    void _sizeBuffersFor(IPAddress ip, uint16_t port);
     void _freeSSL();
     int _run_until(unsigned target, bool blocking = true);
     size_t _write(const uint8_t *buf, size_t size, bool pmem);
@@ -424,6 +446,12 @@ public:
     size_t peekBytes(uint8_t *buffer, size_t length) override {
         return _ctx->peekBytes(buffer, length);
     }
+    WiFiRxView receiveView() override {
+        return _ctx->receiveView();
+    }
+    size_t writeRef(const uint8_t *buf, size_t size, std::function<void(bool)> cb) override {
+        return _ctx->writeRef(buf, size, cb);
+    }
     bool flush(unsigned int maxWaitMs) {
         return _ctx->flush(maxWaitMs);
     }
@@ -484,6 +512,9 @@ public:
     void setBufferSizes(int recv, int xmit) {
         _ctx->setBufferSizes(recv, xmit);
     }
+    void setAutoMFLN(uint16_t len) {
+        _ctx->setAutoMFLN(len);
+    }
 
     // Returns whether MFLN negotiation for the above buffer sizes succeeded (after connection)
     int getMFLNStatus() {
@@ -522,6 +553,8 @@ public:
     static bool probeMaxFragmentLength(IPAddress ip, uint16_t port, uint16_t len);
     static bool probeMaxFragmentLength(const char *hostname, uint16_t port, uint16_t len);
     static bool probeMaxFragmentLength(const String& host, uint16_t port, uint16_t len);
+    // Forgets the probe results remembered for setAutoMFLN()
+    static void clearMFLNCache();
 #if 0
     // peek buffer API is present
     virtual bool hasPeekBufferAPI() const override {
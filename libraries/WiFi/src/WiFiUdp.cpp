@@ -186,6 +186,13 @@ int WiFiUDP::endPacket() {
     return (_ctx->send()) ? 1 : 0;
 }
 
+int WiFiUDP::sendPacket(IPAddress ip, uint16_t port, const uint8_t *buffer, size_t size) {
+    if (!beginPacket(ip, port)) {
+        return 0;
+    }
+    return (_ctx->sendRef(buffer, size)) ? 1 : 0;
+}
+
 size_t WiFiUDP::write(uint8_t byte) {
     return write(&byte, 1);
 }
@@ -210,6 +217,30 @@ int WiFiUDP::parsePacket() {
     return _ctx->getSize();
 }
 
+size_t WiFiUDP::readPackets(WiFiUDPPacket *packets, size_t count) {
+    if (!_ctx) {
+        return 0;
+    }
+
+    size_t n;
+    for (n = 0; (n < count) && _ctx->next(); n++) {
+        packets[n].packetSize = _ctx->getSize();
+        packets[n].length = _ctx->read(reinterpret_cast<char*>(packets[n].buffer), packets[n].size);
+        packets[n].remoteIP = _ctx->getRemoteAddress();
+        packets[n].remotePort = _ctx->getRemotePort();
+        packets[n].destinationIP = _ctx->getDestAddress();
+    }
+    return n;
+}
+
+uint32_t WiFiUDP::droppedPackets() const {
+    if (!_ctx) {
+        return 0;
+    }
+
+    return _ctx->getDropped();
+}
+
 int WiFiUDP::read() {
     if (!_ctx) {
         return -1;
@@ -29,6 +29,17 @@
 
 class UdpContext;
 
+// One datagram for WiFiUDP::readPackets(), like a struct mmsghdr for recvmmsg()
+typedef struct {
+    uint8_t *buffer;          // Set by the caller, where to copy the payload
+    size_t size;              // Set by the caller, size of buffer
+    size_t length;            // Bytes copied into buffer
+    size_t packetSize;        // Size of the datagram, larger than length if it was truncated
+    IPAddress remoteIP;
+    uint16_t remotePort;
+    IPAddress destinationIP;
+} WiFiUDPPacket;
+
 class WiFiUDP : public UDP, public SList<WiFiUDP> {
 private:
     UdpContext* _ctx;
@@ -82,9 +93,21 @@ public:
 
     using Print::write;
 
+    // Send size bytes from buffer as one packet without copying them into a packet
+    // buffer first.  buffer may be reused as soon as this returns.
+    // Returns 1 if the packet was sent successfully, 0 if there was an error
+    int sendPacket(IPAddress ip, uint16_t port, const uint8_t *buffer, size_t size);
+
     // Start processing the next available incoming packet
     // Returns the size of the packet in bytes, or 0 if no packets are available
+    // Up to UDP_RX_RING (16) packets wait here, later arrivals are dropped until
+    // parsePacket() frees a slot, see droppedPackets()
     int parsePacket() override;
+    // Copy up to count waiting packets into the given packets' buffers in one call, like
+    // calling parsePacket() and read() for each.  Returns the number of packets filled
+    size_t readPackets(WiFiUDPPacket *packets, size_t count);
+    // Number of packets dropped because they arrived while the receive ring was full
+    uint32_t droppedPackets() const;
     // Number of bytes remaining in the current packet
     int available() override;
     // Read a single byte from the current packet
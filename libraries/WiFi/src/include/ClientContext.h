@@ -27,7 +27,10 @@ class WiFiClient;
 typedef void (*discard_cb_t)(void*, ClientContext*);
 
 #include <assert.h>
+#include <functional>
+#include <list>
 #include "lwip/timeouts.h"
+#include <lwip_wrap.h>
 
 //#include <esp_priv.h>
 //#include <coredecls.h>
@@ -49,11 +52,7 @@ public:
         _pcb(pcb), _rx_buf(0), _rx_buf_offset(0), _discard_cb(discard_cb), _discard_cb_arg(discard_cb_arg), _refcnt(0), _next(0),
         _sync(::getDefaultPrivateGlobalSyncValue()) {
         tcp_setprio(_pcb, TCP_PRIO_MIN);
-        tcp_arg(_pcb, this);
-        tcp_recv(_pcb, &_s_recv);
-        tcp_sent(_pcb, &_s_acked);
-        tcp_err(_pcb, &_s_error);
-        tcp_poll(_pcb, &_s_poll, 1);
+        lwip_tcp_callbacks(_pcb, this, &_s_recv, &_s_acked, &_s_error, &_s_poll, 1);
 
         // keep-alive not enabled by default
         //keepAlive();
@@ -66,26 +65,25 @@ public:
     err_t abort() {
         if (_pcb) {
             DEBUGV(":abort\r\n");
-            tcp_arg(_pcb, nullptr);
-            tcp_sent(_pcb, nullptr);
-            tcp_recv(_pcb, nullptr);
-            tcp_err(_pcb, nullptr);
-            tcp_poll(_pcb, nullptr, 0);
+            lwip_tcp_callbacks(_pcb, nullptr, nullptr, nullptr, nullptr, nullptr, 0);
             tcp_abort(_pcb);
             _pcb = nullptr;
         }
+        _release_refs(true);
         return ERR_ABRT;
     }
 
     err_t close() {
         err_t err = ERR_OK;
+        if (_pcb && !_refs.empty()) {
+            // A closing PCB still retransmits, so lwIP would keep reading
+            // writeRef() buffers after we've told the app they're free
+            DEBUGV(":close w/refs\r\n");
+            return abort();
+        }
         if (_pcb) {
             DEBUGV(":close\r\n");
-            tcp_arg(_pcb, nullptr);
-            tcp_sent(_pcb, nullptr);
-            tcp_recv(_pcb, nullptr);
-            tcp_err(_pcb, nullptr);
-            tcp_poll(_pcb, nullptr, 0);
+            lwip_tcp_callbacks(_pcb, nullptr, nullptr, nullptr, nullptr, nullptr, 0);
             err = tcp_close(_pcb);
             if (err != ERR_OK) {
                 DEBUGV(":tc err %d\r\n", (int) err);
@@ -285,11 +283,20 @@ public:
         size = (size < max_size) ? size : max_size;
 
         DEBUGV(":pd %d, %d, %d\r\n", size, _rx_buf->tot_len, _rx_buf_offset);
-        size_t buf_size = _rx_buf->len - _rx_buf_offset;
-        size_t copy_size = (size < buf_size) ? size : buf_size;
-        DEBUGV(":rpi %d, %d\r\n", buf_size, copy_size);
-        memcpy(dst, reinterpret_cast<char*>(_rx_buf->payload) + _rx_buf_offset, copy_size);
-        return copy_size;
+        size_t offset = _rx_buf_offset;
+        size_t size_read = 0;
+        // Walk the whole chain, the head pbuf may hold only part of what's available
+        for (const pbuf *p = _rx_buf; p && size; p = p->next) {
+            size_t buf_size = p->len - offset;
+            size_t copy_size = (size < buf_size) ? size : buf_size;
+            DEBUGV(":rpi %d, %d\r\n", buf_size, copy_size);
+            memcpy(dst, reinterpret_cast<char*>(p->payload) + offset, copy_size);
+            dst += copy_size;
+            size -= copy_size;
+            size_read += copy_size;
+            offset = 0;
+        }
+        return size_read;
     }
 
     void discard_received() {
@@ -371,6 +378,32 @@ public:
         return _write_from_source(ds, dl);
     }
 
+    // Queue data without lwIP copying it.  cb (optional) runs, possibly from the
+    // LWIP context, once every byte sent was ACKed (true) or the connection died
+    // (false), after which lwIP no longer references ds.
+    size_t writeRef(const char* ds, const size_t dl, std::function<void(bool)> cb) {
+        if (!_pcb) {
+            if (cb) {
+                cb(false);
+            }
+            return 0;
+        }
+        _nocopy = true;
+        size_t ret = _write_from_source(ds, dl);
+        _nocopy = false;
+        if (cb) {
+            if (!ret) {
+                cb(false);
+            } else {
+                // Must be serialized with _acked, which runs in the LWIP context
+                RefWrite r = { this, _tx_queued, cb };
+                LWIPMutex m;
+                lwip_callback(_s_add_ref, &r);
+            }
+        }
+        return ret;
+    }
+
     size_t write(Stream& stream) {
         if (!_pcb) {
             return 0;
@@ -455,6 +488,38 @@ public:
         _consume(consume);
     }
 
+    // Give the whole receive chain to a zero-copy view.  The view now owns the
+    // pbuf reference and the window update, and keeps this context alive.
+    void takeReceived(WiFiRxView &view) {
+        view.release();
+        pbuf *chain;
+        size_t offset;
+        {
+            LWIPMutex m; // _recv may be appending to the chain
+            chain = _rx_buf;
+            offset = _rx_buf_offset;
+            _rx_buf = nullptr;
+            _rx_buf_offset = 0;
+        }
+        if (!chain) {
+            return;
+        }
+        ref();
+        view._ctx = this;
+        view._chain = chain;
+        view._offset = offset;
+        view._size = chain->tot_len - offset;
+    }
+
+    // Called by WiFiRxView::release once the app is done with the data
+    void releaseReceived(pbuf *chain, size_t size) {
+        if (_pcb) {
+            tcp_recved(_pcb, size);
+        }
+        pbuf_free(chain);
+        unref();
+    }
+
 protected:
 
     bool _is_timeout() {
@@ -548,7 +613,7 @@ protected:
             {
                 flags |= TCP_WRITE_FLAG_MORE;    // do not tcp-PuSH (yet)
             }
-            if (!_sync)
+            if (!_sync && !_nocopy)
                 // user data must be copied when data are sent but not yet acknowledged
                 // (with sync, we wait for acknowledgment before returning to user)
             {
@@ -564,6 +629,7 @@ protected:
 
             if (err == ERR_OK) {
                 _written += next_chunk_size;
+                _tx_queued += next_chunk_size;
                 has_written = true;
             } else if (err == ERR_MEM) {
                 if (scale < 4) {
@@ -601,6 +667,8 @@ protected:
         (void) pcb;
         (void) len;
         DEBUGV(":ack %d\r\n", len);
+        _tx_acked += len;
+        _release_refs(false);
         _write_some_from_cb();
         return ERR_OK;
     }
@@ -666,6 +734,8 @@ protected:
         tcp_recv(_pcb, nullptr);
         tcp_err(_pcb, nullptr);
         _pcb = nullptr;
+        // lwIP has already freed the PCB and any segments pointing at our buffers
+        _release_refs(true);
         _notify_error();
     }
 
@@ -718,6 +788,27 @@ protected:
         }
     }
 
+    struct RefWrite {
+        ClientContext *ctx;
+        uint32_t end;       // _tx_queued once the last byte of this write was queued
+        std::function<void(bool)> cb;
+    };
+
+    static void _s_add_ref(void *arg) {
+        RefWrite *r = reinterpret_cast<RefWrite*>(arg);
+        r->ctx->_refs.push_back(*r);
+        r->ctx->_release_refs(!r->ctx->_pcb); // May have been ACKed already
+    }
+
+    // Tell the app about writeRef() buffers lwIP is done with, in order
+    void _release_refs(bool all) {
+        while (!_refs.empty() && (all || ((int32_t)(_tx_acked - _refs.front().end) >= 0))) {
+            auto cb = _refs.front().cb;
+            _refs.pop_front();
+            cb(!all);
+        }
+    }
+
     static err_t _s_connected(void* arg, struct tcp_pcb *pcb, err_t err) {
         if (arg) {
             return reinterpret_cast<ClientContext*>(arg)->_connected(pcb, err);
@@ -747,4 +838,9 @@ private:
     ClientContext* _next;
 
     bool _sync;
+
+    bool _nocopy = false;           // Current write must not set TCP_WRITE_FLAG_COPY
+    uint32_t _tx_queued = 0;        // Total bytes accepted by tcp_write
+    uint32_t _tx_acked = 0;         // Total bytes ACKed by the peer
+    std::list<RefWrite> _refs;      // Pending writeRef() callbacks, oldest first
 };
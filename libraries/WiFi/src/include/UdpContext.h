@@ -30,12 +30,22 @@ extern "C" {
 #include <AddrList.h>
 #include <Arduino.h>
 #include "lwip/timeouts.h"
+#include <algorithm>
 
 //#include <PolledTimeout.h>
 
-#define PBUF_ALIGNER_ADJUST 4
-#define PBUF_ALIGNER(x) ((void*)((((intptr_t)(x))+3)&~3))
-#define PBUF_HELPER_FLAG 0xff // lwIP pbuf flag: u8_t
+// Received datagrams held per context until next() takes them, must be a power of 2.
+// Sized to ride out bursts like mDNS answers between loop() passes, newer packets
+// are dropped (and counted) once it fills.
+#ifndef UDP_RX_RING
+#define UDP_RX_RING 16
+#endif
+static_assert((UDP_RX_RING & (UDP_RX_RING - 1)) == 0, "UDP_RX_RING must be a power of 2");
+
+// Transmit pbufs kept per context and reused for each packet built with append()
+#ifndef UDP_TX_POOL
+#define UDP_TX_POOL 2
+#endif
 
 class UdpContext {
 public:
@@ -45,13 +55,23 @@ public:
     UdpContext()
         : _pcb(0)
         , _rx_buf(0)
-        , _first_buf_taken(false)
         , _rx_buf_offset(0)
         , _rx_buf_size(0)
+        , _rx_head(0)
+        , _rx_tail(0)
+        , _rx_dropped(0)
         , _refcnt(0)
-        , _tx_buf_head(0)
-        , _tx_buf_cur(0)
+        , _tx_slot(-1)
+        , _tx_next(0)
         , _tx_buf_offset(0) {
+        for (auto &s : _rx_ring) {
+            s.pb = nullptr;
+        }
+        for (auto &t : _tx_pool) {
+            t.pb = nullptr;
+            t.data = nullptr;
+            t.cap = 0;
+        }
         _pcb = udp_new();
 #if LWIP_IPV6
         // local_ip defaults to 0.0.0.0
@@ -66,11 +86,12 @@ public:
     ~UdpContext() {
         udp_remove(_pcb);
         _pcb = 0;
-        if (_tx_buf_head) {
-            pbuf_free(_tx_buf_head);
-            _tx_buf_head = 0;
-            _tx_buf_cur = 0;
-            _tx_buf_offset = 0;
+        cancelBuffer();
+        for (auto &t : _tx_pool) {
+            if (t.pb) {
+                pbuf_free(t.pb);
+                t.pb = nullptr;
+            }
         }
         if (_rx_buf) {
             pbuf_free(_rx_buf);
@@ -78,6 +99,9 @@ public:
             _rx_buf_offset = 0;
             _rx_buf_size = 0;
         }
+        for (; _rx_tail != _rx_head; _rx_tail++) {
+            pbuf_free(_rx_ring[_rx_tail & (UDP_RX_RING - 1)].pb);
+        }
     }
 
     void ref() {
@@ -178,8 +202,8 @@ public:
         char buf[128];
         int l = snprintf(buf, sizeof(buf), "UDP: %s %u: ", msg, n);
         while (pb) {
-            l += snprintf(&buf[l], sizeof(buf) - l, "%p(H=%d,%d<=%d)-",
-                          pb, pb->flags == PBUF_HELPER_FLAG, pb->len, pb->tot_len);
+            l += snprintf(&buf[l], sizeof(buf) - l, "%p(%d<=%d)-",
+                          pb, pb->len, pb->tot_len);
             pb = pb->next;
         }
         l += snprintf(&buf[l], sizeof(buf) - l, "(end)");
@@ -236,58 +260,33 @@ public:
         return _pcb->local_port;
     }
 
+    // Drops the current packet and makes the oldest queued one current
     bool next() {
-        if (!_rx_buf) {
-            return false;
-        }
-        if (!_first_buf_taken) {
-            _first_buf_taken = true;
-            return true;
-        }
-
-        // We have interleaved information on addresses within received pbuf chain:
-        // (before ipv6 code we had: (data-pbuf) -> (data-pbuf) -> (data-pbuf) -> ... in the receiving order)
-        // Now:         (address-info-pbuf -> chained-data-pbuf [-> chained-data-pbuf...]) ->
-        //      (chained-address-info-pbuf -> chained-data-pbuf [-> chained...]) -> ...
-        // _rx_buf is currently addressing a data pbuf,
-        // in this function it is going to be discarded.
-
-        auto deleteme = _rx_buf;
-
-        // forward in the chain until next address-info pbuf or end of chain
-        while (_rx_buf && _rx_buf->flags != PBUF_HELPER_FLAG) {
-            _rx_buf = _rx_buf->next;
-        }
-
         if (_rx_buf) {
-            assert(_rx_buf->flags == PBUF_HELPER_FLAG);
-
-            // copy address helper to "current address"
-            auto helper = (AddrHelper*)PBUF_ALIGNER(_rx_buf->payload);
-            _currentAddr = *helper;
-
-            // destroy the helper in the about-to-be-released pbuf
-            helper->~AddrHelper();
-
-            // forward in rx_buf list, next one is effective data
-            // current (not ref'ed) one will be pbuf_free'd
-            // with the 'deleteme' pointer above
-            _rx_buf = _rx_buf->next;
+            pbuf_free(_rx_buf);
+            _rx_buf = nullptr;
+        }
+        _rx_buf_offset = 0;
+        _rx_buf_size = 0;
 
-            // this rx_buf is not nullptr by construction,
-            assert(_rx_buf);
-            // ref'ing it to prevent release from the below pbuf_free(deleteme)
-            // (ref counter prevents release and will be decreased by pbuf_free)
-            pbuf_ref(_rx_buf);
+        // _recv() only ever moves _rx_head and this only _rx_tail, so no lock is needed
+        uint32_t tail = _rx_tail;
+        if (__atomic_load_n(&_rx_head, __ATOMIC_ACQUIRE) == tail) {
+            return false;
         }
+        RxSlot &slot = _rx_ring[tail & (UDP_RX_RING - 1)];
+        _rx_buf = slot.pb;
+        _currentAddr = slot.addr;
+        slot.pb = nullptr;
+        __atomic_store_n(&_rx_tail, tail + 1, __ATOMIC_RELEASE);
 
-        // release in chain previous data, and if any:
-        // current helper, but not start of current data
-        pbuf_free(deleteme);
+        _rx_buf_size = _rx_buf->tot_len;
+        return true;
+    }
 
-        _rx_buf_offset = 0;
-        _rx_buf_size = _processSize(_rx_buf);
-        return _rx_buf != nullptr;
+    // Number of received packets dropped because the receive ring was full
+    uint32_t getDropped() const {
+        return _rx_dropped;
     }
 
     int read() {
@@ -341,38 +340,18 @@ public:
     }
 
     size_t append(const char* data, size_t size) {
-        if (!_tx_buf_head || _tx_buf_head->tot_len < _tx_buf_offset + size) {
-            _reserve(_tx_buf_offset + size);
-        }
-        if (!_tx_buf_head || _tx_buf_head->tot_len < _tx_buf_offset + size) {
+        if (!_reserve(_tx_buf_offset + size)) {
             DEBUGV("failed _reserve");
             return 0;
         }
-
-        size_t left_to_copy = size;
-        while (left_to_copy) {
-            // size already used in current pbuf
-            size_t used_cur = _tx_buf_offset - (_tx_buf_head->tot_len - _tx_buf_cur->tot_len);
-            size_t free_cur = _tx_buf_cur->len - used_cur;
-            if (free_cur == 0) {
-                _tx_buf_cur = _tx_buf_cur->next;
-                continue;
-            }
-            size_t will_copy = (left_to_copy < free_cur) ? left_to_copy : free_cur;
-            memcpy(reinterpret_cast<char*>(_tx_buf_cur->payload) + used_cur, data, will_copy);
-            _tx_buf_offset += will_copy;
-            left_to_copy -= will_copy;
-            data += will_copy;
-        }
+        memcpy(reinterpret_cast<char*>(_tx_pool[_tx_slot].data) + _tx_buf_offset, data, size);
+        _tx_buf_offset += size;
         return size;
     }
 
     void cancelBuffer() {
-        if (_tx_buf_head) {
-            pbuf_free(_tx_buf_head);
-        }
-        _tx_buf_head = 0;
-        _tx_buf_cur = 0;
+        // The pbuf itself stays in the pool for the next packet
+        _tx_slot = -1;
         _tx_buf_offset = 0;
     }
 
@@ -393,86 +372,109 @@ public:
         return err == ERR_OK;
     }
 
+    // Sends size bytes straight from data, without touching any packet being built with
+    // append().  lwIP and the network drivers copy anything they keep after udp_sendto()
+    // returns, so data may be reused as soon as this returns.
+    bool sendRef(const void* data, size_t size, const ip_addr_t* addr = 0, uint16_t port = 0) {
+        if (size > 0xffff - UDP_HLEN) {
+            return false;
+        }
+        pbuf* pb = pbuf_alloc(PBUF_TRANSPORT, size, PBUF_REF);
+        if (!pb) {
+            DEBUGV("failed pbuf_alloc");
+            return false;
+        }
+        pb->payload = const_cast<void*>(data);
+        if (!addr) {
+            addr = &_pcb->remote_ip;
+            port = _pcb->remote_port;
+        }
+        err_t err = udp_sendto(_pcb, pb, addr, port);
+        if (err != ERR_OK) {
+            DEBUGV(":usr rc=%d\r\n", (int) err);
+        }
+        pbuf_free(pb);
+        return err == ERR_OK;
+    }
+
 private:
 
     err_t trySend(const ip_addr_t* addr, uint16_t port, bool keepBufferOnError) {
-        size_t data_size = _tx_buf_offset;
-        pbuf* tx_copy = pbuf_alloc(PBUF_TRANSPORT, data_size, PBUF_RAM);
-        if (tx_copy) {
-            uint8_t* dst = reinterpret_cast<uint8_t*>(tx_copy->payload);
-            for (pbuf* p = _tx_buf_head; p; p = p->next) {
-                size_t will_copy = (data_size < p->len) ? data_size : p->len;
-                memcpy(dst, p->payload, will_copy);
-                dst += will_copy;
-                data_size -= will_copy;
-            }
-        }
-
-        if (!keepBufferOnError) {
+        if (!_reserve(_tx_buf_offset)) {
+            DEBUGV("failed pbuf_alloc");
             cancelBuffer();
+            return ERR_MEM;
         }
+        TxSlot &t = _tx_pool[_tx_slot];
 
-        if (!tx_copy) {
-            DEBUGV("failed pbuf_alloc");
-            return ERR_MEM;
+        // A previous udp_sendto() leaves the headers it added in front of the payload
+        size_t headers = reinterpret_cast<uint8_t*>(t.data) - reinterpret_cast<uint8_t*>(t.pb->payload);
+        if (headers) {
+            pbuf_remove_header(t.pb, headers);
         }
+        t.pb->len = t.pb->tot_len = _tx_buf_offset;
 
         if (!addr) {
             addr = &_pcb->remote_ip;
             port = _pcb->remote_port;
         }
 
-        err_t err = udp_sendto(_pcb, tx_copy, addr, port);
+        err_t err = udp_sendto(_pcb, t.pb, addr, port);
         if (err != ERR_OK) {
             DEBUGV(":ust rc=%d\r\n", (int) err);
         }
 
-        pbuf_free(tx_copy);
-
-        if (err == ERR_OK) {
-            cancelBuffer();    // no error: get rid of buffer
+        if ((err == ERR_OK) || !keepBufferOnError) {
+            cancelBuffer();
         }
 
         return err;
     }
 
-    size_t _processSize(const pbuf* pb) {
-        size_t ret = 0;
-        for (; pb && pb->flags != PBUF_HELPER_FLAG; pb = pb->next) {
-            ret += pb->len;
+    // Makes sure the packet being built has room for size bytes.  Starting a packet takes
+    // a pool pbuf that nothing else, like an ARP queue or a driver's transmit ring, still
+    // holds, so sending the same sized packets over and over allocates nothing.
+    bool _reserve(size_t size) {
+        const size_t pbuf_unit_size = 256;
+        if (size > 0xffff - UDP_HLEN) {
+            return false;
         }
-        return ret;
-    }
-
-    void _reserve(size_t size) {
-        const size_t pbuf_unit_size = 128;
-        if (!_tx_buf_head) {
-            _tx_buf_head = pbuf_alloc(PBUF_TRANSPORT, pbuf_unit_size, PBUF_RAM);
-            if (!_tx_buf_head) {
-                return;
+        if (_tx_slot < 0) {
+            int i;
+            for (i = 0; i < UDP_TX_POOL; i++) {
+                if (!_tx_pool[i].pb || (_tx_pool[i].pb->ref == 1)) {
+                    break;
+                }
+            }
+            if (i == UDP_TX_POOL) {
+                // All in flight, hand the oldest over to whoever still holds it
+                i = _tx_next;
+                pbuf_free(_tx_pool[i].pb);
+                _tx_pool[i].pb = nullptr;
             }
-            _tx_buf_cur = _tx_buf_head;
+            _tx_slot = i;
+            _tx_next = (i + 1) % UDP_TX_POOL;
             _tx_buf_offset = 0;
         }
 
-        size_t cur_size = _tx_buf_head->tot_len;
-        if (size < cur_size) {
-            return;
+        TxSlot &t = _tx_pool[_tx_slot];
+        if (t.pb && (t.cap >= size)) {
+            return true;
         }
-
-        size_t grow_size = size - cur_size;
-
-        while (grow_size) {
-            pbuf* pb = pbuf_alloc(PBUF_TRANSPORT, pbuf_unit_size, PBUF_RAM);
-            if (!pb) {
-                return;
-            }
-            pbuf_cat(_tx_buf_head, pb);
-            if (grow_size < pbuf_unit_size) {
-                return;
-            }
-            grow_size -= pbuf_unit_size;
+        size_t cap = std::max(pbuf_unit_size, (size + pbuf_unit_size - 1) & ~(pbuf_unit_size - 1));
+        cap = std::min(cap, (size_t)(0xffff - UDP_HLEN));
+        pbuf* pb = pbuf_alloc(PBUF_TRANSPORT, cap, PBUF_RAM);
+        if (!pb) {
+            return false;
+        }
+        if (t.pb) {
+            memcpy(pb->payload, t.data, _tx_buf_offset);
+            pbuf_free(t.pb);
         }
+        t.pb = pb;
+        t.data = pb->payload;
+        t.cap = cap;
+        return true;
     }
 
     void _consume(size_t size) {
@@ -485,63 +487,22 @@ private:
     void _recv(udp_pcb *upcb, pbuf *pb,
                const ip_addr_t *srcaddr, u16_t srcport) {
         (void) upcb;
-        // check receive pbuf chain depth
-        // optimization path: cache the pbuf chain length
-        {
-            pbuf* p;
-            int count = 0;
-            for (p = _rx_buf; p && ++count < rxBufMaxDepth * 2; p = p->next);
-            if (p) {
-                // pbuf chain too deep, dropping
-                pbuf_free(pb);
-                DEBUGV(":udr\r\n");
-                return;
-            }
+        uint32_t head = _rx_head;
+        if (head - __atomic_load_n(&_rx_tail, __ATOMIC_ACQUIRE) == UDP_RX_RING) {
+            // Ring full, drop the new packet and keep the ones already waiting
+            pbuf_free(pb);
+            _rx_dropped++;
+            DEBUGV(":udr\r\n");
+            return;
         }
 
-        // chain this helper pbuf first
-        if (_rx_buf) {
-            // there is some unread data
-            // chain pbuf
-
-            // Addresses/ports are stored from this callback because lwIP's
-            // macro are valid only now.
-            //
-            // When peeking data from before payload start (like it was done
-            // before IPv6), there's no easy way to safely guess whether
-            // packet is from v4 or v6.
-            //
-            // Now storing data in an intermediate chained pbuf containing
-            // AddrHelper
-
-            // allocate new pbuf to store addresses/ports
-            pbuf* pb_helper = pbuf_alloc(PBUF_RAW, sizeof(AddrHelper) + PBUF_ALIGNER_ADJUST, PBUF_RAM);
-            if (!pb_helper) {
-                // memory issue - discard received data
-                pbuf_free(pb);
-                return;
-            }
-            // construct in place
-            new (PBUF_ALIGNER(pb_helper->payload)) AddrHelper(srcaddr, ip_current_dest_addr(), srcport, ip_current_input_netif());
-            pb_helper->flags = PBUF_HELPER_FLAG; // mark helper pbuf
-            // chain it
-            pbuf_cat(_rx_buf, pb_helper);
-
-            // now chain the new data pbuf
-            DEBUGV(":urch %d, %d\r\n", _rx_buf->tot_len, pb->tot_len);
-            pbuf_cat(_rx_buf, pb);
-        } else {
-            _currentAddr.srcaddr = srcaddr;
-            _currentAddr.dstaddr = ip_current_dest_addr();
-            _currentAddr.srcport = srcport;
-            _currentAddr.input_netif = ip_current_input_netif();
-
-            DEBUGV(":urn %d\r\n", pb->tot_len);
-            _first_buf_taken = false;
-            _rx_buf = pb;
-            _rx_buf_offset = 0;
-            _rx_buf_size = pb->tot_len;
-        }
+        // Addresses/ports are stored from this callback because lwIP's
+        // ip_current_*() are valid only now.
+        RxSlot &slot = _rx_ring[head & (UDP_RX_RING - 1)];
+        slot.pb = pb;
+        slot.addr = AddrHelper(srcaddr, ip_current_dest_addr(), srcport, ip_current_input_netif());
+        DEBUGV(":urn %d\r\n", pb->tot_len);
+        __atomic_store_n(&_rx_head, head + 1, __ATOMIC_RELEASE);
 
         if (_on_rx) {
             _on_rx();
@@ -558,12 +519,14 @@ private:
 private:
     udp_pcb* _pcb;
     pbuf* _rx_buf;
-    bool _first_buf_taken;
     size_t _rx_buf_offset;
     size_t _rx_buf_size;
+    uint32_t _rx_head;
+    uint32_t _rx_tail;
+    uint32_t _rx_dropped;
     int _refcnt;
-    pbuf* _tx_buf_head;
-    pbuf* _tx_buf_cur;
+    int _tx_slot;
+    int _tx_next;
     size_t _tx_buf_offset;
     rxhandler_t _on_rx;
 #ifdef LWIP_MAYBE_XCC
@@ -580,9 +543,18 @@ private:
     };
     AddrHelper _currentAddr;
 
-    // rx pbuf depth barrier (counter of buffered UDP received packets)
-    // keep it small
-    static constexpr int rxBufMaxDepth = 4;
+    struct RxSlot {
+        pbuf* pb;
+        AddrHelper addr;
+    };
+    RxSlot _rx_ring[UDP_RX_RING];
+
+    struct TxSlot {
+        pbuf* pb;
+        void* data;  // Payload start as allocated, udp_sendto() moves pb->payload
+        size_t cap;
+    };
+    TxSlot _tx_pool[UDP_TX_POOL];
 };
 
 
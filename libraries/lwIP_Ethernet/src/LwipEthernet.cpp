@@ -19,6 +19,8 @@
 */
 
 #include <LwipEthernet.h>
+#include <SPI.h>
+#include <lwip/pbuf.h>
 #include <lwip_wrap.h>
 #include <lwip/timeouts.h>
 #include <lwip/dns.h>
@@ -53,6 +55,7 @@ static async_context_t *_context = nullptr;
 
 #endif
 
+#include <algorithm>
 #include <functional>
 #include <map>
 
@@ -121,9 +124,11 @@ void __removeEthernetPacketHandler(int id) {
 
 static uint32_t gpioMaskStack[GPIOSTACKSIZE][GPIOIRQREGS];
 static uint32_t gpioMask[GPIOIRQREGS] = {GPIOIRQREGSINIT};
+static int gpioMaskDepth = 0;
 
 void ethernet_arch_lwip_gpio_mask() {
     noInterrupts();
+    gpioMaskDepth++;
     memmove(gpioMaskStack[1], gpioMaskStack[0], GPIOIRQREGS * sizeof(uint32_t) * (GPIOSTACKSIZE - 1)); // Push down the stack
     io_bank0_irq_ctrl_hw_t *irq_ctrl_base = get_core_num() ? &io_bank0_hw->proc1_irq_ctrl : &io_bank0_hw->proc0_irq_ctrl;
     for (int i = 0; i < GPIOIRQREGS; i++) {
@@ -140,6 +145,20 @@ void ethernet_arch_lwip_gpio_unmask() {
         irq_ctrl_base->inte[i] = gpioMaskStack[0][i];
     }
     memmove(gpioMaskStack[0], gpioMaskStack[1],  GPIOIRQREGS * sizeof(uint32_t) * (GPIOSTACKSIZE - 1)); // Pop up the stack
+    if (gpioMaskDepth) {
+        gpioMaskDepth--;
+    }
+    interrupts();
+}
+
+// A pin's IRQ enables are restored by the outermost unmask, so change them where that one will find them
+void __enableEthernetGPIO(int pin, uint32_t events, bool enable) {
+    int idx = pin / 8;
+    uint32_t bits = (events & 0xf) << ((pin % 8) * 4);
+    noInterrupts();
+    io_bank0_irq_ctrl_hw_t *irq_ctrl_base = get_core_num() ? &io_bank0_hw->proc1_irq_ctrl : &io_bank0_hw->proc0_irq_ctrl;
+    uint32_t *inte = gpioMaskDepth ? &gpioMaskStack[std::min(gpioMaskDepth, GPIOSTACKSIZE) - 1][idx] : (uint32_t *)&irq_ctrl_base->inte[idx];
+    *inte = enable ? (*inte | bits) : (*inte & ~bits);
     interrupts();
 }
 
@@ -156,6 +175,52 @@ void __removeEthernetGPIO(int pin) {
     gpioMask[idx] |= 0xf << off;
 }
 
+// Below this a DMA setup costs more than it saves
+#define ETHERNET_DMA_MIN 64
+
+static SPIClassRP2040 *_dmaSPI(arduino::HardwareSPI &spi) {
+    // No RTTI, so check for the only SPIClassRP2040 instances by address
+    if (&spi == &SPI) {
+        return &SPI;
+    } else if (&spi == &SPI1) {
+        return &SPI1;
+    }
+    return nullptr;
+}
+
+bool __ethernetReadPbufStart(arduino::HardwareSPI &spi, struct pbuf *p) {
+    SPIClassRP2040 *hw = _dmaSPI(spi);
+    if (hw && (p->len >= ETHERNET_DMA_MIN) && hw->transferAsync(nullptr, p->payload, p->len)) {
+        return true;
+    }
+    spi.transfer(nullptr, p->payload, p->len);
+    return false;
+}
+
+void __ethernetReadPbufFinish(arduino::HardwareSPI &spi, struct pbuf *p, bool dma) {
+    if (dma) {
+        SPIClassRP2040 *hw = _dmaSPI(spi);
+        while (!hw->finishedAsync()) {
+            tight_loop_contents();
+        }
+    }
+    for (struct pbuf *q = p->next; q; q = q->next) {
+        spi.transfer(nullptr, q->payload, q->len);
+    }
+}
+
+void __ethernetWritePbuf(arduino::HardwareSPI &spi, struct pbuf *p) {
+    SPIClassRP2040 *hw = _dmaSPI(spi);
+    for (struct pbuf *q = p; q; q = q->next) {
+        if (hw && (q->len >= ETHERNET_DMA_MIN) && hw->transferAsync(q->payload, nullptr, q->len)) {
+            while (!hw->finishedAsync()) {
+                tight_loop_contents();
+            }
+        } else {
+            spi.transfer(q->payload, nullptr, q->len);
+        }
+    }
+}
 
 static volatile bool _dns_lookup_pending = false;
 
@@ -206,6 +271,24 @@ int hostByName(const char* aHostname, IPAddress& aResult, int timeout_ms) {
 }
 
 static uint32_t _pollingPeriod = 20;
+// Interfaces currently handling a burst of frames by polling instead of IRQs
+static volatile int _fastPollers = 0;
+
+static uint32_t _pollPeriod() {
+    return _fastPollers ? 1 : _pollingPeriod;
+}
+
+void __ethernetFastPoll(bool fast) {
+    noInterrupts();
+    _fastPollers += fast ? 1 : -1;
+    interrupts();
+#ifndef __FREERTOS
+    if (fast && _context) {
+        // Don't wait out the rest of the current period for the first fast poll
+        async_context_set_work_pending(_context, &always_pending_update_timeout_worker);
+    }
+#endif
+}
 
 // We have a background pump which calls sys_check_timeouts on a periodic basis
 // and polls all Ethernet interfaces
@@ -228,17 +311,20 @@ static void ethernetTask(void *param) {
     (void) param;
     while (true) {
         uint32_t sleep_ms = sys_timeouts_sleeptime();
-        if (sleep_ms > _pollingPeriod) {
-            sleep_ms = _pollingPeriod;
+        if (sleep_ms > _pollPeriod()) {
+            sleep_ms = _pollPeriod();
         }
         vTaskDelay(sleep_ms / portTICK_PERIOD_MS);
         lwip_callback(stage2, nullptr);
     }
 }
 #else
+static bool _timeoutQueued = false;
+
 // This will only be called under the protection of the async context mutex, so no re-entrancy checks needed
 static void ethernet_timeout_reached(__unused async_context_t *context, __unused async_at_time_worker_t *worker) {
     assert(worker == &ethernet_timeout_worker);
+    _timeoutQueued = false;
     ethernet_arch_lwip_gpio_mask(); // Ensure non-polled devices won't interrupt us
     for (auto handlePacket : _handlePacketList) {
         handlePacket.second();
@@ -255,7 +341,12 @@ static void ethernet_timeout_reached(__unused async_context_t *context, __unused
 static void update_next_timeout(async_context_t *context, async_when_pending_worker_t *worker) {
     assert(worker == &always_pending_update_timeout_worker);
     worker->work_pending = true;
-    async_context_add_at_time_worker_in_ms(context, &ethernet_timeout_worker, _pollingPeriod);
+    // Frames are only read by polling during a fast poll, so don't let busy user code push back one that's due
+    if (_fastPollers && _timeoutQueued && (absolute_time_diff_us(get_absolute_time(), ethernet_timeout_worker.next_time) <= 1000)) {
+        return;
+    }
+    async_context_add_at_time_worker_in_ms(context, &ethernet_timeout_worker, _pollPeriod());
+    _timeoutQueued = true;
 }
 #endif
 
@@ -32,6 +32,22 @@ void ethernet_arch_lwip_gpio_unmask() __attribute__((weak));
 
 void __addEthernetGPIO(int pin);
 void __removeEthernetGPIO(int pin);
+// Enables or disables the given GPIO_IRQ_* events of an Ethernet GPIO's IRQ, also when called
+// between ethernet_arch_lwip_gpio_mask() and ethernet_arch_lwip_gpio_unmask()
+void __enableEthernetGPIO(int pin, uint32_t events, bool enable);
+
+// SPI driver helpers to read the rest of a frame into a pbuf chain while the driver holds CS.
+// On the hardware SPI ports the first (normally only) pbuf is filled by DMA in the background.
+// __ethernetReadPbufStart() returns whether it did so, which __ethernetReadPbufFinish() needs
+// to wait for it before reading any following pbufs.
+namespace arduino {
+class HardwareSPI;
+};
+struct pbuf;
+bool __ethernetReadPbufStart(arduino::HardwareSPI &spi, struct pbuf *p);
+void __ethernetReadPbufFinish(arduino::HardwareSPI &spi, struct pbuf *p, bool dma);
+// Writes a whole (possibly chained) frame while the driver holds CS, using DMA for large pbufs
+void __ethernetWritePbuf(arduino::HardwareSPI &spi, struct pbuf *p);
 
 // Internal Ethernet helper functions
 void __startEthernetContext();
@@ -46,6 +62,8 @@ extern "C" async_context_t *__getEthernetContext();
 
 int __addEthernetPacketHandler(std::function<void(void)> _packetHandler);
 void __removeEthernetPacketHandler(int id);
+// Polls the packet handlers every millisecond while any interface has asked for it
+void __ethernetFastPoll(bool fast);
 
 // Used by WiFiClient to get DNS lookup
 int hostByName(const char *aHostname, IPAddress &aResult, int timeout_ms = 5000);
@@ -55,6 +55,26 @@
 #define DEFAULT_MTU 1500
 #endif
 
+// Hybrid polling: frames handled by one IRQ that switch to polling, empty polls that switch back
+#ifndef ETHERNET_HYBRID_BURST
+#define ETHERNET_HYBRID_BURST 4
+#endif
+#ifndef ETHERNET_HYBRID_IDLE
+#define ETHERNET_HYBRID_IDLE 5
+#endif
+
+// Frames lwIP can queue for sending while the chip's transmit buffer is full
+#ifndef ETHERNET_TX_RING
+#define ETHERNET_TX_RING 8
+#endif
+
+// Pass each received frame to lwIP while the next one is still being read.  lwIP callbacks
+// then run with the SPI bus busy, so only enable this when nothing but this interface's chip
+// is on that bus.  Not available under FreeRTOS, where other tasks may use the bus.
+#ifndef ETHERNET_RX_OVERLAP
+#define ETHERNET_RX_OVERLAP 0
+#endif
+
 // Dup'd to avoid CYW43 dependency
 // Generate a mac address if one is not set in otp
 static void _cyw43_hal_generate_laa_mac(__unused int idx, uint8_t buf[6]) {
@@ -171,6 +191,29 @@ public:
         return _packetsSent;
     }
 
+    // With an interrupt GPIO, handle bursts of frames by polling every millisecond instead of
+    // taking an IRQ per frame, and go back to IRQs once the interface goes idle.  Call before begin().
+    void setHybridPolling(bool hybrid = true) {
+        _hybrid = hybrid;
+    }
+    // Received frames per second, averaged since the previous call (at most once a second)
+    uint32_t packetsPerSecond() {
+        uint32_t now = millis();
+        if (now - _rateStart >= 1000) {
+            _rate = (uint64_t)(_packetsReceived - _rateCount) * 1000 / (now - _rateStart);
+            _rateStart = now;
+            _rateCount = _packetsReceived;
+        }
+        return _rate;
+    }
+    // Number of interrupts and of polls that looked for frames
+    uint32_t interruptCount() {
+        return _irqCount;
+    }
+    uint32_t pollCount() {
+        return _pollCount;
+    }
+
 
     // ESP8266WiFi API compatibility
 
@@ -220,8 +263,56 @@ protected:
 
     uint32_t _packetsReceived = 0;
     uint32_t _packetsSent = 0;
+    uint32_t _rateStart = 0;
+    uint32_t _rateCount = 0;
+    uint32_t _rate = 0;
+    uint32_t _irqCount = 0;
+    uint32_t _pollCount = 0;
+
+    // Hybrid mode: _polling while a burst is being polled with the IRQ disabled
+    bool _hybrid = false;
+    volatile bool _polling = false;
+    int _idlePolls = 0;
+    void _poll();
+    void _startPolling();
+    uint32_t _irqEvents();
 
     static void _lwipCallback(void *param);
+
+    // Drivers with readFrameStart()/readFrameFinish() can read frames into PBUF_POOL chains
+    static constexpr bool _rxIntoPbuf() {
+        return requires(LwipIntfDev &d, pbuf *p) {
+            d.readFrameStart(p, (uint16_t)0);
+            d.readFrameFinish();
+        };
+    }
+    static constexpr bool _rxOverlap() {
+#if ETHERNET_RX_OVERLAP && !defined(__FREERTOS)
+        return _rxIntoPbuf();
+#else
+        return false;
+#endif
+    }
+    // Frame readFrameStart() is still reading, the SPI bus is busy until _rxFinish()
+    pbuf *_rxReading = nullptr;
+    err_t _handlePacketsPool();
+    void _rxFinish();
+    err_t _rxInput(pbuf *p);
+
+    // Drivers with sendFrameQueue()/sendFrameFlush() don't wait for each frame to go out
+    static constexpr bool _txQueued() {
+        return requires(LwipIntfDev &d, pbuf *p) {
+            d.sendFrameQueue(p);
+            d.sendFrameFlush();
+        };
+    }
+    // Frames waiting for room in the chip, each holding a reference until it's written
+    pbuf *_txRing[ETHERNET_TX_RING];
+    int _txHead = 0;
+    int _txCount = 0;
+    bool _txPolling = false;
+    void _txPump();
+    void _txService();
 };
 
 
@@ -401,8 +492,17 @@ bool LwipIntfDev<RawDev>::begin(const uint8_t* macAddress, const uint16_t mtu) {
         return false;
     }
 
-    if (_intrPin < 0) {
-        _phID = __addEthernetPacketHandler([this] { this->handlePackets(); });
+    if ((_intrPin >= 0) && !RawDev::interruptIsPossible()) {
+        ::printf((PGM_P)F(
+                     "lwIP_Intf: Interrupt not implemented yet, enabling transparent polling\r\n"));
+        _intrPin = -1;
+    }
+    // Only level triggered IRQs can be turned back on without losing a frame that came in meanwhile
+    _hybrid = _hybrid && (_intrPin >= 0) && ((_irqEvents() == GPIO_IRQ_LEVEL_LOW) || (_irqEvents() == GPIO_IRQ_LEVEL_HIGH));
+    _polling = false;
+
+    if ((_intrPin < 0) || _hybrid || _txQueued()) {
+        _phID = __addEthernetPacketHandler([this] { this->_poll(); });
     }
 
     if (_isDHCP) {
@@ -412,8 +512,9 @@ bool LwipIntfDev<RawDev>::begin(const uint8_t* macAddress, const uint16_t mtu) {
         // Start a new DHCP request
         _netif.flags |= NETIF_FLAG_UP;
         if (dhcp_start(&_netif) != ERR_OK) {
-            if (_intrPin < 0) {
+            if (_phID >= 0) {
                 __removeEthernetPacketHandler(_phID);
+                _phID = -1;
             }
             netif_remove(&_netif);
             return false;
@@ -436,17 +537,11 @@ bool LwipIntfDev<RawDev>::begin(const uint8_t* macAddress, const uint16_t mtu) {
     _started = true;
 
     if (_intrPin >= 0) {
-        if (RawDev::interruptIsPossible()) {
-            noInterrupts(); // Ensure this is atomically set up
-            pinMode(_intrPin, INPUT);
-            attachInterruptParam(_intrPin, _irq, RawDev::interruptMode(), (void*)this);
-            __addEthernetGPIO(_intrPin);
-            interrupts();
-        } else {
-            ::printf((PGM_P)F(
-                         "lwIP_Intf: Interrupt not implemented yet, enabling transparent polling\r\n"));
-            _intrPin = -1;
-        }
+        noInterrupts(); // Ensure this is atomically set up
+        pinMode(_intrPin, INPUT);
+        attachInterruptParam(_intrPin, _irq, RawDev::interruptMode(), (void*)this);
+        __addEthernetGPIO(_intrPin);
+        interrupts();
     }
 
     if (_addNetifCB) {
@@ -465,12 +560,27 @@ void LwipIntfDev<RawDev>::end() {
             dhcp_stop(&_netif);
             dhcp_cleanup(&_netif);
         }
-        if (_intrPin < 0) {
+        if (_phID >= 0) {
             __removeEthernetPacketHandler(_phID);
-        } else {
+            _phID = -1;
+        }
+        if (_intrPin >= 0) {
             detachInterrupt(_intrPin);
             __removeEthernetGPIO(_intrPin);
         }
+        if (_polling) {
+            _polling = false;
+            __ethernetFastPoll(false);
+        }
+        while (_txCount) {
+            pbuf_free(_txRing[_txHead]);
+            _txHead = (_txHead + 1) % ETHERNET_TX_RING;
+            _txCount--;
+        }
+        if (_txPolling) {
+            _txPolling = false;
+            __ethernetFastPoll(false);
+        }
 
         if (_removeNetifCB) {
             _removeNetifCB(&_netif);
@@ -487,7 +597,13 @@ void LwipIntfDev<RawDev>::end() {
 template<class RawDev>
 void LwipIntfDev<RawDev>::_lwipCallback(void *param) {
     LwipIntfDev *d = static_cast<LwipIntfDev*>(param);
+    d->_irqCount++;
+    uint32_t start = d->_packetsReceived;
     d->handlePackets();
+    if (d->_hybrid && !d->_polling && (d->_packetsReceived - start >= ETHERNET_HYBRID_BURST)) {
+        // More frames are likely right behind these, stop taking an IRQ for each
+        d->_startPolling();
+    }
     sys_check_timeouts();
     ethernet_arch_lwip_gpio_unmask();
 }
@@ -495,6 +611,11 @@ void LwipIntfDev<RawDev>::_lwipCallback(void *param) {
 template<class RawDev>
 void LwipIntfDev<RawDev>::_irq(void *param) {
     LwipIntfDev *d = static_cast<LwipIntfDev*>(param);
+    if (d->_polling) {
+        // Raced with _startPolling(), the poll will get this frame
+        __enableEthernetGPIO(d->_intrPin, d->_irqEvents(), false);
+        return;
+    }
     ethernet_arch_lwip_gpio_mask(); // Disable other IRQs until we're done processing this one
     if (__inLWIP) {
         __needsIRQEN = true;
@@ -503,6 +624,54 @@ void LwipIntfDev<RawDev>::_irq(void *param) {
     lwip_callback(_lwipCallback, param, &d->_irqBuffer);
 }
 
+template<class RawDev>
+uint32_t LwipIntfDev<RawDev>::_irqEvents() {
+    switch (RawDev::interruptMode()) {
+    case LOW:
+        return GPIO_IRQ_LEVEL_LOW;
+    case HIGH:
+        return GPIO_IRQ_LEVEL_HIGH;
+    case FALLING:
+        return GPIO_IRQ_EDGE_FALL;
+    case RISING:
+        return GPIO_IRQ_EDGE_RISE;
+    default:
+        return GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE;
+    }
+}
+
+// Called with the Ethernet GPIO IRQs masked, so the enable takes effect at the unmask
+template<class RawDev>
+void LwipIntfDev<RawDev>::_startPolling() {
+    _polling = true;
+    _idlePolls = 0;
+    __enableEthernetGPIO(_intrPin, _irqEvents(), false);
+    __ethernetFastPoll(true);
+}
+
+// Packet handler, polls when there's no interrupt GPIO or during a hybrid mode burst
+template<class RawDev>
+void LwipIntfDev<RawDev>::_poll() {
+    _txService();
+    if ((_intrPin >= 0) && !_polling) {
+        return;
+    }
+    _pollCount++;
+    uint32_t start = _packetsReceived;
+    handlePackets();
+    if ((_intrPin < 0) || (_packetsReceived != start)) {
+        _idlePolls = 0;
+        return;
+    }
+    if (++_idlePolls >= ETHERNET_HYBRID_IDLE) {
+        // Burst is over, let the chip's IRQ wake us for the next frame.  Anything that
+        // arrived since the last poll holds the level IRQ and fires right at the unmask.
+        _polling = false;
+        __enableEthernetGPIO(_intrPin, _irqEvents(), true);
+        __ethernetFastPoll(false);
+    }
+}
+
 template<class RawDev>
 wl_status_t LwipIntfDev<RawDev>::status() {
     return _started ? (connected() ? WL_CONNECTED : WL_DISCONNECTED) : WL_NO_SHIELD;
@@ -517,13 +686,65 @@ template<class RawDev>
 err_t LwipIntfDev<RawDev>::linkoutput_s(netif* netif, struct pbuf* pbuf) {
     LwipIntfDev* lid = (LwipIntfDev*)netif->state;
 
+    // With ETHERNET_RX_OVERLAP we may be sending from inside _rxInput() while the next
+    // frame is being read
+    lid->_rxFinish();
+
 #ifdef __FREERTOS
     xSemaphoreTake(lid->_hwMutex, portMAX_DELAY);
 #else
     ethernet_arch_lwip_begin();
 #endif
 
-    uint16_t len = lid->sendFrame(pbuf);
+    err_t err = ERR_OK;
+    if constexpr (_txQueued()) {
+        if (lid->_txCount == ETHERNET_TX_RING) {
+            lid->_txPump();
+        }
+        if (lid->_txCount == ETHERNET_TX_RING) {
+            // Let lwIP hold on to it, TCP will send it again later
+            err = ERR_MEM;
+        } else {
+            int slot = (lid->_txHead + lid->_txCount) % ETHERNET_TX_RING;
+            pbuf_ref(pbuf);
+            lid->_txRing[slot] = pbuf;
+            lid->_txCount++;
+            lid->_txPump();
+            if (lid->_txCount && (lid->_txRing[slot] == pbuf)) {
+                // Still queued, so copy any PBUF_REF data its sender may reuse once we return
+                for (struct pbuf *q = pbuf; q; q = q->next) {
+                    if (PBUF_NEEDS_COPY(q)) {
+                        lid->_txRing[slot] = pbuf_clone(PBUF_RAW, PBUF_RAM, pbuf);
+                        if (!lid->_txRing[slot]) {
+                            lid->_txCount--;
+                            err = ERR_MEM;
+                        }
+                        pbuf_free(pbuf);
+                        break;
+                    }
+                }
+            }
+        }
+    } else {
+        // Drivers without sendFrameQueue() send a single buffer
+        struct pbuf *q = pbuf->next ? pbuf_clone(PBUF_RAW, PBUF_RAM, pbuf) : pbuf;
+        if (!q) {
+            err = ERR_MEM;
+        } else {
+            uint16_t len = lid->sendFrame(q);
+            lid->_packetsSent++;
+#if PHY_HAS_CAPTURE
+            if (phy_capture) {
+                phy_capture(lid->_netif.num, (const char*)q->payload, q->len, /*out*/ 1,
+                            /*success*/ len == q->len);
+            }
+#endif
+            err = len == q->len ? ERR_OK : ERR_MEM;
+            if (q != pbuf) {
+                pbuf_free(q);
+            }
+        }
+    }
 
 #ifdef __FREERTOS
     xSemaphoreGive(lid->_hwMutex);
@@ -531,14 +752,50 @@ err_t LwipIntfDev<RawDev>::linkoutput_s(netif* netif, struct pbuf* pbuf) {
     ethernet_arch_lwip_end();
 #endif
 
-    lid->_packetsSent++;
+    return err;
+}
+
+// Moves queued frames into the chip's transmit buffer, with the SPI bus already held
+template<class RawDev>
+void LwipIntfDev<RawDev>::_txPump() {
+    if constexpr (_txQueued()) {
+        while (_txCount) {
+            pbuf *p = _txRing[_txHead];
+            int len = RawDev::sendFrameQueue(p);
+            if (!len) {
+                break; // No room until the chip sends what it has
+            }
+            _txHead = (_txHead + 1) % ETHERNET_TX_RING;
+            _txCount--;
+            _packetsSent++;
 #if PHY_HAS_CAPTURE
-    if (phy_capture) {
-        phy_capture(lid->_netif.num, (const char*)pbuf->payload, pbuf->len, /*out*/ 1,
-                    /*success*/ len == pbuf->len);
+            if (phy_capture) {
+                phy_capture(_netif.num, (const char*)p->payload, p->len, /*out*/ 1,
+                            /*success*/ len > 0);
+            }
+#endif
+            pbuf_free(p); // The chip has its own copy now
+        }
+        // Poll quickly until the frames left behind are all sent
+        bool waiting = RawDev::sendFrameFlush() || _txCount;
+        if (waiting != _txPolling) {
+            _txPolling = waiting;
+            __ethernetFastPoll(waiting);
+        }
     }
+}
+
+template<class RawDev>
+void LwipIntfDev<RawDev>::_txService() {
+    if constexpr (_txQueued()) {
+#ifdef __FREERTOS
+        xSemaphoreTake(_hwMutex, portMAX_DELAY);
+#endif
+        _txPump();
+#ifdef __FREERTOS
+        xSemaphoreGive(_hwMutex);
 #endif
-    return len == pbuf->len ? ERR_OK : ERR_MEM;
+    }
 }
 
 template<class RawDev>
@@ -609,6 +866,9 @@ void LwipIntfDev<RawDev>::check_route() {
 
 template<class RawDev>
 err_t LwipIntfDev<RawDev>::handlePackets() {
+    if constexpr (_rxIntoPbuf()) {
+        return _handlePacketsPool();
+    }
     int pkt = 0;
     while (1) {
         if (++pkt == 10)
@@ -631,11 +891,9 @@ err_t LwipIntfDev<RawDev>::handlePackets() {
         // from doc: use PBUF_RAM for TX, PBUF_POOL from RX
         // however:
         // PBUF_POOL can return chained pbuf (not in one piece)
-        // and WiznetDriver does not have the proper API to deal with that
-        // so in the meantime, we use PBUF_RAM instead which is currently
-        // guarantying to deliver a continuous chunk of memory.
-        // TODO: tweak the wiznet driver to allow copying partial chunk
-        //       of received data and use PBUF_POOL.
+        // and drivers without readFrameStart() can only fill one buffer,
+        // so we use PBUF_RAM instead which is guaranteed to deliver
+        // a continuous chunk of memory.
         pbuf* pbuf = pbuf_alloc(PBUF_RAW, tot_len, PBUF_RAM);
         if (!pbuf || pbuf->len < tot_len) {
             if (pbuf) {
@@ -678,6 +936,90 @@ err_t LwipIntfDev<RawDev>::handlePackets() {
     }
 }
 
+// Reads frames straight into (possibly chained) PBUF_POOL pbufs, with DMA when the driver
+// can.  With ETHERNET_RX_OVERLAP each frame goes up the stack while the driver is reading
+// the next one.
+template<class RawDev>
+err_t LwipIntfDev<RawDev>::_handlePacketsPool() {
+    pbuf *ready = nullptr;
+    err_t ret = ERR_OK;
+    for (int pkt = 0; pkt < 10; pkt++) { // prevent starvation
+#ifdef __FREERTOS
+        xSemaphoreTake(_hwMutex, portMAX_DELAY);
+#endif
+        uint16_t tot_len = RawDev::readFrameSize();
+        if (!tot_len) {
+#ifdef __FREERTOS
+            xSemaphoreGive(_hwMutex);
+#endif
+            break;
+        }
+        pbuf* p = pbuf_alloc(PBUF_RAW, tot_len, PBUF_POOL);
+        if (!p) {
+            // The pool can run dry under load, try the heap before dropping the frame
+            p = pbuf_alloc(PBUF_RAW, tot_len, PBUF_RAM);
+        }
+        if (!p) {
+            RawDev::discardFrame(tot_len);
+#ifdef __FREERTOS
+            xSemaphoreGive(_hwMutex);
+#endif
+            ret = ERR_BUF;
+            break;
+        }
+        RawDev::readFrameStart(p, tot_len);
+        if constexpr (_rxOverlap()) {
+            _rxReading = p;
+        } else {
+            // The bus may be shared with devices lwIP callbacks use, so release it first
+            RawDev::readFrameFinish();
+        }
+#ifdef __FREERTOS
+        xSemaphoreGive(_hwMutex);
+#endif
+        if (ready) {
+            err_t err = _rxInput(ready);
+            ret = (ret == ERR_OK) ? err : ret;
+        }
+        _rxFinish();
+        ready = p;
+    }
+    if (ready) {
+        err_t err = _rxInput(ready);
+        ret = (ret == ERR_OK) ? err : ret;
+    }
+    return ret;
+}
+
+template<class RawDev>
+void LwipIntfDev<RawDev>::_rxFinish() {
+    if constexpr (_rxOverlap()) {
+        if (_rxReading) {
+            RawDev::readFrameFinish();
+            _rxReading = nullptr;
+        }
+    }
+}
+
+template<class RawDev>
+err_t LwipIntfDev<RawDev>::_rxInput(pbuf *p) {
+    _packetsReceived++;
+    err_t err = _netif.input(p, &_netif);
+
+#if PHY_HAS_CAPTURE
+    if (phy_capture) {
+        phy_capture(_netif.num, (const char*)p->payload, p->len, /*out*/ 0,
+                    /*success*/ err == ERR_OK);
+    }
+#endif
+
+    if (err != ERR_OK) {
+        pbuf_free(p);
+    }
+    // (else) pbuf is now lwIP's responsibility
+    return err;
+}
+
 template<class RawDev>
 void LwipIntfDev<RawDev>::setDefault(bool deflt) {
     _default = deflt;
@@ -0,0 +1,99 @@
+/*
+    PIO bus clock tuning shared by the W55RP20 and W6300 drivers
+
+    Copyright (c) 2026 Earle F. Philhower, III <earlephilhower@yahoo.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <hardware/clocks.h>
+
+typedef struct {
+    uint16_t major;
+    uint8_t minor;
+} WiznetPioClockDiv;
+
+// PIO clock dividers tuning tries, fastest first.  The last entry is the stock
+// setting known to work everywhere.
+static const WiznetPioClockDiv __wiznetPioClockDivs[] = { {1, 0}, {1, 128}, {2, 0}, {2, 128}, {3, 0}, {4, 0} };
+static constexpr int __wiznetPioClockDivCount = sizeof(__wiznetPioClockDivs) / sizeof(__wiznetPioClockDivs[0]);
+
+// Both PIO programs take 2 instructions per SCK period
+static inline uint32_t wiznetPioClockHz(const WiznetPioClockDiv &d) {
+    return (uint32_t)(((uint64_t)clock_get_hz(clk_sys) * 256) / (2 * (d.major * 256 + d.minor)));
+}
+
+// Write test patterns to the chip's buffer with write(out, len) and read them back
+// with read(in, len).  Returns true if everything read back unchanged.
+template <typename Write, typename Read>
+bool wiznetPioCheckBus(Write write, Read read) {
+    uint8_t out[256];
+    uint8_t in[256];
+    // Alternating bits, full swings between all-0s and all-1s, and a pseudorandom run
+    for (int pass = 0; pass < 3; pass++) {
+        for (size_t i = 0; i < sizeof(out); i++) {
+            if (pass == 0) {
+                out[i] = (i & 1) ? 0xaa : 0x55;
+            } else if (pass == 1) {
+                out[i] = (i & 1) ? 0xff : 0x00;
+            } else {
+                out[i] = i * 37 + 11;
+            }
+        }
+        memset(in, ~out[0], sizeof(in));
+        write(out, sizeof(out));
+        read(in, sizeof(in));
+        if (memcmp(in, out, sizeof(in))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Try dividers no faster than maxHz with setDiv(major, minor) until checkBus() passes,
+// then settle one step slower for temperature and voltage margin.  The divider left
+// set is returned in chosen.  Returns true if any divider failed, so the chip's
+// registers may hold garbage and it should be reset.
+template <typename Check, typename SetDiv>
+bool wiznetPioTuneClock(uint32_t maxHz, Check checkBus, SetDiv setDiv, WiznetPioClockDiv &chosen) {
+    const int stock = __wiznetPioClockDivCount - 1;
+    chosen = __wiznetPioClockDivs[stock];
+    if (!checkBus()) {
+        // Nothing (working) on the other end, leave the default alone
+        return false;
+    }
+    int best = stock;
+    bool failed = false;
+    for (int i = 0; i < stock; i++) {
+        if (wiznetPioClockHz(__wiznetPioClockDivs[i]) > maxHz) {
+            continue;
+        }
+        setDiv(__wiznetPioClockDivs[i].major, __wiznetPioClockDivs[i].minor);
+        if (checkBus()) {
+            best = i;
+            break;
+        }
+        failed = true;
+    }
+    if (best < stock) {
+        best++;
+    }
+    chosen = __wiznetPioClockDivs[best];
+    setDiv(chosen.major, chosen.minor);
+    return failed;
+}
@@ -517,7 +517,9 @@ bool ENC28J60::begin(const uint8_t* address, netif *net) {
 /*---------------------------------------------------------------------------*/
 
 void ENC28J60::end() {
-
+    /* Release INT and stop receiving */
+    clearregbitfield(EIE, EIE_INTIE | EIE_PKTIE);
+    clearregbitfield(ECON1, ECON1_RXEN);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -668,7 +670,39 @@ uint16_t ENC28J60::readFrameData(uint8_t* buffer, uint16_t framesize) {
     } else {
         readdata(buffer, _len);
     }
+    releaseframe();
+
+    if (!buffer) {
+        PRINTF("enc28j60: rx err: flushed %d\n", _len);
+        return 0;
+    }
+    PRINTF("enc28j60: rx: %d: %02x:%02x:%02x:%02x:%02x:%02x\n", _len, 0xff & buffer[0],
+           0xff & buffer[1], 0xff & buffer[2], 0xff & buffer[3], 0xff & buffer[4],
+           0xff & buffer[5]);
+
+    // received_packets++;
+    // PRINTF("enc28j60: received_packets %d\n", received_packets);
+
+    return _len;
+}
+
+void ENC28J60::readFrameStart(struct pbuf *p, uint16_t framesize) {
+    (void)framesize;
+    _rxFrame = p;
+    enc28j60_arch_spi_select();
+    /* Same RBM command as readdata(), but the data is read into the pbufs */
+    SPI.transfer(0x3a);
+    _rxDMA = __ethernetReadPbufStart(SPI, p);
+}
+
+void ENC28J60::readFrameFinish() {
+    __ethernetReadPbufFinish(SPI, _rxFrame, _rxDMA);
+    enc28j60_arch_spi_deselect();
+    _rxFrame = nullptr;
+    releaseframe();
+}
 
+void ENC28J60::releaseframe(void) {
     /* Read an additional byte at odd lengths, to avoid FIFO corruption */
     if ((_len % 2) != 0) {
         readdatabyte();
@@ -684,19 +718,6 @@ uint16_t ENC28J60::readFrameData(uint8_t* buffer, uint16_t framesize) {
     writereg(ERXRDPTH, _next >> 8);
 
     setregbitfield(ECON2, ECON2_PKTDEC);
-
-    if (!buffer) {
-        PRINTF("enc28j60: rx err: flushed %d\n", _len);
-        return 0;
-    }
-    PRINTF("enc28j60: rx: %d: %02x:%02x:%02x:%02x:%02x:%02x\n", _len, 0xff & buffer[0],
-           0xff & buffer[1], 0xff & buffer[2], 0xff & buffer[3], 0xff & buffer[4],
-           0xff & buffer[5]);
-
-    // received_packets++;
-    // PRINTF("enc28j60: received_packets %d\n", received_packets);
-
-    return _len;
 }
 
 uint16_t ENC28J60::phyread(uint8_t reg) {
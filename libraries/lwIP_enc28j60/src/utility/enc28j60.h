@@ -135,6 +135,21 @@ protected:
     */
     uint16_t readFrameData(uint8_t* frame, uint16_t framesize);
 
+    /**
+        Start reading an Ethernet frame data into a pbuf chain, with DMA if possible
+           readFrameSize() must be called first,
+           its result must be passed into framesize parameter,
+           and nothing else may use the SPI bus until readFrameFinish()
+        @param p a pbuf chain of framesize bytes
+        @param framesize readFrameSize()'s result
+    */
+    void readFrameStart(struct pbuf *p, uint16_t framesize);
+
+    /**
+        Wait for the frame data readFrameStart() is reading and release the frame
+    */
+    void readFrameFinish();
+
 private:
     uint8_t is_mac_mii_reg(uint8_t reg);
     uint8_t readreg(uint8_t reg);
@@ -146,6 +161,7 @@ private:
     void    writedatabyte(uint8_t byte);
     int     readdata(uint8_t* buf, int len);
     uint8_t readdatabyte(void);
+    void    releaseframe(void);
     void    softreset(void);
     uint8_t readrev(void);
     bool    reset(void);
@@ -170,6 +186,8 @@ private:
 
     /* readFrame*() state */
     uint16_t _next, _len;
+    struct pbuf *_rxFrame = nullptr;
+    bool _rxDMA = false;
 };
 
 #endif /* ENC28J60_H */
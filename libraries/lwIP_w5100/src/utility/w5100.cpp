@@ -216,6 +216,9 @@ bool Wiznet5100::begin(const uint8_t* mac_address, netif *net) {
 }
 
 void Wiznet5100::end() {
+    // Release INTn before closing so nothing fires once LwipIntfDev detached the pin
+    setIMR(0);
+
     setSn_CR(Sn_CR_CLOSE);
 
     // clear all interrupt of the socket
@@ -277,6 +280,18 @@ uint16_t Wiznet5100::readFrameData(uint8_t* buffer, uint16_t framesize) {
     return framesize;
 }
 
+void Wiznet5100::readFrameStart(struct pbuf *p, uint16_t framesize) {
+    (void) framesize;
+    // Every byte is its own SPI transaction, so no DMA
+    for (struct pbuf *q = p; q; q = q->next) {
+        wizchip_recv_data((uint8_t *)q->payload, q->len);
+    }
+}
+
+void Wiznet5100::readFrameFinish() {
+    setSn_CR(Sn_CR_RECV);
+}
+
 uint16_t Wiznet5100::sendFrame(struct pbuf *p) {
     ethernet_arch_lwip_gpio_mask(); // So we don't fire an IRQ and interrupt the send w/a receive!
 
@@ -132,6 +132,21 @@ protected:
     */
     uint16_t readFrameData(uint8_t* frame, uint16_t framesize);
 
+    /**
+        Start reading an Ethernet frame data into a pbuf chain, with DMA if possible
+           readFrameSize() must be called first,
+           its result must be passed into framesize parameter,
+           and nothing else may use the SPI bus until readFrameFinish()
+        @param p a pbuf chain of framesize bytes
+        @param framesize readFrameSize()'s result
+    */
+    void readFrameStart(struct pbuf *p, uint16_t framesize);
+
+    /**
+        Wait for the frame data readFrameStart() is reading and release the frame
+    */
+    void readFrameFinish();
+
 private:
     static const uint16_t TxBufferAddress = 0x4000; /* Internal Tx buffer address of the iinchip */
     static const uint16_t RxBufferAddress = 0x6000; /* Internal Rx buffer address of the iinchip */
@@ -36,6 +36,7 @@
 #include "wiznet_pio_spi.h"
 #include "w55rp20.h"
 #include <LwipEthernet.h>
+#include <WiznetPioClock.h>
 
 wiznet_pio_spi_config_t wiznet_pio_spi_config;
 wiznet_pio_spi_handle_t wiznet_pio_spi_handle = NULL;
@@ -245,6 +246,42 @@ int8_t Wiznet55rp20::wizphy_setphypmode(uint8_t pmode) {
     return -1;
 }
 
+// begin() can try faster PIO clocks than the stock divider, checking each by writing
+// and reading back test patterns.  A single passing test doesn't prove a clock has
+// margin for temperature and load changes, so this is opt-in.
+#ifndef WIZNET_PIO_SPI_AUTOTUNE
+#define WIZNET_PIO_SPI_AUTOTUNE 0
+#endif
+// Fastest SCK autotuning may pick.  The default is the 33.3MHz the W5500 core's datasheet
+// guarantees SPI timing for, raise it only as far as your board allows.
+#ifndef WIZNET_PIO_SPI_MAX_HZ
+#define WIZNET_PIO_SPI_MAX_HZ 33333333
+#endif
+
+// The test and search are shared with the other PIO Wiznet driver, see WiznetPioClock.h
+bool Wiznet55rp20::checkBus() {
+    return wiznetPioCheckBus([this](const uint8_t *out, uint16_t len) {
+        wizchip_write_buf(BlockSelectTxBuf, 0, out, len);
+    }, [this](uint8_t *in, uint16_t len) {
+        wizchip_read_buf(BlockSelectTxBuf, 0, in, len);
+    });
+}
+
+bool Wiznet55rp20::tuneClock() {
+    if (!WIZNET_PIO_SPI_AUTOTUNE) {
+        return false;
+    }
+    WiznetPioClockDiv div;
+    bool failed = wiznetPioTuneClock(WIZNET_PIO_SPI_MAX_HZ, [this]() {
+        return checkBus();
+    }, [](uint16_t major, uint8_t minor) {
+        wiznet_pio_spi_set_clkdiv(wiznet_pio_spi_handle, major, minor);
+    }, div);
+    wiznet_pio_spi_config.clock_div_major = div.major;
+    wiznet_pio_spi_config.clock_div_minor = div.minor;
+    return failed;
+}
+
 Wiznet55rp20::Wiznet55rp20(int8_t cs, SPIClass& spi, int8_t intr) : _spi(spi), _cs(cs), _intr(intr) {
 }
 
@@ -268,6 +305,11 @@ bool Wiznet55rp20::begin(const uint8_t* mac_address, netif *net) {
     wizchip_cs_deselect();
 
     wizchip_sw_reset();
+    // Speed up the bus as far as the board allows, resetting again afterwards in case a
+    // failed attempt wrote garbage to the registers
+    if (tuneClock()) {
+        wizchip_sw_reset();
+    }
 
     // Use the full 16Kb of RAM for Socket 0
     setSn_RXBUF_SIZE(16);
@@ -286,6 +328,7 @@ bool Wiznet55rp20::begin(const uint8_t* mac_address, netif *net) {
 
     if (_intr >= 0) {
         setSn_IR(0xff); // Clear everything
+        setSn_IMR(Sn_IR_RECV); // Only received frames raise INTn, sendFrame() polls SENDOK itself
         setSIMR(1);
     }
 
@@ -294,6 +337,9 @@ bool Wiznet55rp20::begin(const uint8_t* mac_address, netif *net) {
 }
 
 void Wiznet55rp20::end() {
+    // Release INTn before closing so nothing fires once LwipIntfDev detached the pin
+    setSIMR(0);
+
     setSn_CR(Sn_CR_CLOSE);
 
     // clear all interrupt of the socket
@@ -209,6 +209,56 @@ static void wiznet_pio_spi_frame_end(void) {
 #endif
 }
 
+// Clock out hdr (if any) followed by tx as a single PIO run.  The header goes through
+// dma_in, which is idle when only writing, and chains straight into dma_out for the
+// data so there is no CPU involvement or gap on the bus between the two.
+static void wiznet_pio_spi_write_chained(const wiznet_pio_spi_state_t *state, const uint8_t *hdr, size_t hdr_length, const uint8_t *tx, size_t tx_length) {
+    size_t total = hdr_length + tx_length;
+
+    pio_sm_set_enabled(state->pio, state->pio_sm, false);
+    pio_sm_set_wrap(state->pio, state->pio_sm, state->pio_offset + WIZNET_PIO_SPI_OFFSET_WRITE_BITS, state->pio_offset + WIZNET_PIO_SPI_OFFSET_WRITE_END - 1);
+    pio_sm_clear_fifos(state->pio, state->pio_sm);
+    pio_sm_restart(state->pio, state->pio_sm);
+    pio_sm_clkdiv_restart(state->pio, state->pio_sm);
+    pio_sm_put(state->pio, state->pio_sm, total * 8 - 1);
+    pio_sm_exec(state->pio, state->pio_sm, pio_encode_out(pio_x, 32));
+    pio_sm_put(state->pio, state->pio_sm, total - 1);
+    pio_sm_exec(state->pio, state->pio_sm, pio_encode_out(pio_y, 32));
+    pio_sm_exec(state->pio, state->pio_sm, pio_encode_set(pio_pins, 0));
+    pio_sm_set_consecutive_pindirs(state->pio, state->pio_sm, state->spi_config->data_out_pin, 1, true);
+    pio_sm_exec(state->pio, state->pio_sm, pio_encode_jmp(state->pio_offset + WIZNET_PIO_SPI_OFFSET_WRITE_BITS));
+    dma_channel_abort(state->dma_out);
+    dma_channel_abort(state->dma_in);
+
+    dma_channel_config out_config = dma_channel_get_default_config(state->dma_out);
+    channel_config_set_dreq(&out_config, pio_get_dreq(state->pio, state->pio_sm, true));
+    channel_config_set_transfer_data_size(&out_config, DMA_SIZE_8);
+    dma_channel_configure(state->dma_out, &out_config, &state->pio->txf[state->pio_sm], tx, tx_length, !hdr_length);
+
+    if (hdr_length) {
+        dma_channel_config hdr_config = dma_channel_get_default_config(state->dma_in);
+        channel_config_set_dreq(&hdr_config, pio_get_dreq(state->pio, state->pio_sm, true));
+        channel_config_set_transfer_data_size(&hdr_config, DMA_SIZE_8);
+        channel_config_set_chain_to(&hdr_config, state->dma_out);
+        dma_channel_configure(state->dma_in, &hdr_config, &state->pio->txf[state->pio_sm], hdr, hdr_length, true);
+    }
+
+    pio_sm_set_enabled(state->pio, state->pio_sm, true);
+    // The data channel may not have been triggered yet so its busy flag alone can't be
+    // trusted.  Once it has read everything and gone idle an empty FIFO is the real end.
+    while ((dma_hw->ch[state->dma_out].read_addr != (uintptr_t)(tx + tx_length)) || dma_channel_is_busy(state->dma_out)) {
+        tight_loop_contents();
+    }
+    const uint32_t fDebugTxStall = 1u << (PIO_FDEBUG_TXSTALL_LSB + state->pio_sm);
+    state->pio->fdebug = fDebugTxStall;
+    while (!(state->pio->fdebug & fDebugTxStall)) {
+        tight_loop_contents(); // todo timeout
+    }
+    __compiler_memory_barrier();
+    pio_sm_set_enabled(state->pio, state->pio_sm, false);
+    pio_sm_set_consecutive_pindirs(state->pio, state->pio_sm, state->spi_config->data_in_pin, 1, false);
+}
+
 // send tx then receive rx
 // rx can be null if you just want to send, but tx and tx_length must be valid
 bool wiznet_pio_spi_transfer(const uint8_t *tx, size_t tx_length, uint8_t *rx, size_t rx_length) {
@@ -255,36 +305,7 @@ bool wiznet_pio_spi_transfer(const uint8_t *tx, size_t tx_length, uint8_t *rx, s
         __compiler_memory_barrier();
     } else if (tx != NULL) {
         assert(tx_length);
-
-        pio_sm_set_enabled(state->pio, state->pio_sm, false);
-        pio_sm_set_wrap(state->pio, state->pio_sm, state->pio_offset + WIZNET_PIO_SPI_OFFSET_WRITE_BITS, state->pio_offset + WIZNET_PIO_SPI_OFFSET_WRITE_END - 1);
-        pio_sm_clear_fifos(state->pio, state->pio_sm);
-        pio_sm_restart(state->pio, state->pio_sm);
-        pio_sm_clkdiv_restart(state->pio, state->pio_sm);
-        pio_sm_put(state->pio, state->pio_sm, tx_length * 8 - 1);
-        pio_sm_exec(state->pio, state->pio_sm, pio_encode_out(pio_x, 32));
-        pio_sm_put(state->pio, state->pio_sm, tx_length - 1);
-        pio_sm_exec(state->pio, state->pio_sm, pio_encode_out(pio_y, 32));
-        pio_sm_exec(state->pio, state->pio_sm, pio_encode_set(pio_pins, 0));
-        pio_sm_set_consecutive_pindirs(state->pio, state->pio_sm, state->spi_config->data_out_pin, 1, true);
-        pio_sm_exec(state->pio, state->pio_sm, pio_encode_jmp(state->pio_offset + WIZNET_PIO_SPI_OFFSET_WRITE_BITS));
-        dma_channel_abort(state->dma_out);
-
-        dma_channel_config out_config = dma_channel_get_default_config(state->dma_out);
-        channel_config_set_dreq(&out_config, pio_get_dreq(state->pio, state->pio_sm, true));
-
-        channel_config_set_transfer_data_size(&out_config, DMA_SIZE_8);
-        dma_channel_configure(state->dma_out, &out_config, &state->pio->txf[state->pio_sm], tx, tx_length, true);
-
-        const uint32_t fDebugTxStall = 1u << (PIO_FDEBUG_TXSTALL_LSB + state->pio_sm);
-        state->pio->fdebug = fDebugTxStall;
-        pio_sm_set_enabled(state->pio, state->pio_sm, true);
-        while (!(state->pio->fdebug & fDebugTxStall)) {
-            tight_loop_contents(); // todo timeout
-        }
-        __compiler_memory_barrier();
-        pio_sm_set_enabled(state->pio, state->pio_sm, false);
-        pio_sm_set_consecutive_pindirs(state->pio, state->pio_sm, state->spi_config->data_in_pin, 1, false);
+        wiznet_pio_spi_write_chained(state, NULL, 0, tx, tx_length);
     } else if (rx != NULL) {
         panic_unsupported(); // shouldn't be used
     }
@@ -332,18 +353,24 @@ void wiznet_pio_spi_write_buffer(const uint8_t* pBuf, uint16_t len) {
         active_state->spi_header_count = WIZNET_PIO_SPI_HEADER_LEN;
     } else {
         if (active_state->spi_header_count == WIZNET_PIO_SPI_HEADER_LEN) {
-            if (!wiznet_pio_spi_transfer(active_state->spi_header, WIZNET_PIO_SPI_HEADER_LEN, NULL, 0)) {
-                panic("spi failed writing header");
-            }
+            // Header and data go out back to back in one DMA chain
+            wiznet_pio_spi_write_chained(active_state, active_state->spi_header, WIZNET_PIO_SPI_HEADER_LEN, pBuf, len);
+            pio_sm_exec(active_state->pio, active_state->pio_sm, pio_encode_mov(pio_pins, pio_null));
             active_state->spi_header_count = 0;
+            return;
         }
-        assert(active_state->spi_header_count == 0);
         if (!wiznet_pio_spi_transfer(pBuf, len, NULL, 0)) {
             panic("spi failed writing buffer");
         }
     }
 }
 
+// Change the PIO clock divider of an open handle, the SPI clock is clk_sys / (2 * div)
+void wiznet_pio_spi_set_clkdiv(wiznet_pio_spi_handle_t handle, uint16_t clock_div_major, uint8_t clock_div_minor) {
+    wiznet_pio_spi_state_t *state = (wiznet_pio_spi_state_t *)handle;
+    pio_sm_set_clkdiv_int_frac(state->pio, state->pio_sm, clock_div_major, clock_div_minor);
+}
+
 static void wiznet_pio_spi_set_active(wiznet_pio_spi_handle_t handle) {
     active_state = (wiznet_pio_spi_state_t *)handle;
 }
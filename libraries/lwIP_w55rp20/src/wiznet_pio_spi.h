@@ -44,6 +44,7 @@ void wiznet_pio_spi_close(wiznet_pio_spi_handle_t handle);
 bool wiznet_pio_spi_transfer(const uint8_t *tx, size_t tx_length, uint8_t *rx, size_t rx_length);
 void wiznet_pio_spi_read_buffer(uint8_t* pBuf, uint16_t len);
 void wiznet_pio_spi_write_buffer(const uint8_t* pBuf, uint16_t len);
+void wiznet_pio_spi_set_clkdiv(wiznet_pio_spi_handle_t handle, uint16_t clock_div_major, uint8_t clock_div_minor);
 
 #ifdef __cplusplus
 }
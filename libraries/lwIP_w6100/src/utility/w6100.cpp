@@ -316,6 +316,9 @@ bool Wiznet6100::begin(const uint8_t* mac_address, netif *net) {
         return false;
     }
 
+    _txWaiting = 0;
+    _txBusy = false;
+
     Serial.println("MAC RAW mode!");
 
     if (_intr >= 0) {
@@ -342,6 +345,9 @@ bool Wiznet6100::begin(const uint8_t* mac_address, netif *net) {
 }
 
 void Wiznet6100::end() {
+    // Release INTn before closing so nothing fires once LwipIntfDev detached the pin
+    setSIMR(0);
+
     setSn_CR(Sn_CR_CLOSE);
 
     // clear all interrupt of the socket
@@ -408,6 +414,87 @@ uint16_t Wiznet6100::readFrameData(uint8_t* buffer, uint16_t framesize) {
     return framesize;
 }
 
+void Wiznet6100::readFrameStart(struct pbuf *p, uint16_t framesize) {
+    uint16_t ptr = getSn_RX_RD();
+    _rxFrame = p;
+    _rxPtr = ptr + framesize;
+
+    // Same as wizchip_read_buf(), but the data is read into the pbufs
+    wizchip_cs_select();
+    wizchip_spi_write_byte((ptr & 0xFF00) >> 8);
+    wizchip_spi_write_byte((ptr & 0x00FF) >> 0);
+    wizchip_spi_write_byte(BlockSelectRxBuf | AccessModeRead);
+    _rxDMA = __ethernetReadPbufStart(_spi, p);
+}
+
+void Wiznet6100::readFrameFinish() {
+    __ethernetReadPbufFinish(_spi, _rxFrame, _rxDMA);
+    wizchip_cs_deselect();
+    _rxFrame = nullptr;
+
+    setSn_RX_RD(_rxPtr);
+    setSn_CR(Sn_CR_RECV);
+}
+
+int Wiznet6100::sendFrameQueue(struct pbuf *p) {
+    ethernet_arch_lwip_gpio_mask(); // So we don't fire an IRQ and interrupt the send w/a receive!
+
+    if (getSn_SR() == SOCK_CLOSED) {
+        ethernet_arch_lwip_gpio_unmask();
+        return -1;
+    }
+    sendFrameFlush();
+    if (!_txBusy && !_txWaiting) {
+        _txWr = _txPtr = getSn_TX_WR();
+    }
+    // Sn_TX_FSR doesn't know about the frames waiting past Sn_TX_WR
+    if ((_txWaiting == TX_WAITING) || (p->tot_len > getSn_TX_FSR() - (uint16_t)(_txPtr - _txWr))) {
+        ethernet_arch_lwip_gpio_unmask();
+        return 0;
+    }
+
+    // Same as wizchip_write_buf(), but from every pbuf in the chain
+    wizchip_cs_select();
+    wizchip_spi_write_byte((_txPtr & 0xFF00) >> 8);
+    wizchip_spi_write_byte((_txPtr & 0x00FF) >> 0);
+    wizchip_spi_write_byte(BlockSelectTxBuf | AccessModeWrite);
+    __ethernetWritePbuf(_spi, p);
+    wizchip_cs_deselect();
+
+    _txPtr += p->tot_len;
+    _txEnd[_txWaiting++] = _txPtr;
+    sendFrameFlush();
+
+    ethernet_arch_lwip_gpio_unmask();
+    return p->tot_len;
+}
+
+bool Wiznet6100::sendFrameFlush() {
+    ethernet_arch_lwip_gpio_mask();
+
+    if (_txBusy) {
+        uint8_t tmp = getSn_IR() & (Sn_IR_SENDOK | Sn_IR_TIMEOUT);
+        if (!tmp) {
+            // Still sending
+            ethernet_arch_lwip_gpio_unmask();
+            return _txWaiting > 0;
+        }
+        setSn_IR(tmp);
+        _txBusy = false;
+    }
+    if (_txWaiting) {
+        // MACRAW sends everything between Sn_TX_RD and Sn_TX_WR as one frame
+        _txWr = _txEnd[0];
+        memmove(_txEnd, _txEnd + 1, --_txWaiting * sizeof(_txEnd[0]));
+        setSn_TX_WR(_txWr);
+        setSn_CR(Sn_CR_SEND);
+        _txBusy = true;
+    }
+
+    ethernet_arch_lwip_gpio_unmask();
+    return _txWaiting > 0;
+}
+
 uint16_t Wiznet6100::sendFrame(struct pbuf *p) {
     ethernet_arch_lwip_gpio_mask(); // So we don't fire an IRQ and interrupt the send w/a receive!
 
@@ -127,6 +127,36 @@ protected:
     */
     uint16_t readFrameData(uint8_t* frame, uint16_t framesize);
 
+    /**
+        Start reading an Ethernet frame data into a pbuf chain, with DMA if possible
+           readFrameSize() must be called first,
+           its result must be passed into framesize parameter,
+           and nothing else may use the SPI bus until readFrameFinish()
+        @param p a pbuf chain of framesize bytes
+        @param framesize readFrameSize()'s result
+    */
+    void readFrameStart(struct pbuf *p, uint16_t framesize);
+
+    /**
+        Wait for the frame data readFrameStart() is reading and release the frame
+    */
+    void readFrameFinish();
+
+    /**
+        Write an Ethernet frame into the transmit buffer behind any frames waiting
+        there and send it right away if the chip isn't still sending an earlier one
+        @param p pointer to the (possibly chained) pbuf to send, may be freed on return
+        @return the frame length, 0 if the transmit buffer has no room for it yet,
+               or -1 if it can't be sent
+    */
+    int sendFrameQueue(struct pbuf *p);
+
+    /**
+        Send the next frame sendFrameQueue() left in the transmit buffer, if the previous one is out
+        @return true while frames are still waiting in the transmit buffer
+    */
+    bool sendFrameFlush();
+
 private:
     //< SPI interface Read operation in Control Phase
     static const uint8_t AccessModeRead = (0x00 << 2);
@@ -156,6 +186,19 @@ private:
     int8_t    _intr;
     uint8_t   _mac_address[6];
 
+    /* readFrameStart() state */
+    struct pbuf *_rxFrame = nullptr;
+    uint16_t _rxPtr = 0;
+    bool _rxDMA = false;
+
+    /* sendFrameQueue() state, frames written past Sn_TX_WR wait for the SEND in progress */
+    static const int TX_WAITING = 8;
+    uint16_t _txEnd[TX_WAITING];
+    int _txWaiting = 0;
+    uint16_t _txWr = 0;
+    uint16_t _txPtr = 0;
+    bool _txBusy = false;
+
     /**
         Default function to select chip.
         @note This function help not to access wrong address. If you do not describe this function
@@ -36,6 +36,7 @@
 #include "wiznet_pio_qspi.h"
 #include "w6300.h"
 #include <LwipEthernet.h>
+#include <WiznetPioClock.h>
 
 #define _W6300_SPI_READ_            (0x00 << 5)        ///< SPI interface Read operation in Control Phase
 #define _W6300_SPI_WRITE_           (0x01 << 5)        ///< SPI interface Write operation in Control Phase
@@ -271,6 +272,42 @@ int8_t Wiznet6300::wizphy_setphypmode(uint8_t pmode) {
     return -1;
 }
 
+// begin() can try faster PIO clocks than the stock divider, checking each by writing
+// and reading back test patterns.  A single passing test doesn't prove a clock has
+// margin for temperature and load changes, so this is opt-in.
+#ifndef WIZNET_PIO_QSPI_AUTOTUNE
+#define WIZNET_PIO_QSPI_AUTOTUNE 0
+#endif
+// Fastest SCK autotuning may pick.  The default is deliberately conservative, raise it only
+// as far as the W6300 datasheet and your board allow.
+#ifndef WIZNET_PIO_QSPI_MAX_HZ
+#define WIZNET_PIO_QSPI_MAX_HZ 33333333
+#endif
+
+// The test and search are shared with the other PIO Wiznet driver, see WiznetPioClock.h
+bool Wiznet6300::checkBus() {
+    return wiznetPioCheckBus([this](const uint8_t *out, uint16_t len) {
+        wizchip_write_buf(BlockSelectTxBuf, 0, out, len);
+    }, [this](uint8_t *in, uint16_t len) {
+        wizchip_read_buf(BlockSelectTxBuf, 0, in, len);
+    });
+}
+
+bool Wiznet6300::tuneClock() {
+    if (!WIZNET_PIO_QSPI_AUTOTUNE) {
+        return false;
+    }
+    WiznetPioClockDiv div;
+    bool failed = wiznetPioTuneClock(WIZNET_PIO_QSPI_MAX_HZ, [this]() {
+        return checkBus();
+    }, [](uint16_t major, uint8_t minor) {
+        wiznet_pio_qspi_set_clkdiv(wiznet_pio_qspi_handle, major, minor);
+    }, div);
+    wiznet_pio_qspi_config.clock_div_major = div.major;
+    wiznet_pio_qspi_config.clock_div_minor = div.minor;
+    return failed;
+}
+
 Wiznet6300::Wiznet6300(int8_t cs, SPIClass& spi, int8_t intr) : _spi(spi), _cs(cs), _intr(intr) {
 }
 
@@ -297,6 +334,11 @@ bool Wiznet6300::begin(const uint8_t* mac_address, netif *net) {
     wizchip_cs_deselect();
 
     wizchip_sw_reset();
+    // Speed up the bus as far as the board allows, resetting again afterwards in case a
+    // failed attempt wrote garbage to the registers
+    if (tuneClock()) {
+        wizchip_sw_reset();
+    }
 
     // Unlock
     setChipLOCK(CHPLCKR_UNLOCK);
@@ -355,6 +397,9 @@ bool Wiznet6300::begin(const uint8_t* mac_address, netif *net) {
 }
 
 void Wiznet6300::end() {
+    // Release INTn before closing so nothing fires once LwipIntfDev detached the pin
+    setSIMR(0);
+
     setSn_CR(Sn_CR_CLOSE);
 
     // clear all interrupt of the socket
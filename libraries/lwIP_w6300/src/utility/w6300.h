@@ -163,6 +163,18 @@ private:
     int8_t    _intr;
     uint8_t   _mac_address[6];
 
+    /**
+        Pick the fastest PIO clock divider that still moves data reliably
+        @return true if any divider failed, so the registers may hold garbage
+    */
+    bool tuneClock();
+
+    /**
+        Write test patterns to the socket 0 TX buffer and read them back
+        @return true if everything read back unchanged
+    */
+    bool checkBus();
+
     /**
         Default function to select chip.
         @note This function help not to access wrong address. If you do not describe this function
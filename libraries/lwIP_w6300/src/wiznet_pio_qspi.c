@@ -339,19 +339,29 @@ void wiznet_pio_qspi_write_byte(uint8_t op_code, uint16_t AddrSel, uint8_t *tx,
     pio_sm_exec(active_state->pio, active_state->pio_sm, pio_encode_out(pio_y, 32));
     pio_sm_exec(active_state->pio, active_state->pio_sm, pio_encode_jmp(active_state->pio_offset));
     dma_channel_abort(active_state->dma_out);
+    dma_channel_abort(active_state->dma_in);
 
-
+    // The data goes out on dma_out, triggered by the command phase on the otherwise idle
+    // dma_in finishing, so the whole write runs without the CPU stepping in between
     dma_channel_config out_config = dma_channel_get_default_config(active_state->dma_out);
     channel_config_set_transfer_data_size(&out_config, DMA_SIZE_8);
     channel_config_set_bswap(&out_config, true);
     channel_config_set_dreq(&out_config, pio_get_dreq(active_state->pio, active_state->pio_sm, true));
+    dma_channel_configure(active_state->dma_out, &out_config, &active_state->pio->txf[active_state->pio_sm], tx, tx_length - command_len, false);
+
+    dma_channel_config cmd_config = dma_channel_get_default_config(active_state->dma_in);
+    channel_config_set_transfer_data_size(&cmd_config, DMA_SIZE_8);
+    channel_config_set_bswap(&cmd_config, true);
+    channel_config_set_dreq(&cmd_config, pio_get_dreq(active_state->pio, active_state->pio_sm, true));
+    channel_config_set_chain_to(&cmd_config, active_state->dma_out);
 
     pio_sm_set_enabled(active_state->pio, active_state->pio_sm, true);
 
-    dma_channel_configure(active_state->dma_out, &out_config, &active_state->pio->txf[active_state->pio_sm], command_buf, command_len, true);
-    dma_channel_wait_for_finish_blocking(active_state->dma_out);
-    dma_channel_configure(active_state->dma_out, &out_config, &active_state->pio->txf[active_state->pio_sm], tx, tx_length - command_len, true);
-    dma_channel_wait_for_finish_blocking(active_state->dma_out);
+    dma_channel_configure(active_state->dma_in, &cmd_config, &active_state->pio->txf[active_state->pio_sm], command_buf, command_len, true);
+    // dma_out isn't busy until the command is done, so wait for it to have read everything
+    while ((dma_hw->ch[active_state->dma_out].read_addr != (uintptr_t)(tx + tx_length - command_len)) || dma_channel_is_busy(active_state->dma_out)) {
+        tight_loop_contents();
+    }
 
     const uint32_t fdebug_tx_stall = 1u << (PIO_FDEBUG_TXSTALL_LSB + active_state->pio_sm);
     active_state->pio->fdebug = fdebug_tx_stall;
@@ -366,6 +376,12 @@ void wiznet_pio_qspi_write_byte(uint8_t op_code, uint16_t AddrSel, uint8_t *tx,
     pio_sm_set_enabled(active_state->pio, active_state->pio_sm, false);
 }
 
+// Change the PIO clock divider of an open handle, the QSPI clock is clk_sys / (2 * div)
+void wiznet_pio_qspi_set_clkdiv(wiznet_pio_qspi_handle_t handle, uint16_t clock_div_major, uint8_t clock_div_minor) {
+    wiznet_pio_qspi_state_t *state = (wiznet_pio_qspi_state_t *)handle;
+    pio_sm_set_clkdiv_int_frac(state->pio, state->pio_sm, clock_div_major, clock_div_minor);
+}
+
 static void wiznet_pio_qspi_set_active(wiznet_pio_qspi_handle_t handle) {
     active_state = (wiznet_pio_qspi_state_t *)handle;
 }
@@ -45,6 +45,7 @@ wiznet_pio_qspi_handle_t wiznet_pio_qspi_open(const wiznet_pio_qspi_config_t *qs
 void wiznet_pio_qspi_close(wiznet_pio_qspi_handle_t handle);
 void wiznet_pio_qspi_frame_start(void);
 void wiznet_pio_qspi_frame_end(void);
+void wiznet_pio_qspi_set_clkdiv(wiznet_pio_qspi_handle_t handle, uint16_t clock_div_major, uint8_t clock_div_minor);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,87 @@
+// Shows how the asynchronous DMA memcpy lets the CPU work while data moves
+// Released to the public domain by Earle F. Philhower, III, 2026
+
+#include <AsyncMemcpy.h>
+
+uint8_t src[8192];
+uint8_t dest[8192];
+volatile int callbacks = 0;
+
+void done(void *param) {
+  (void) param;
+  callbacks++;
+}
+
+void verify(const char *name, const uint8_t *a, const uint8_t *b, size_t len) {
+  if (memcmp(a, b, len)) {
+    Serial.printf("ERROR, mismatch on %s\n", name);
+    while (true) {
+      // Idle forever, this is fatal!
+    }
+  }
+}
+
+void setup() {
+  for (size_t i = 0; i < sizeof(src); i++) {
+    src[i] = i * 7 + (i >> 8);
+  }
+}
+
+void loop() {
+  uint64_t start, stop;
+  uint32_t busy;
+
+  // Blocking DMA copy, the CPU just waits
+  start = rp2040.getCycleCount64();
+  rp2040.memcpyDMA(dest, src, sizeof(src));
+  stop = rp2040.getCycleCount64();
+  verify("memcpyDMA", dest, src, sizeof(src));
+  Serial.printf("memcpyDMA: %lld cycles\n", stop - start);
+
+  // Asynchronous copy, count how much the CPU can do in the meantime
+  memset(dest, 0, sizeof(dest));
+  busy = 0;
+  start = rp2040.getCycleCount64();
+  uint32_t id = asyncMemcpy.copy(dest, src, sizeof(src));
+  while (!asyncMemcpy.done(id)) {
+    busy++;
+  }
+  stop = rp2040.getCycleCount64();
+  verify("async copy", dest, src, sizeof(src));
+  Serial.printf("async copy: %lld cycles, %lu loops of CPU work done meanwhile\n", stop - start, busy);
+
+  // Misaligned copies are still handled by DMA
+  memset(dest, 0, sizeof(dest));
+  id = asyncMemcpy.copy(dest + 1, src + 3, 5000);
+  asyncMemcpy.wait(id);
+  verify("misaligned copy", dest + 1, src + 3, 5000);
+
+  // Fill, with a completion callback
+  int before = callbacks;
+  id = asyncMemcpy.fill(dest, 0xa5, sizeof(dest), done);
+  asyncMemcpy.wait(id);
+  for (size_t i = 0; i < sizeof(dest); i++) {
+    if (dest[i] != 0xa5) {
+      Serial.printf("ERROR, fill mismatch @ %d\n", i);
+      while (true) {
+        // Idle forever, this is fatal!
+      }
+    }
+  }
+  Serial.printf("fill callback ran: %s\n", callbacks != before ? "yes" : "no");
+
+  // Scatter-gather, reverse the order of 4 x 2K chunks in one request
+  AsyncMemcpy::sg_t sg[4];
+  for (int i = 0; i < 4; i++) {
+    sg[i].dest = dest + i * 2048;
+    sg[i].src = src + (3 - i) * 2048;
+    sg[i].len = 2048;
+  }
+  id = asyncMemcpy.copy(sg, 4);
+  asyncMemcpy.wait(id);
+  for (int i = 0; i < 4; i++) {
+    verify("scatter-gather", dest + i * 2048, src + (3 - i) * 2048, 2048);
+  }
+  Serial.printf("All tests passed\n\n");
+  delay(1000);
+}
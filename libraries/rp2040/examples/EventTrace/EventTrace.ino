@@ -0,0 +1,40 @@
+// Records application and core events and dumps them for tools/tracedecode.py
+// Build with Tools->Profiling->Event Trace, capture the serial output to a
+// file, then run "python3 tools/tracedecode.py -i capture.log -o trace.json"
+// and open trace.json in https://ui.perfetto.dev
+// Released to the public domain by Earle F. Philhower, III, 2026
+
+#include <CoreMutex.h>
+
+auto_init_mutex(shared);
+volatile uint32_t counter = 0;
+
+void work(int loops) {
+  for (int i = 0; i < loops; i++) {
+    CoreMutex m(&shared);
+    counter++;
+    delayMicroseconds(20);
+  }
+}
+
+void setup() {
+  Serial1.begin(115200);
+}
+
+void loop() {
+  TRACE_EVENT(TRACE_USER + 0, counter);
+  work(100);
+  Serial1.println("Some UART traffic to generate IRQs");
+  TRACE_EVENT(TRACE_USER + 1, counter);
+  delay(1000);
+  traceDump(Serial);
+}
+
+// The second core fights for the same mutex so waits show up in the trace
+void setup1() {
+}
+
+void loop1() {
+  work(50);
+  delay(3);
+}
@@ -0,0 +1,89 @@
+// Simple throughput comparison of single-element vs. bulk LocklessQueue operations
+// Released to the public domain by Earle F. Philhower, III, 2026
+
+#include <LocklessQueue.h>
+
+LocklessQueue<uint8_t> pow2(1024);   // Power-of-2 size, uses masking to wrap
+LocklessQueue<uint8_t> odd(1025);    // Odd size, uses compare-and-subtract to wrap
+
+uint8_t src[256];
+uint8_t dest[256];
+
+void setup() {
+  for (size_t i = 0; i < sizeof(src); i++) {
+    src[i] = i;
+  }
+}
+
+void verify(const char *name) {
+  for (size_t i = 0; i < sizeof(dest); i++) {
+    if (dest[i] != (uint8_t)i) {
+      Serial.printf("ERROR, mismatch @ %d on %s\n", (int)i, name);
+      while (true) {
+        // Idle forever, this is fatal!
+      }
+    }
+  }
+}
+
+void single(const char *name, LocklessQueue<uint8_t> &q) {
+  uint32_t start = rp2040.getCycleCount();
+  for (int j = 0; j < 100; j++) {
+    for (size_t i = 0; i < sizeof(src); i++) {
+      q.write(src[i]);
+    }
+    for (size_t i = 0; i < sizeof(dest); i++) {
+      q.read(&dest[i]);
+    }
+  }
+  uint32_t stop = rp2040.getCycleCount();
+  verify(name);
+  Serial.printf("%-22s: %lu cycles per 100 bytes\n", name, (stop - start) / sizeof(src));
+}
+
+void bulk(const char *name, LocklessQueue<uint8_t> &q) {
+  uint32_t start = rp2040.getCycleCount();
+  for (int j = 0; j < 100; j++) {
+    q.write(src, sizeof(src));
+    q.read(dest, sizeof(dest));
+  }
+  uint32_t stop = rp2040.getCycleCount();
+  verify(name);
+  Serial.printf("%-22s: %lu cycles per 100 bytes\n", name, (stop - start) / sizeof(src));
+}
+
+void span(const char *name, LocklessQueue<uint8_t> &q) {
+  uint32_t start = rp2040.getCycleCount();
+  for (int j = 0; j < 100; j++) {
+    size_t cnt = 0;
+    while (cnt < sizeof(src)) {
+      uint8_t *p;
+      size_t len = std::min(q.reserve(&p), sizeof(src) - cnt);
+      memcpy(p, src + cnt, len);
+      q.commit(len);
+      cnt += len;
+    }
+    cnt = 0;
+    while (cnt < sizeof(dest)) {
+      const uint8_t *p;
+      size_t len = std::min(q.peek(&p), sizeof(dest) - cnt);
+      memcpy(dest + cnt, p, len);
+      q.consume(len);
+      cnt += len;
+    }
+  }
+  uint32_t stop = rp2040.getCycleCount();
+  verify(name);
+  Serial.printf("%-22s: %lu cycles per 100 bytes\n", name, (stop - start) / sizeof(src));
+}
+
+void loop() {
+  single("Single, power-of-2", pow2);
+  single("Single, odd size", odd);
+  bulk("Bulk, power-of-2", pow2);
+  bulk("Bulk, odd size", odd);
+  span("Span, power-of-2", pow2);
+  span("Span, odd size", odd);
+  Serial.println();
+  delay(1000);
+}
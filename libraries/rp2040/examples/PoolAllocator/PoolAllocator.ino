@@ -0,0 +1,95 @@
+// Compares allocation latency of the normal heap and a fixed-block pool,
+// including from inside an IRQ, and shows the pool never fragments.
+// Released to the public domain by Earle F. Philhower, III, 2026
+
+#include <PoolAllocator.h>
+#include <list>
+#include <pico/time.h>
+
+typedef struct {
+  uint8_t data[96];
+} Packet;
+
+PoolAllocator<Packet, 32> packets;
+std::list<int, PoolStdAllocator<int, 32, 64>> pooledList;
+
+volatile uint32_t irqWorst = 0;
+volatile uint32_t irqFails = 0;
+
+bool timerCB(repeating_timer_t *t) {
+  (void) t;
+  uint32_t start = rp2040.getCycleCount();
+  Packet *p = packets.allocate();
+  uint32_t stop = rp2040.getCycleCount();
+  if (p) {
+    packets.deallocate(p);
+  } else {
+    irqFails++;
+  }
+  if (stop - start > irqWorst) {
+    irqWorst = stop - start;
+  }
+  return true;
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(5000);
+  static repeating_timer_t timer;
+  add_repeating_timer_us(-250, timerCB, nullptr, &timer);
+}
+
+void loop() {
+  void *m[32];
+  Packet *p[32];
+  uint32_t worstHeap = 0, worstPool = 0;
+  uint64_t totalHeap = 0, totalPool = 0;
+
+  for (int pass = 0; pass < 100; pass++) {
+    // Allocate a random mix of sizes from the heap and only free half
+    // to make it fragment, then time a fixed size allocation on top
+    for (int i = 0; i < 32; i++) {
+      m[i] = malloc(16 + random(200));
+    }
+    for (int i = 0; i < 32; i += 2) {
+      free(m[i]);
+    }
+    uint32_t start = rp2040.getCycleCount();
+    void *x = malloc(sizeof(Packet));
+    uint32_t stop = rp2040.getCycleCount();
+    free(x);
+    for (int i = 1; i < 32; i += 2) {
+      free(m[i]);
+    }
+    worstHeap = std::max(worstHeap, stop - start);
+    totalHeap += stop - start;
+
+    for (int i = 0; i < 31; i++) {
+      p[i] = packets.allocate();
+    }
+    for (int i = 0; i < 31; i += 2) {
+      packets.deallocate(p[i]);
+    }
+    start = rp2040.getCycleCount();
+    Packet *y = packets.allocate();
+    stop = rp2040.getCycleCount();
+    packets.deallocate(y);
+    for (int i = 1; i < 31; i += 2) {
+      packets.deallocate(p[i]);
+    }
+    worstPool = std::max(worstPool, stop - start);
+    totalPool += stop - start;
+  }
+
+  Serial.printf("malloc: avg %lu, worst %lu cycles\n", (uint32_t)(totalHeap / 100), worstHeap);
+  Serial.printf("pool:   avg %lu, worst %lu cycles\n", (uint32_t)(totalPool / 100), worstPool);
+  Serial.printf("pool from IRQ: worst %lu cycles, %lu failures\n", irqWorst, irqFails);
+
+  // Node containers can share a pool with the std::allocator adaptor
+  for (int i = 0; i < 50; i++) {
+    pooledList.push_back(i);
+  }
+  Serial.printf("list pool free blocks: %d\n\n", pooledList.get_allocator().pool().available());
+  pooledList.clear();
+  delay(1000);
+}
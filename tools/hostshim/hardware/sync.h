@@ -0,0 +1,22 @@
+// Host stand-ins for the pico-sdk sync intrinsics used by core headers, so they
+// can be built into the tools/ test programs.  There are no interrupts to mask on
+// a PC, and WFE/SEV become a yield so blocked threads let the others run.
+
+#pragma once
+
+#include <stdint.h>
+#include <thread>
+
+static inline uint32_t save_and_disable_interrupts() {
+    return 0;
+}
+
+static inline void restore_interrupts(uint32_t) {
+}
+
+static inline void __wfe() {
+    std::this_thread::yield();
+}
+
+static inline void __sev() {
+}
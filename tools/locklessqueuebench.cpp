@@ -0,0 +1,131 @@
+// Host-side check and benchmark for the serial port software FIFO
+// (cores/rp2040/LocklessQueue.h).  Build from the top directory with:
+//
+//   g++ -O2 -g -pthread -Icores/rp2040 -o locklessqueuebench tools/locklessqueuebench.cpp
+//
+// (add -fsanitize=address,undefined when changing the queue) and run:
+//
+//   ./locklessqueuebench [megabytes]
+//
+// A writer thread streams a counting byte pattern through the queue to a reader
+// thread, once per element with write()/read(), once with the bulk write(src, n)/
+// read(dst, n) calls, and once with reserve()/commit() and peek()/consume().  The
+// reader checks every byte, and each mode runs on a power-of-2 and an odd sized
+// queue to cover both ways of wrapping the indices.
+//
+// The queue only uses compiler barriers, which matches the Cortex-M cores and
+// x86 hosts.  On a weakly ordered host CPU (e.g. ARM64) the cross-thread run
+// is not meaningful.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include "LocklessQueue.h"
+
+enum Mode { SINGLE, BULK, SPAN };
+static const char *modeName[] = { "single", "bulk", "reserve/peek" };
+
+// Write sizes vary like UART FIFO drains do, up to the 32 byte HW FIFO
+static size_t chunkLen(size_t i) {
+    return 1 + (i * 7) % 32;
+}
+
+static void writer(LocklessQueue<uint8_t> &q, Mode mode, size_t total) {
+    uint8_t buf[32];
+    size_t sent = 0;
+    for (size_t i = 0; sent < total; i++) {
+        size_t len = std::min(chunkLen(i), total - sent);
+        for (size_t j = 0; j < len; j++) {
+            buf[j] = (uint8_t)(sent + j);
+        }
+        size_t done = 0;
+        while (done < len) {
+            size_t before = done;
+            switch (mode) {
+            case SINGLE:
+                done += q.write(buf[done]) ? 1 : 0;
+                break;
+            case BULK:
+                done += q.write(buf + done, len - done);
+                break;
+            case SPAN: {
+                uint8_t *dst;
+                size_t room = std::min(q.reserve(&dst), len - done);
+                memcpy(dst, buf + done, room);
+                q.commit(room);
+                done += room;
+                break;
+            }
+            }
+            if (done == before) {
+                std::this_thread::yield(); // Full, let the reader run
+            }
+        }
+        sent += len;
+    }
+}
+
+// Returns the number of mismatched bytes
+static size_t reader(LocklessQueue<uint8_t> &q, Mode mode, size_t total) {
+    uint8_t buf[64];
+    size_t got = 0;
+    size_t bad = 0;
+    while (got < total) {
+        size_t len = 0;
+        switch (mode) {
+        case SINGLE:
+            while (len < sizeof(buf) && q.read(&buf[len])) {
+                len++;
+            }
+            break;
+        case BULK:
+            len = q.read(buf, sizeof(buf));
+            break;
+        case SPAN: {
+            const uint8_t *src;
+            len = std::min(q.peek(&src), sizeof(buf));
+            memcpy(buf, src, len);
+            q.consume(len);
+            break;
+        }
+        }
+        if (!len) {
+            std::this_thread::yield(); // Empty, let the writer run
+        }
+        for (size_t j = 0; j < len; j++) {
+            bad += buf[j] != (uint8_t)(got + j);
+        }
+        got += len;
+    }
+    return bad;
+}
+
+static bool run(Mode mode, size_t qsize, size_t total) {
+    LocklessQueue<uint8_t> q(qsize);
+    size_t bad = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::thread w(writer, std::ref(q), mode, total);
+    std::thread r([&]() {
+        bad = reader(q, mode, total);
+    });
+    w.join();
+    r.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    bool ok = !bad && q.empty();
+    printf("%-13s %5zu byte queue: %7.1f MB/s %s\n", modeName[mode], qsize, total / secs / 1e6, ok ? "" : "FAILED");
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    size_t total = ((argc > 1) ? strtoul(argv[1], nullptr, 0) : 64) * 1000000;
+    bool ok = true;
+    for (Mode m : { SINGLE, BULK, SPAN }) {
+        ok &= run(m, 1024, total);
+        ok &= run(m, 1025, total);
+    }
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
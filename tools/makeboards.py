@@ -107,6 +107,8 @@ def BuildProfile(name):
     print("%s.menu.profile.Disabled.build.flags.profile=" % (name))
     print("%s.menu.profile.Enabled=Enabled" % (name))
     print("%s.menu.profile.Enabled.build.flags.profile=-pg -D__PROFILE" % (name))
+    print("%s.menu.profile.Trace=Event Trace" % (name))
+    print("%s.menu.profile.Trace.build.flags.profile=-D__TRACE" % (name))
 
 def BuildRTTI(name):
     print("%s.menu.rtti.Disabled=Disabled" % (name))
@@ -0,0 +1,161 @@
+// Host-side stress test for the cross-core queue (cores/rp2040/MulticoreQueue.h).
+// Build from the top directory with:
+//
+//   g++ -O2 -g -pthread -fsanitize=thread -Itools/hostshim -Icores/rp2040
+//       -o multicorequeuetest tools/multicorequeuetest.cpp
+//
+// (drop -fsanitize for timing) and run:
+//
+//   ./multicorequeuetest [items per producer] [producers] [consumers]
+//
+// It first checks FIFO order, full and empty handling and index wraparound from a
+// single thread, then runs producer and consumer threads mixing single, batched
+// and blocking calls.  Every item must come out exactly once, and the items of
+// each producer must reach any one consumer in the order they were pushed.
+// The PC threads stand in for the two cores and for IRQ context; interrupt
+// masking and WFE/SEV are stubbed by tools/hostshim/hardware/sync.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include "MulticoreQueue.h"
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+static void singleThread() {
+    MulticoreQueue<uint32_t, 8> q(false);
+    uint32_t v;
+    uint32_t buf[8];
+
+    CHECK(q.empty());
+    CHECK(!q.pop_nb(&v));
+    CHECK(q.pop_nb(buf, 8) == 0);
+    CHECK(q.pop_nb(buf, 0) == 0);
+
+    for (uint32_t i = 0; i < 8; i++) {
+        CHECK(q.push_nb(i));
+    }
+    CHECK(q.available() == 8);
+    CHECK(!q.push_nb(99));
+    for (uint32_t i = 0; i < 8; i++) {
+        CHECK(q.pop_nb(&v) && v == i);
+    }
+    CHECK(q.empty());
+
+    // Walk the indices around the ring many times with uneven batches
+    uint32_t in = 0, out = 0;
+    for (int round = 0; round < 10000; round++) {
+        int n = 1 + round % 7;
+        for (int i = 0; i < n && q.push_nb(in); i++) {
+            in++;
+        }
+        size_t got = q.pop_nb(buf, 1 + round % 5);
+        for (size_t i = 0; i < got; i++) {
+            CHECK(buf[i] == out);
+            out++;
+        }
+        CHECK(q.available() == (int)(in - out));
+    }
+    while (q.pop_nb(&v)) {
+        CHECK(v == out);
+        out++;
+    }
+    CHECK(in == out);
+}
+
+// Items carry the producer in the top byte and a per-producer count below it
+static void multiThread(uint32_t items, int producers, int consumers) {
+    static MulticoreQueue<uint32_t, 64> q;
+    std::vector<std::atomic<uint8_t>> seen(producers * items);
+    std::atomic<uint32_t> remaining(producers * items);
+    std::atomic<int> orderErrors(0);
+    std::vector<std::thread> t;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < producers; p++) {
+        t.emplace_back([p, items]() {
+            for (uint32_t i = 0; i < items; i++) {
+                uint32_t v = ((uint32_t)p << 24) | i;
+                if (i & 1) {
+                    q.push(v);
+                } else {
+                    while (!q.push_nb(v)) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        });
+    }
+    for (int c = 0; c < consumers; c++) {
+        t.emplace_back([c, producers, items, &seen, &remaining, &orderErrors]() {
+            std::vector<int64_t> last(producers, -1);
+            uint32_t buf[16];
+            uint32_t n = 0;
+            while (remaining.load() > 0) {
+                size_t got;
+                switch ((c + n++) % 3) {
+                case 0: got = q.pop_nb(buf, 1 + n % 16); break;
+                case 1: got = q.pop_nb(buf) ? 1 : 0; break;
+                // No blocking pop, the other consumers may take the last items
+                default: got = q.pop_nb(buf, 16); break;
+                }
+                for (size_t i = 0; i < got; i++) {
+                    uint32_t p = buf[i] >> 24;
+                    uint32_t idx = buf[i] & 0xffffff;
+                    if ((int)p >= producers || idx >= items) {
+                        orderErrors++;
+                        continue;
+                    }
+                    if ((int64_t)idx <= last[p]) {
+                        orderErrors++;
+                    }
+                    last[p] = idx;
+                    seen[p * items + idx]++;
+                    remaining--;
+                }
+                if (!got) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto &th : t) {
+        th.join();
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int dup = 0, lost = 0;
+    for (auto &s : seen) {
+        dup += s.load() > 1;
+        lost += s.load() == 0;
+    }
+    CHECK(orderErrors.load() == 0);
+    CHECK(dup == 0);
+    CHECK(lost == 0);
+    CHECK(q.empty());
+    printf("%d producers, %d consumers: %u items in %.3fs (%.1f M/s), %d lost, %d duplicated, %d out of order\n",
+           producers, consumers, producers * items, secs, producers * items / secs / 1e6, lost, dup, orderErrors.load());
+}
+
+int main(int argc, char **argv) {
+    uint32_t items = (argc > 1) ? strtoul(argv[1], nullptr, 0) : 200000;
+    int producers = (argc > 2) ? atoi(argv[2]) : 2;
+    int consumers = (argc > 3) ? atoi(argv[3]) : 2;
+    if (items > 0xffffff || producers < 1 || producers > 255 || consumers < 1) {
+        printf("Usage: %s [items per producer < 16M] [producers 1-255] [consumers]\n", argv[0]);
+        return 2;
+    }
+
+    singleThread();
+    multiThread(items, 1, 1);
+    multiThread(items, producers, consumers);
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+# Convert a traceDump() log into Chrome Trace Event JSON, viewable in
+# chrome://tracing or https://ui.perfetto.dev
+#
+# Lines not part of the dump (other serial output) are ignored.
+
+import sys
+import json
+import argparse
+
+# Keep in sync with cores/rp2040/Trace.h
+TRACE_IRQ_ENTER = 1
+TRACE_IRQ_EXIT = 2
+TRACE_MUTEX_WAIT = 3
+TRACE_MUTEX_ACQUIRE = 4
+TRACE_MUTEX_RELEASE = 5
+TRACE_LWIP_ENTER = 6
+TRACE_LWIP_EXIT = 7
+TRACE_USB_TASK_ENTER = 8
+TRACE_USB_TASK_EXIT = 9
+TRACE_DMA_DONE = 10
+TRACE_USER = 0x100
+
+def parse(lines):
+    hz = 0
+    recs = {}
+    for l in lines:
+        l = l.strip()
+        if l.startswith("# TRACE"):
+            for f in l.split()[3:]:
+                k, v = f.split("=")
+                if k == "hz":
+                    hz = int(v)
+        elif l.startswith("T "):
+            f = l.split()
+            if len(f) != 6:
+                continue
+            core = int(f[1])
+            recs.setdefault(core, []).append((int(f[2]), int(f[3]), int(f[4]), int(f[5], 16)))
+    return hz, recs
+
+def timestamps(hz, recs):
+    # The microsecond timer is shared by both cores so is used to place
+    # events, the per-core cycle counter refines the gaps between them
+    ts = []
+    prev = None
+    base = 0
+    for us, cycles, _, _ in recs:
+        if prev is not None and us < prev[0]:
+            base += 1 << 32  # Microsecond timer wrapped
+        t = float(base + us)
+        if hz and prev is not None:
+            fine = prev[2] + ((cycles - prev[1]) & 0xffffffff) * 1e6 / hz
+            if abs(fine - t) < 1.0:
+                t = fine
+        prev = (us, cycles, t)
+        ts.append(t)
+    return ts
+
+def convert(hz, recs):
+    events = []
+    for core in sorted(recs):
+        events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": core, "args": {"name": "Core %d" % core}})
+        stack = []
+        waiting = set()
+        for t, (us, cycles, ev, arg) in zip(timestamps(hz, recs[core]), recs[core]):
+            e = {"pid": 0, "tid": core, "ts": t}
+            if ev in (TRACE_IRQ_ENTER, TRACE_LWIP_ENTER, TRACE_USB_TASK_ENTER):
+                if ev == TRACE_IRQ_ENTER:
+                    name = "IRQ %d" % arg
+                elif ev == TRACE_LWIP_ENTER:
+                    name = "lwIP"
+                else:
+                    name = "tud_task"
+                stack.append(ev + 1)
+                e.update({"name": name, "cat": "core", "ph": "B", "args": {"arg": "0x%08x" % arg}})
+            elif ev in (TRACE_IRQ_EXIT, TRACE_LWIP_EXIT, TRACE_USB_TASK_EXIT):
+                # The oldest records may have been overwritten, drop unmatched ends
+                if not stack or stack[-1] != ev:
+                    continue
+                stack.pop()
+                e.update({"ph": "E"})
+            elif ev == TRACE_MUTEX_WAIT:
+                waiting.add(arg)
+                e.update({"name": "wait 0x%08x" % arg, "cat": "mutex", "ph": "b", "id": "w%d-%x" % (core, arg)})
+            elif ev == TRACE_MUTEX_ACQUIRE:
+                if arg in waiting:
+                    waiting.discard(arg)
+                    events.append({"pid": 0, "tid": core, "ts": t, "name": "wait 0x%08x" % arg, "cat": "mutex", "ph": "e", "id": "w%d-%x" % (core, arg)})
+                e.update({"name": "hold 0x%08x" % arg, "cat": "mutex", "ph": "b", "id": "h%x" % arg})
+            elif ev == TRACE_MUTEX_RELEASE:
+                e.update({"name": "hold 0x%08x" % arg, "cat": "mutex", "ph": "e", "id": "h%x" % arg})
+            elif ev == TRACE_DMA_DONE:
+                e.update({"name": "DMA %d done" % arg, "cat": "core", "ph": "i", "s": "t"})
+            elif ev >= TRACE_USER:
+                e.update({"name": "user %d" % (ev - TRACE_USER), "cat": "user", "ph": "i", "s": "t", "args": {"arg": "0x%08x" % arg}})
+            else:
+                e.update({"name": "event %d" % ev, "ph": "i", "s": "t", "args": {"arg": "0x%08x" % arg}})
+            events.append(e)
+    return {"traceEvents": events, "displayTimeUnit": "ns"}
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert traceDump() output to Chrome Trace/Perfetto JSON')
+    parser.add_argument('-i', '--input', action='store', help='Captured log (default stdin)')
+    parser.add_argument('-o', '--out', action='store', help='JSON output (default stdout)')
+    args = parser.parse_args()
+
+    fin = open(args.input, "r", errors="replace") if args.input else sys.stdin
+    hz, recs = parse(fin)
+    out = convert(hz, recs)
+    if args.out:
+        with open(args.out, "w") as fout:
+            json.dump(out, fout)
+    else:
+        json.dump(out, sys.stdout)
+
+main()
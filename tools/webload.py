@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+# HTTP load generator for WebServer, run from a PC on the same network.
+# Each client keeps one keep-alive connection open and issues requests
+# back-to-back, reconnecting whenever the server closes the connection.
+#
+#   webload.py 192.168.1.50 --path / --clients 1 8 32 --seconds 10
+#
+# Prints requests/second and the median, 99th percentile, and worst latency
+# for each client count.
+
+import sys
+import time
+import asyncio
+import argparse
+
+async def request(reader, writer, req):
+    writer.write(req)
+    await writer.drain()
+    length = None
+    close = False
+    status = await reader.readline()
+    if not status:
+        raise ConnectionError("closed")
+    while True:
+        l = await reader.readline()
+        if not l:
+            raise ConnectionError("closed")
+        if l in (b"\r\n", b"\n"):
+            break
+        name, _, value = l.decode("latin-1").partition(":")
+        name = name.strip().lower()
+        value = value.strip().lower()
+        if name == "content-length":
+            length = int(value)
+        elif name == "connection":
+            close = value == "close"
+    if length is None:
+        await reader.read()  # Body runs until the close
+        close = True
+    else:
+        await reader.readexactly(length)
+    return status.split()[1], close
+
+async def client(args, deadline, lat, errors):
+    req = ("GET %s HTTP/1.1\r\nHost: %s\r\n\r\n" % (args.path, args.host)).encode()
+    conn = None
+    while time.monotonic() < deadline:
+        try:
+            if not conn:
+                conn = await asyncio.wait_for(asyncio.open_connection(args.host, args.port), args.timeout)
+            start = time.monotonic()
+            code, close = await asyncio.wait_for(request(conn[0], conn[1], req), args.timeout)
+            lat.append(time.monotonic() - start)
+            if code != b"200":
+                errors[0] += 1
+            if close:
+                conn[1].close()
+                conn = None
+        except (OSError, ConnectionError, asyncio.TimeoutError, asyncio.IncompleteReadError):
+            errors[0] += 1
+            if conn:
+                conn[1].close()
+            conn = None
+            await asyncio.sleep(0.1)
+    if conn:
+        conn[1].close()
+
+async def run(args, n):
+    lat = []
+    errors = [0]
+    start = time.monotonic()
+    deadline = start + args.seconds
+    await asyncio.gather(*[client(args, deadline, lat, errors) for i in range(n)])
+    elapsed = time.monotonic() - start
+    lat.sort()
+    def pct(p):
+        return lat[min(len(lat) - 1, int(len(lat) * p))] * 1000.0 if lat else 0.0
+    print("%7d %10.1f %9.1f %9.1f %9.1f %7d" % (n, len(lat) / elapsed, pct(0.50), pct(0.99), pct(1.0), errors[0]))
+
+def main():
+    parser = argparse.ArgumentParser(description="Measure WebServer throughput and latency")
+    parser.add_argument("host")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--path", default="/")
+    parser.add_argument("--clients", type=int, nargs="+", default=[1, 8, 32])
+    parser.add_argument("--seconds", type=float, default=10)
+    parser.add_argument("--timeout", type=float, default=10, help="Seconds before a request counts as failed")
+    args = parser.parse_args()
+    print("%7s %10s %9s %9s %9s %7s" % ("Clients", "Req/s", "p50 ms", "p99 ms", "Max ms", "Errors"))
+    for n in args.clients:
+        asyncio.run(run(args, n))
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,250 @@
+// Host-side fuzz and benchmark harness for the WebServer request parser
+// (libraries/WebServer/src/detail/RequestParser.cpp).  Build from the top
+// directory with:
+//
+//   g++ -O2 -g -fsanitize=address,undefined -Ilibraries/WebServer/src/detail
+//       -Ilibraries/http-parser/lib/http-parser -o webparsebench tools/webparsebench.cpp
+//       libraries/WebServer/src/detail/RequestParser.cpp libraries/http-parser/lib/http-parser/http_parser.c
+//
+// (drop -fsanitize for benchmarking) and run:
+//
+//   ./webparsebench fuzz [iterations] [seed] [request files...]
+//   ./webparsebench bench [iterations] [request files...]
+//
+// Request files are raw captures, e.g. from "nc -l 8080 > req.txt" and a browser.
+// Without any, a built-in set of recorded requests is used.  "fuzz" checks that
+// random splits of each request parse exactly like the whole request, and that
+// randomly corrupted requests never crash or leave views outside the arena.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "RequestParser.h"
+
+static const char *corpus[] = {
+    // Chrome
+    "GET /status?id=3&fmt=json HTTP/1.1\r\n"
+    "Host: 192.168.1.50\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/126.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,image/apng,*/*;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Accept-Language: en-US,en;q=0.9\r\n"
+    "Cookie: session=8f3a0c1d2e; theme=dark\r\n"
+    "\r\n",
+    // Firefox
+    "GET /favicon.ico HTTP/1.1\r\n"
+    "Host: picow.local\r\n"
+    "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64; rv:127.0) Gecko/20100101 Firefox/127.0\r\n"
+    "Accept: image/avif,image/webp,*/*\r\n"
+    "Accept-Language: en-US,en;q=0.5\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Connection: keep-alive\r\n"
+    "Referer: http://picow.local/\r\n"
+    "\r\n",
+    // curl
+    "GET /inline?a=1&b=h%C3%A9llo+world&c=&noval HTTP/1.1\r\n"
+    "Host: 10.0.0.2\r\n"
+    "User-Agent: curl/8.5.0\r\n"
+    "Accept: */*\r\n"
+    "\r\n",
+    // HTML form
+    "POST /settings HTTP/1.1\r\n"
+    "Host: 192.168.1.50\r\n"
+    "Content-Type: application/x-www-form-urlencoded\r\n"
+    "Content-Length: 27\r\n"
+    "Origin: http://192.168.1.50\r\n"
+    "\r\n"
+    "ssid=home&pass=p%40ss+word1",
+    // JSON API
+    "PUT /api/led HTTP/1.1\r\n"
+    "Host: 192.168.1.50\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 15\r\n"
+    "Authorization: Basic YWRtaW46YWRtaW4=\r\n"
+    "\r\n"
+    "{\"state\":\"on\"}\n",
+    // File upload, only the headers are parsed here
+    "POST /upload HTTP/1.1\r\n"
+    "Host: 192.168.1.50\r\n"
+    "Content-Type: multipart/form-data; boundary=----WebKitFormBoundary7MA4YWxkTrZu0gW\r\n"
+    "Content-Length: 190\r\n"
+    "\r\n"
+    "------WebKitFormBoundary7MA4YWxkTrZu0gW\r\n"
+    "Content-Disposition: form-data; name=\"file\"; filename=\"a.txt\"\r\n"
+    "Content-Type: text/plain\r\n\r\nhello\r\n"
+    "------WebKitFormBoundary7MA4YWxkTrZu0gW--\r\n",
+    // WebSocket upgrade
+    "GET /ws HTTP/1.1\r\n"
+    "Host: 192.168.1.50\r\n"
+    "Upgrade: websocket\r\n"
+    "Connection: Upgrade\r\n"
+    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+    "Sec-WebSocket-Version: 13\r\n"
+    "\r\n",
+    // HTTP/1.0, bare LF line ends, stray empty line first
+    "\r\nGET /old HTTP/1.0\nHost: x\nX-Empty:\nX-Trailing: v   \n\n",
+};
+
+typedef struct {
+    std::string path, query;
+    std::vector<std::string> headers;
+    int state;
+    size_t used;
+    bool keepAlive;
+    unsigned long long contentLength;
+} Result;
+
+// Feeds data in pieces of at most split bytes (0 = all at once), like WebServer does
+static Result parse(RequestParser &r, const std::string &data, size_t split) {
+    Result res;
+    r.begin();
+    size_t pos = 0;
+    while ((r.state() == RequestParser::NEED_MORE) && (pos < data.size())) {
+        size_t n = split ? std::min(split, data.size() - pos) : data.size() - pos;
+        size_t u = r.feed(data.data() + pos, n);
+        pos += u;
+        if (!u && (r.state() == RequestParser::NEED_MORE) && !r.requestLine()) {
+            fprintf(stderr, "No progress at %zu\n", pos);
+            abort();
+        }
+    }
+    res.state = r.state();
+    res.used = pos;
+    if (r.state() == RequestParser::DONE) {
+        res.path = r.str(r.path());
+        res.query = r.str(r.query());
+        for (int i = 0; i < r.headers(); i++) {
+            RequestParser::View n = r.headerName(i);
+            RequestParser::View v = r.headerValue(i);
+            if ((n.off + n.len >= r.used()) || (v.off + v.len >= r.used()) || r.str(n)[n.len] || r.str(v)[v.len]) {
+                fprintf(stderr, "Bad view for header %d\n", i);
+                abort();
+            }
+            res.headers.push_back(std::string(r.str(n), n.len) + ": " + std::string(r.str(v), v.len));
+        }
+        res.keepAlive = r.keepAlive();
+        res.contentLength = r.contentLength();
+        // Exercise the argument decoder
+        RequestParser::Arg a;
+        const char *cursor = r.str(r.query());
+        while (RequestParser::nextArg(cursor, a)) {
+            std::vector<char> buf(a.valueLen + 1);
+            size_t len = RequestParser::urlDecode(a.value, a.valueLen, buf.data());
+            if (!RequestParser::urlDecodedEquals(a.value, a.valueLen, buf.data(), len)) {
+                fprintf(stderr, "urlDecodedEquals mismatch\n");
+                abort();
+            }
+        }
+    }
+    return res;
+}
+
+static bool same(const Result &a, const Result &b) {
+    return (a.state == b.state) && (a.path == b.path) && (a.query == b.query) && (a.headers == b.headers) &&
+           (a.keepAlive == b.keepAlive) && (a.contentLength == b.contentLength) &&
+           ((a.state != RequestParser::DONE) || (a.used == b.used));
+}
+
+static std::vector<std::string> load(int argc, char **argv, int first) {
+    std::vector<std::string> reqs;
+    for (int i = first; i < argc; i++) {
+        FILE *f = fopen(argv[i], "rb");
+        if (!f) {
+            perror(argv[i]);
+            exit(1);
+        }
+        std::string s;
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+            s.append(buf, n);
+        }
+        fclose(f);
+        reqs.push_back(s);
+    }
+    if (reqs.empty()) {
+        for (auto c : corpus) {
+            reqs.push_back(c);
+        }
+    }
+    return reqs;
+}
+
+static int fuzz(long iterations, unsigned seed, const std::vector<std::string> &reqs) {
+    srand(seed);
+    RequestParser r;
+    long fails = 0;
+    for (size_t i = 0; i < reqs.size(); i++) {
+        Result whole = parse(r, reqs[i], 0);
+        if (whole.state != RequestParser::DONE) {
+            printf("Request %zu does not parse (state %d)\n", i, whole.state);
+            fails++;
+        }
+        for (size_t split = 1; split < 64; split++) {
+            if (!same(whole, parse(r, reqs[i], split))) {
+                printf("Request %zu parses differently with %zu byte pieces\n", i, split);
+                fails++;
+            }
+        }
+    }
+    for (long it = 0; it < iterations; it++) {
+        std::string s = reqs[rand() % reqs.size()];
+        int edits = 1 + rand() % 8;
+        for (int e = 0; e < edits && !s.empty(); e++) {
+            size_t pos = rand() % s.size();
+            switch (rand() % 4) {
+            case 0: s[pos] = rand(); break;
+            case 1: s.erase(pos, 1 + rand() % 16); break;
+            case 2: s.insert(pos, std::string(1 + rand() % 64, "a:\r\n %?&="[rand() % 9])); break;
+            case 3: s.resize(pos); break;
+            }
+        }
+        Result whole = parse(r, s, 0);
+        Result split = parse(r, s, 1 + rand() % 32);
+        if (!same(whole, split)) {
+            printf("Iteration %ld: a split changed the result\n", it);
+            fails++;
+        }
+    }
+    printf("%ld iterations, %ld failures\n", iterations, fails);
+    return fails ? 1 : 0;
+}
+
+static int bench(long iterations, const std::vector<std::string> &reqs) {
+    RequestParser r;
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long it = 0; it < iterations; it++) {
+        for (auto &s : reqs) {
+            size_t pos = 0;
+            r.begin();
+            while ((r.state() == RequestParser::NEED_MORE) && (pos < s.size())) {
+                pos += r.feed(s.data() + pos, s.size() - pos);
+            }
+            bytes += pos;
+        }
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double n = (double)iterations * reqs.size();
+    printf("%.0f requests, %.1f ns/request, %.1f MB/s\n", n, sec * 1e9 / n, bytes / sec / 1e6);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if ((argc >= 2) && !strcmp(argv[1], "fuzz")) {
+        long iterations = (argc >= 3) ? atol(argv[2]) : 100000;
+        unsigned seed = (argc >= 4) ? atoi(argv[3]) : 1;
+        return fuzz(iterations, seed, load(argc, argv, 4));
+    } else if ((argc >= 2) && !strcmp(argv[1], "bench")) {
+        long iterations = (argc >= 3) ? atol(argv[2]) : 100000;
+        return bench(iterations, load(argc, argv, 3));
+    }
+    fprintf(stderr, "Usage: %s fuzz [iterations] [seed] [files...] | bench [iterations] [files...]\n", argv[0]);
+    return 1;
+}
@@ -0,0 +1,190 @@
+// Host-side check and benchmark for the WebServer routing index
+// (libraries/WebServer/src/detail/RouteTrie.cpp).  Build from the top
+// directory with:
+//
+//   g++ -O2 -g -Ilibraries/WebServer/src/detail -o webroutebench
+//       tools/webroutebench.cpp libraries/WebServer/src/detail/RouteTrie.cpp
+//
+// and run:
+//
+//   ./webroutebench [iterations]
+//
+// It registers a REST-style API of 100+ routes, checks that the index picks the
+// same handler and path arguments as the old linear scan of every handler for a
+// mix of hits and misses, and times both.  The linear scan copies the URI into
+// each handler like RequestHandler::canHandle(..., String uri) does.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "RouteTrie.h"
+
+// Same values as http_parser's enum http_method
+enum { DELETE = 0, GET = 1, HEAD = 2, POST = 3, PUT = 4, OPTIONS = 6, PATCH = 28, ANY = 255 };
+
+typedef struct {
+    std::string uri;
+    int method;
+    bool braces;
+} Route;
+
+// UriBraces::canHandle, on std::string
+static bool bracesMatch(const std::string &pattern, std::string requestUri, std::vector<std::string> &args) {
+    args.clear();
+    if (pattern == requestUri) {
+        return true;
+    }
+    size_t requestUriIndex = 0;
+    for (size_t i = 0; i < pattern.size(); i++, requestUriIndex++) {
+        char requestUriChar = (requestUriIndex < requestUri.size()) ? requestUri[requestUriIndex] : 0;
+        if (pattern[i] == requestUriChar) {
+            continue;
+        }
+        if (pattern[i] != '{') {
+            return false;
+        }
+        i += 2;
+        if (i >= pattern.size()) {
+            args.push_back(requestUri.substr(requestUriIndex));
+            return args.back().find('/') == std::string::npos;
+        }
+        size_t end = requestUri.find(pattern[i], requestUriIndex);
+        if (end == std::string::npos) {
+            return false;
+        }
+        args.push_back(requestUri.substr(requestUriIndex, end - requestUriIndex));
+        requestUriIndex = end;
+    }
+    return requestUriIndex >= requestUri.size();
+}
+
+static int linearLookup(const std::vector<Route> &routes, int method, const std::string &uri, std::vector<std::string> &args) {
+    for (size_t i = 0; i < routes.size(); i++) {
+        if ((routes[i].method != ANY) && (routes[i].method != method)) {
+            continue;
+        }
+        if (routes[i].braces ? bracesMatch(routes[i].uri, uri, args) : (routes[i].uri == uri)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int trieLookup(const RouteTrie &trie, int method, const std::string &uri, std::vector<std::string> &args) {
+    RouteTrie::Match m[ROUTE_MAX_MATCHES];
+    int n = trie.match(uri.data(), uri.size(), method, m, ROUTE_MAX_MATCHES);
+    if (n <= 0) {
+        return -1;
+    }
+    args.clear();
+    for (int i = 0; i < m[0].count; i++) {
+        args.push_back(uri.substr(m[0].caps[i].off, m[0].caps[i].len));
+    }
+    return m[0].id;
+}
+
+static std::vector<Route> makeRoutes() {
+    static const char *resources[] = {
+        "users", "groups", "devices", "sensors", "relays", "schedules", "scenes", "zones",
+        "alarms", "logs", "firmware", "network", "certs", "files", "jobs", "metrics",
+    };
+    std::vector<Route> routes;
+    routes.push_back({ "/", GET, false });
+    routes.push_back({ "/index.html", GET, false });
+    routes.push_back({ "/status", GET, false });
+    routes.push_back({ "/reboot", POST, false });
+    for (auto r : resources) {
+        std::string base = std::string("/api/v1/") + r;
+        routes.push_back({ base, GET, false });
+        routes.push_back({ base, POST, false });
+        routes.push_back({ base + "/{}", GET, true });
+        routes.push_back({ base + "/{}", PUT, true });
+        routes.push_back({ base + "/{}", DELETE, true });
+        routes.push_back({ base + "/{}/history/{}", GET, true });
+        routes.push_back({ base + "/search", ANY, false });
+    }
+    routes.push_back({ "/api/v1/users/me", GET, false }); // Shadowed by /api/v1/users/{}
+    routes.push_back({ "/api/v2/{}/{}/{}", ANY, true });
+    routes.push_back({ "/api/v2/{}/{}/", GET, true });
+    return routes;
+}
+
+static std::vector<std::pair<int, std::string>> makeRequests(const std::vector<Route> &routes) {
+    std::vector<std::pair<int, std::string>> reqs;
+    srand(1);
+    for (auto &r : routes) {
+        std::string uri;
+        for (size_t i = 0; i < r.uri.size(); i++) {
+            if (r.braces && (r.uri[i] == '{')) {
+                uri += std::to_string(rand() % 1000);
+                i++;
+            } else {
+                uri += r.uri[i];
+            }
+        }
+        int method = (r.method == ANY) ? PATCH : r.method;
+        reqs.push_back({ method, uri });
+        reqs.push_back({ OPTIONS, uri });   // Wrong method
+        reqs.push_back({ method, uri + "/" });
+        reqs.push_back({ method, uri + "x" });
+    }
+    reqs.push_back({ GET, "" });
+    reqs.push_back({ GET, "/api/v1/users/" });
+    reqs.push_back({ GET, "/api/v1/users//history/" });
+    reqs.push_back({ GET, "/api/v1/users/a/b" });
+    reqs.push_back({ GET, "/nothing/here" });
+    reqs.push_back({ GET, "/api/v2///" });
+    return reqs;
+}
+
+int main(int argc, char **argv) {
+    long iterations = (argc >= 2) ? atol(argv[1]) : 2000;
+    std::vector<Route> routes = makeRoutes();
+    std::vector<std::pair<int, std::string>> reqs = makeRequests(routes);
+
+    RouteTrie trie;
+    for (size_t i = 0; i < routes.size(); i++) {
+        uint64_t methods = (routes[i].method == ANY) ? ~0ULL : (1ULL << routes[i].method);
+        if (!trie.add(routes[i].uri.c_str(), routes[i].braces, methods, i)) {
+            printf("Route %s can't be indexed\n", routes[i].uri.c_str());
+            return 1;
+        }
+    }
+
+    int fails = 0;
+    int hits = 0;
+    for (auto &r : reqs) {
+        std::vector<std::string> la, ta;
+        int l = linearLookup(routes, r.first, r.second, la);
+        int t = trieLookup(trie, r.first, r.second, ta);
+        if ((l != t) || ((l >= 0) && (la != ta))) {
+            printf("Mismatch for %d %s: linear %d, index %d\n", r.first, r.second.c_str(), l, t);
+            fails++;
+        }
+        hits += (l >= 0);
+    }
+    printf("%zu routes, %zu requests (%d hits), %d mismatches\n", routes.size(), reqs.size(), hits, fails);
+
+    int sink = 0;
+    std::vector<std::string> args;
+    auto start = std::chrono::steady_clock::now();
+    for (long it = 0; it < iterations; it++) {
+        for (auto &r : reqs) {
+            sink += linearLookup(routes, r.first, r.second, args);
+        }
+    }
+    double linear = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (long it = 0; it < iterations; it++) {
+        for (auto &r : reqs) {
+            sink += trieLookup(trie, r.first, r.second, args);
+        }
+    }
+    double index = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double n = (double)iterations * reqs.size();
+    printf("Linear scan: %.1f ns/lookup\nRoute index: %.1f ns/lookup (%d)\n", linear * 1e9 / n, index * 1e9 / n, sink & 1);
+    return fails ? 1 : 0;
+}